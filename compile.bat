@@ -1,4 +1,4 @@
 @echo off
 if not exist build mkdir build
-g++ -std=c++17 -I src src/Main.cpp src/parser/AST.cpp src/parser/Tokenizer.cpp src/parser/SQLParser.cpp src/storage/StorageManager.cpp src/query/QueryExecutor.cpp src/utils/Print.cpp -o build/featherdb.exe
+g++ -std=c++17 -pthread -I src src/Main.cpp src/parser/AST.cpp src/parser/Tokenizer.cpp src/parser/SQLParser.cpp src/storage/StorageManager.cpp src/storage/HeapFile.cpp src/storage/Page.cpp src/storage/BufferPool.cpp src/query/QueryExecutor.cpp src/query/Operators.cpp src/query/BoundPredicate.cpp src/query/RowSorter.cpp src/query/ExternalSorter.cpp src/query/RowFile.cpp src/query/HashJoinOperator.cpp src/query/HashAggregateOperator.cpp src/query/ParallelScanOperator.cpp src/query/PlanCache.cpp src/query/ResultCache.cpp src/query/CostModel.cpp src/storage/TableCursor.cpp src/storage/ColumnStore.cpp src/storage/BPlusTree.cpp src/storage/LogManager.cpp src/storage/Compactor.cpp src/storage/TableWriter.cpp src/storage/BulkLoader.cpp src/storage/ZoneMap.cpp src/storage/Catalog.cpp src/storage/TableStats.cpp src/utils/Print.cpp src/utils/Validators.cpp src/utils/SimdFilter.cpp src/utils/TaskScheduler.cpp src/utils/HyperLogLog.cpp -o build/featherdb.exe
 echo Build complete. Executable in build/featherdb.exe
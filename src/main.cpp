@@ -1,17 +1,69 @@
 #include "parser/Tokenizer.h"
 #include "parser/SQLParser.h"
 #include "query/QueryExecutor.h"
+#include "query/ExternalSorter.h"
+#include "query/HashJoinOperator.h"
+#include "query/HashAggregateOperator.h"
+#include "query/ResultCache.h"
+#include "query/RowFile.h"
 #include "storage/StorageManager.h"
+#include "storage/BufferPool.h"
+#include "storage/LogManager.h"
+#include "storage/Compactor.h"
+#include "storage/Catalog.h"
 #include "utils/Print.h"
+#include "utils/SimdFilter.h"
+#include "utils/TaskScheduler.h"
+#include <set>
 
 #define version "1.0.1"
 
 using namespace spl;
 
+// Whether `value` is a valid number for the .set knob `name`: vacuum_threshold
+// takes a decimal fraction, the other numeric knobs a count of at most nine
+// digits (so the MB to bytes conversions cannot overflow). Knobs that take
+// words, and unknown names, are left to the usage message.
+static bool validSetting(const std::string &name, const std::string &value)
+{
+    static const std::set<std::string> counts = {"buffer_pool_mb", "group_commit_ms", "checkpoint_mb",
+                                                  "sort_memory_mb", "join_memory_mb", "agg_memory_mb",
+                                                  "result_cache_mb", "workers"};
+    if (name == "vacuum_threshold")
+    {
+        size_t dot = value.find('.');
+        return value.find_first_not_of("0123456789.") == std::string::npos && value != "." &&
+               (dot == std::string::npos || value.find('.', dot + 1) == std::string::npos);
+    }
+    return !counts.count(name) ||
+           (value.size() <= 9 && value.find_first_not_of("0123456789") == std::string::npos);
+}
+
 int main()
 {
     printIntro((char *)version);
 
+    if (!Catalog::instance().load())
+    {
+        std::cout << "Error: could not read db/catalog.manifest.\n";
+        return 1;
+    }
+
+    int recovered = StorageManager::recover();
+    if (recovered > 0)
+    {
+        std::cout << "Recovered " << recovered << " transaction(s) from the write-ahead log.\n";
+    }
+
+    int converted = StorageManager::convertLegacyTables();
+    if (converted > 0)
+    {
+        std::cout << "Converted " << converted << " table(s) from CSV to the page format.\n";
+    }
+    StorageManager::buildMissingZoneMaps();
+    removeTempRowFiles();
+    Compactor::instance().start();
+
     std::string input;
     while (true)
     {
@@ -25,6 +77,7 @@ int main()
         {
             if (input == ".exit")
             {
+                StorageManager::shutdown();
                 break;
             }
             else if (input == ".help")
@@ -65,10 +118,97 @@ int main()
                             if (i < t.columns.size() - 1)
                                 std::cout << ", ";
                         }
-                        std::cout << ")\n";
+                        std::cout << ")";
+                        if (t.format == TableFormat::COLUMNAR)
+                            std::cout << " USING COLUMNAR";
+                        std::cout << "\n";
                     }
                 }
             }
+            else if (input.rfind(".set", 0) == 0)
+            {
+                std::stringstream ss(input);
+                std::string cmd, name, value;
+                ss >> cmd >> name >> value;
+                if (!value.empty() && !validSetting(name, value))
+                {
+                    std::cout << "Error: Invalid value '" << value << "' for " << name << ".\n";
+                }
+                else if (name == "buffer_pool_mb" && !value.empty())
+                {
+                    size_t pages = std::stoul(value) * 1024 * 1024 / PAGE_SIZE;
+                    if (BufferPool::instance().setCapacity(pages))
+                        std::cout << "Buffer pool set to " << BufferPool::instance().capacity() << " pages.\n";
+                    else
+                        std::cout << "Buffer pool is busy, try again.\n";
+                }
+                else if (name == "fsync" && (value == "always" || value == "group" || value == "off"))
+                {
+                    LogManager::instance().setFsyncPolicy(value == "always"  ? FsyncPolicy::ALWAYS
+                                                          : value == "group" ? FsyncPolicy::GROUP
+                                                                             : FsyncPolicy::OFF);
+                    std::cout << "fsync set to " << value << ".\n";
+                }
+                else if (name == "group_commit_ms" && !value.empty())
+                {
+                    LogManager::instance().setGroupCommitWindow(std::stoul(value));
+                    std::cout << "Group commit window set to " << value << " ms.\n";
+                }
+                else if (name == "checkpoint_mb" && !value.empty())
+                {
+                    LogManager::instance().setCheckpointBytes(std::stoull(value) * 1024 * 1024);
+                    std::cout << "Checkpoint every " << value << " MB of log.\n";
+                }
+                else if (name == "vacuum_threshold" && !value.empty())
+                {
+                    Compactor::instance().setThreshold(std::stod(value));
+                    std::cout << "Tables are vacuumed once " << value << " of their rows are dead (0 = never).\n";
+                }
+                else if (name == "sort_memory_mb" && !value.empty())
+                {
+                    ExternalSorter::setMemoryBudget(std::stoull(value) * 1024 * 1024);
+                    std::cout << "ORDER BY spills to disk past " << value << " MB.\n";
+                }
+                else if (name == "join_memory_mb" && !value.empty())
+                {
+                    HashJoinOperator::setMemoryBudget(std::stoull(value) * 1024 * 1024);
+                    std::cout << "Hash joins partition to disk past " << value << " MB.\n";
+                }
+                else if (name == "agg_memory_mb" && !value.empty())
+                {
+                    HashAggregateOperator::setMemoryBudget(std::stoull(value) * 1024 * 1024);
+                    std::cout << "GROUP BY spills to disk past " << value << " MB.\n";
+                }
+                else if (name == "result_cache_mb" && !value.empty())
+                {
+                    ResultCache::instance().setCapacity(std::stoull(value) * 1024 * 1024);
+                    if (ResultCache::instance().enabled())
+                        std::cout << "SELECT results are cached up to " << value << " MB.\n";
+                    else
+                        std::cout << "Result cache is off.\n";
+                }
+                else if (name == "workers" && !value.empty() && std::stoull(value) > 0)
+                {
+                    TaskScheduler::instance().setWorkers(std::stoull(value));
+                    std::cout << "Parallel work runs on " << value << " worker threads.\n";
+                }
+                else if (name == "simd" && (value == "auto" || value == "off"))
+                {
+                    std::cout << "Filter kernels: " << SimdFilter::setEnabled(value == "auto") << ".\n";
+                }
+                else
+                {
+                    std::cout << "Usage: .set buffer_pool_mb <n> | fsync always|group|off | group_commit_ms <n> | checkpoint_mb <n> | vacuum_threshold <f> | sort_memory_mb <n> | join_memory_mb <n> | agg_memory_mb <n> | result_cache_mb <n> | workers <n> | simd auto|off\n";
+                }
+            }
+            else if (input == ".bufferpool")
+            {
+                BufferPool::Stats st = BufferPool::instance().stats();
+                std::cout << "capacity: " << BufferPool::instance().capacity() << " pages, resident: "
+                          << BufferPool::instance().residentPages() << "\n";
+                std::cout << "hits: " << st.hits << ", misses: " << st.misses
+                          << ", evictions: " << st.evictions << ", page writes: " << st.writes << "\n";
+            }
             else
             {
                 std::cout << "Unknown command: " << input << "\n";
@@ -83,6 +223,7 @@ int main()
             SQLParser parser(tokenizer);
             std::unique_ptr<AST> ast = parser.parse();
 
+            std::lock_guard<std::mutex> lock(StorageManager::statementLock());
             QueryExecutor executor;
             executor.execute(std::move(ast));
         }
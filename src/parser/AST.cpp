@@ -1,10 +1,63 @@
 #include "AST.h"
 
+std::string quoteString(const std::string &value)
+{
+    std::string ret = "'";
+    for (char c : value)
+        ret += c == '\'' ? "''" : std::string(1, c);
+    return ret + "'";
+}
+
+static std::string textOf(const AST &ast, bool key)
+{
+    auto *select = dynamic_cast<const SelectStatement *>(&ast);
+    return key && select ? select->cacheKey() : ast.toString();
+}
+
+std::string Expr::text(bool key) const
+{
+    switch (kind)
+    {
+    case Kind::COMPARE:
+        if (key && quoted)
+            return column + " " + op + " " + quoteString(value);
+        return column + " " + op + " " + (quoted ? "'" + value + "'" : value);
+    case Kind::IN:
+    {
+        std::string ret = column + " IN (";
+        if (subquery)
+            return ret + textOf(*subquery, key) + ")";
+        for (size_t i = 0; i < values.size(); ++i)
+            ret += (key ? quoteString(values[i]) : values[i]) + (i != values.size() - 1 ? ", " : "");
+        return ret + ")";
+    }
+    case Kind::EXISTS:
+        return "EXISTS (" + textOf(*subquery, key) + ")";
+    case Kind::AND:
+    case Kind::OR:
+    {
+        // AND binds tighter, so only an OR below an AND needs parentheses
+        std::string ret;
+        for (size_t i = 0; i < children.size(); ++i)
+        {
+            bool wrap = kind == Kind::AND && children[i]->kind == Kind::OR;
+            if (i > 0)
+                ret += kind == Kind::AND ? " AND " : " OR ";
+            ret += wrap ? "(" + children[i]->text(key) + ")" : children[i]->text(key);
+        }
+        return ret;
+    }
+    case Kind::NOT:
+        return "NOT (" + children[0]->text(key) + ")";
+    }
+    return "";
+}
+
 SelectStatement::SelectStatement(const std::vector<std::string> &cols, const std::string &tbl,
-                                 const std::string &cond, std::unique_ptr<AST> nested, const std::string &order)
-    : AST("SELECT"), columns(cols), table(tbl), condition(cond), nestedFrom(std::move(nested)), orderBy(order) {}
+                                 std::unique_ptr<Expr> where, std::unique_ptr<AST> nested, const std::vector<OrderByItem> &order)
+    : AST("SELECT"), columns(cols), table(tbl), where(std::move(where)), nestedFrom(std::move(nested)), orderBy(order) {}
 
-std::string SelectStatement::toString() const
+std::string SelectStatement::text(bool key) const
 {
     std::ostringstream oss;
     oss << "SELECT ";
@@ -14,21 +67,42 @@ std::string SelectStatement::toString() const
     }
     oss << " FROM ";
     if (nestedFrom)
-        oss << "(" << nestedFrom->toString() << ")";
+        oss << "(" << textOf(*nestedFrom, key) << ")";
     else
         oss << table;
+    if (!alias.empty())
+        oss << " " << alias;
+    for (const auto &join : joins)
+    {
+        oss << (join.left ? " LEFT JOIN " : " JOIN ") << join.table;
+        if (!join.alias.empty())
+            oss << " " << join.alias;
+        for (size_t i = 0; i < join.on.size(); ++i)
+            oss << (i == 0 ? " ON " : " AND ") << join.on[i].first << " = " << join.on[i].second;
+    }
 
-    if (!condition.empty())
-        oss << " WHERE " << condition;
+    if (where)
+        oss << " WHERE " << (key ? where->key() : where->toString());
+    for (size_t i = 0; i < groupBy.size(); ++i)
+        oss << (i == 0 ? " GROUP BY " : ", ") << groupBy[i];
     
     if (!orderBy.empty())
-        oss << " ORDER BY " << orderBy;
+    {
+        oss << " ORDER BY ";
+        for (size_t i = 0; i < orderBy.size(); ++i)
+            oss << orderBy[i].column << (orderBy[i].descending ? " DESC" : "") << (i != orderBy.size() - 1 ? ", " : "");
+    }
+    if (limit >= 0)
+        oss << " LIMIT " << limit;
+    if (offset > 0)
+        oss << " OFFSET " << offset;
 
     return oss.str();
 }
 
-InsertStatement::InsertStatement(const std::string &tbl, const std::vector<std::string> &cols, const std::vector<std::string> &vals)
-    : AST("INSERT"), table(tbl), columns(cols), values(vals) {}
+InsertStatement::InsertStatement(const std::string &tbl, const std::vector<std::string> &cols,
+                                 const std::vector<std::vector<std::string>> &rows)
+    : AST("INSERT"), table(tbl), columns(cols), rows(rows) {}
 
 std::string InsertStatement::toString() const
 {
@@ -36,35 +110,37 @@ std::string InsertStatement::toString() const
     oss << "INSERT INTO " << table << " (";
     for (size_t i = 0; i < columns.size(); ++i)
         oss << columns[i] << (i != columns.size() - 1 ? ", " : "");
-    oss << ") VALUES (";
-    for (size_t i = 0; i < values.size(); ++i)
-        oss << values[i] << (i != values.size() - 1 ? ", " : "");
-    oss << ")";
+    oss << ") VALUES ";
+    for (size_t r = 0; r < rows.size(); ++r)
+    {
+        oss << "(";
+        for (size_t i = 0; i < rows[r].size(); ++i)
+            oss << rows[r][i] << (i != rows[r].size() - 1 ? ", " : "");
+        oss << ")" << (r != rows.size() - 1 ? ", " : "");
+    }
     return oss.str();
 }
 
-UpdateStatement::UpdateStatement(const std::string &tbl, const std::string &col, const std::string &val, const std::string &cond)
-    : AST("UPDATE"), table(tbl), column(col), value(val), condition(cond) {}
+UpdateStatement::UpdateStatement(const std::string &tbl, const std::string &col, const std::string &val, std::unique_ptr<Expr> where)
+    : AST("UPDATE"), table(tbl), column(col), value(val), where(std::move(where)) {}
 
 std::string UpdateStatement::toString() const
 {
     std::ostringstream oss;
     oss << "UPDATE " << table << " SET " << column << " = " << value;
-    if (!condition.empty())
-        oss << " WHERE " << condition;
-    std::printf("Statement updated\n"); // TODO: rmv
+    if (where)
+        oss << " WHERE " << where->toString();
     return oss.str();
 }
 
-DeleteStatement::DeleteStatement(const std::string &tbl, const std::string &cond)
-    : AST("DELETE"), table(tbl), condition(cond) {}
+DeleteStatement::DeleteStatement(const std::string &tbl, std::unique_ptr<Expr> where)
+    : AST("DELETE"), table(tbl), where(std::move(where)) {}
 
 std::string DeleteStatement::toString() const
 {
     std::ostringstream oss;
     oss << "DELETE FROM " << table;
-    if (!condition.empty())
-        oss << " WHERE " << condition;
-        std::printf("Statement deleted\n"); // TODO: rmv
+    if (where)
+        oss << " WHERE " << where->toString();
     return oss.str();
 }
\ No newline at end of file
@@ -15,18 +15,96 @@ public:
 	virtual std::string toString() const = 0;
 };
 
+// A string literal as SQL writes it: in single quotes, each ' doubled.
+std::string quoteString(const std::string &value);
+
+// Node of a WHERE clause. Comparisons are always "column op literal"; the
+// literal is kept as written and typed by the executor against the column.
+// Inside an EXISTS subquery, an unquoted `table.column` literal naming a
+// column of the outer query correlates the two.
+class Expr
+{
+public:
+	enum class Kind
+	{
+		COMPARE, // column op value
+		IN,      // column IN (values) or column IN (SELECT ...)
+		EXISTS,  // EXISTS (SELECT ...)
+		AND,
+		OR,
+		NOT
+	};
+
+	Kind kind;
+	std::string column;
+	std::string op; // =, !=, <, >, <=, >=
+	std::string value;
+	bool quoted = false; // value was a string literal
+	bool parameter = false; // value, or an IN value, is a `?` filled in by EXECUTE
+	std::vector<std::string> values;
+	std::unique_ptr<AST> subquery; // IN, EXISTS
+	std::vector<std::unique_ptr<Expr>> children; // AND, OR: two, NOT: one
+
+	Expr(Kind kind) : kind(kind) {}
+	std::string toString() const { return text(false); }
+	// toString with every literal quoted and escaped, so that two different
+	// clauses never print the same; see SelectStatement::cacheKey
+	std::string key() const { return text(true); }
+
+private:
+	std::string text(bool key) const;
+};
+
+// COUNT(*), COUNT(col), SUM, MIN, MAX or AVG of a column. Select list and
+// ORDER BY entries refer to one by its text, e.g. "SUM(v)".
+struct Aggregate
+{
+	std::string function; // upper case
+	std::string column;   // * for COUNT(*)
+	std::string text;
+};
+
+struct OrderByItem
+{
+	std::string column;
+	bool descending = false;
+};
+
+// [INNER | LEFT [OUTER]] JOIN table [[AS] alias] ON a = b [AND c = d ...]
+struct JoinClause
+{
+	bool left = false; // LEFT JOIN, otherwise INNER
+	std::string table;
+	std::string alias; // empty without one
+	std::vector<std::pair<std::string, std::string>> on; // column = column pairs
+};
+
 class SelectStatement : public AST
 {
 public:
 	std::vector<std::string> columns;
 	std::string table;
-	std::string condition;
+	std::string alias;
+	std::vector<JoinClause> joins;
+	std::unique_ptr<Expr> where; // null without WHERE
 	std::unique_ptr<AST> nestedFrom; // nested from er jnno
-	std::string orderBy;
+	std::vector<std::string> groupBy;
+	std::vector<Aggregate> aggregates; // of the select list and ORDER BY, each once
+	std::vector<OrderByItem> orderBy;
+	long long limit = -1; // -1 without LIMIT
+	long long offset = 0;
 
 	SelectStatement(const std::vector<std::string> &cols, const std::string &tbl,
-					const std::string &cond, std::unique_ptr<AST> nested = nullptr, const std::string &order = "");
-	std::string toString() const override;
+					std::unique_ptr<Expr> where, std::unique_ptr<AST> nested = nullptr,
+					const std::vector<OrderByItem> &order = {});
+	std::string toString() const override { return text(false); }
+	// Key of the statement in the ResultCache. Unlike toString, it tells
+	// IN ('a, b') from IN ('a', 'b') and a quote inside a literal from the
+	// one that ends it.
+	std::string cacheKey() const { return text(true); }
+
+private:
+	std::string text(bool key) const;
 };
 
 
@@ -37,9 +115,10 @@ class InsertStatement : public AST
 public:
 	std::string table;
 	std::vector<std::string> columns;
-	std::vector<std::string> values;
+	std::vector<std::vector<std::string>> rows; // one entry per VALUES tuple
 
-	InsertStatement(const std::string &tbl, const std::vector<std::string> &cols, const std::vector<std::string> &vals);
+	InsertStatement(const std::string &tbl, const std::vector<std::string> &cols,
+					const std::vector<std::vector<std::string>> &rows);
 	std::string toString() const override;
 };
 
@@ -49,9 +128,9 @@ public:
 	std::string table;
 	std::string column;
 	std::string value;
-	std::string condition;
+	std::unique_ptr<Expr> where;
 
-	UpdateStatement(const std::string &tbl, const std::string &col, const std::string &val, const std::string &cond);
+	UpdateStatement(const std::string &tbl, const std::string &col, const std::string &val, std::unique_ptr<Expr> where);
 	std::string toString() const override;
 };
 
@@ -59,9 +138,9 @@ class DeleteStatement : public AST
 {
 public:
 	std::string table;
-	std::string condition;
+	std::unique_ptr<Expr> where;
 
-	DeleteStatement(const std::string &tbl, const std::string &cond);
+	DeleteStatement(const std::string &tbl, std::unique_ptr<Expr> where);
 	std::string toString() const override;
 };
 
@@ -70,9 +149,11 @@ class CreateStatement : public AST
 public:
 	std::string table;
 	std::vector<std::pair<std::string, std::string>> columns;
+	std::string format; // storage format from USING, empty means row storage
 
-	CreateStatement(const std::string &tbl, const std::vector<std::pair<std::string, std::string>> &cols)
-		: AST("CREATE"), table(tbl), columns(cols) {}
+	CreateStatement(const std::string &tbl, const std::vector<std::pair<std::string, std::string>> &cols,
+					const std::string &fmt = "")
+		: AST("CREATE"), table(tbl), columns(cols), format(fmt) {}
 	
 	std::string toString() const override {
 		std::string ret = "CREATE TABLE " + table + " (";
@@ -81,8 +162,120 @@ public:
 			if (i < columns.size() - 1) ret += ", ";
 		}
 		ret += ")";
+		if (!format.empty()) ret += " USING " + format;
 		return ret;
 	}
 };
 
+class CreateIndexStatement : public AST
+{
+public:
+	std::string name;
+	std::string table;
+	std::string column;
+
+	CreateIndexStatement(const std::string &idx, const std::string &tbl, const std::string &col)
+		: AST("CREATE_INDEX"), name(idx), table(tbl), column(col) {}
+
+	std::string toString() const override {
+		return "CREATE INDEX " + name + " ON " + table + " (" + column + ")";
+	}
+};
+
+class CopyStatement : public AST
+{
+public:
+	std::string table;
+	std::string path;
+
+	CopyStatement(const std::string &tbl, const std::string &file) : AST("COPY"), table(tbl), path(file) {}
+
+	std::string toString() const override {
+		return "COPY " + table + " FROM '" + path + "'";
+	}
+};
+
+// Where EXECUTE writes the argument for one `?` of a prepared statement: a
+// literal in the statement's AST, and its quote flag where it has one.
+struct Parameter
+{
+	std::string *value = nullptr;
+	bool *quoted = nullptr;
+};
+
+// PREPARE name AS statement. `text` is the statement's tokens joined by
+// single spaces, with `?` placeholders; `parameters` are in text order.
+class PrepareStatement : public AST
+{
+public:
+	std::string name;
+	std::string text;
+	std::unique_ptr<AST> body;
+	std::vector<Parameter> parameters;
+
+	PrepareStatement(const std::string &name, const std::string &text, std::unique_ptr<AST> body,
+					 std::vector<Parameter> parameters)
+		: AST("PREPARE"), name(name), text(text), body(std::move(body)), parameters(std::move(parameters)) {}
+
+	std::string toString() const override {
+		return "PREPARE " + name + " AS " + text;
+	}
+};
+
+class ExecuteStatement : public AST
+{
+public:
+	std::string name;
+	std::vector<std::string> arguments;
+
+	ExecuteStatement(const std::string &name, const std::vector<std::string> &args)
+		: AST("EXECUTE"), name(name), arguments(args) {}
+
+	std::string toString() const override {
+		std::string ret = "EXECUTE " + name + "(";
+		for (size_t i = 0; i < arguments.size(); ++i) {
+			ret += arguments[i];
+			if (i < arguments.size() - 1) ret += ", ";
+		}
+		return ret + ")";
+	}
+};
+
+class DeallocateStatement : public AST
+{
+public:
+	std::string name;
+
+	DeallocateStatement(const std::string &name) : AST("DEALLOCATE"), name(name) {}
+
+	std::string toString() const override {
+		return "DEALLOCATE " + name;
+	}
+};
+
+// ANALYZE [table]; every table without one.
+class AnalyzeStatement : public AST
+{
+public:
+	std::string table;
+
+	AnalyzeStatement(const std::string &tbl) : AST("ANALYZE"), table(tbl) {}
+
+	std::string toString() const override {
+		return table.empty() ? "ANALYZE" : "ANALYZE " + table;
+	}
+};
+
+class VacuumStatement : public AST
+{
+public:
+	std::string table;
+
+	VacuumStatement(const std::string &tbl) : AST("VACUUM"), table(tbl) {}
+
+	std::string toString() const override {
+		return "VACUUM " + table;
+	}
+};
+
 #endif
\ No newline at end of file
@@ -8,6 +8,11 @@ SQLParser::SQLParser(Tokenizer &tokenizer) : tokenizer(tokenizer)
 
 void SQLParser::advance()
 {
+	if (recording && currentType != Tokenizer::TokenType::END)
+	{
+		*recording += currentType == Tokenizer::TokenType::STRING ? quoteString(currentToken) : currentToken;
+		*recording += " ";
+	}
 	if (tokenizer.hasNext())
 	{
 		currentToken = tokenizer.nextToken();
@@ -54,12 +59,98 @@ std::unique_ptr<AST> SQLParser::parse()
 		return parseDelete();
 	if (currentToken == "CREATE")
 		return parseCreate();
+	if (currentToken == "VACUUM")
+		return parseVacuum();
+	if (currentToken == "ANALYZE")
+		return parseAnalyze();
+	if (currentToken == "COPY")
+		return parseCopy();
+	if (currentToken == "PREPARE")
+		return parsePrepare();
+	if (currentToken == "EXECUTE")
+		return parseExecute();
+	if (currentToken == "DEALLOCATE")
+		return parseDeallocate();
 	throw std::runtime_error("Unknown SQL command");
 }
 
+std::unique_ptr<AST> SQLParser::parsePrepared(std::vector<Parameter> &params, std::string &text)
+{
+	if (currentToken != "SELECT" && currentToken != "INSERT" && currentToken != "UPDATE" && currentToken != "DELETE")
+		throw std::runtime_error("Only SELECT, INSERT, UPDATE and DELETE can be prepared");
+	params.clear();
+	text.clear();
+	parameters = &params;
+	recording = &text;
+	std::unique_ptr<AST> body = parse();
+	parameters = nullptr;
+	recording = nullptr;
+	if (!text.empty())
+		text.pop_back();
+	return body;
+}
+
+std::unique_ptr<AST> SQLParser::parsePrepare()
+{
+	advance(); // PREPARE
+	std::string name = currentToken;
+	expect(Tokenizer::TokenType::IDENTIFIER);
+	expect("AS");
+	std::vector<Parameter> params;
+	std::string text;
+	std::unique_ptr<AST> body = parsePrepared(params, text);
+	return std::make_unique<PrepareStatement>(name, text, std::move(body), std::move(params));
+}
+
+std::unique_ptr<AST> SQLParser::parseExecute()
+{
+	advance(); // EXECUTE
+	std::string name = currentToken;
+	expect(Tokenizer::TokenType::IDENTIFIER);
+	std::vector<std::string> args;
+	if (currentToken == "(")
+	{
+		advance();
+		bool quoted;
+		while (currentToken != ")")
+		{
+			// Arguments are values; a name would be read as a column
+			if (currentType == Tokenizer::TokenType::IDENTIFIER)
+				throw std::runtime_error("Expected a number or a quoted string, got '" + currentToken + "'");
+			args.push_back(parseLiteral(quoted));
+			if (currentToken != ",")
+				break;
+			advance();
+		}
+		expect(")");
+	}
+	return std::make_unique<ExecuteStatement>(name, args);
+}
+
+std::unique_ptr<AST> SQLParser::parseDeallocate()
+{
+	advance(); // DEALLOCATE
+	std::string name = currentToken;
+	expect(Tokenizer::TokenType::IDENTIFIER);
+	return std::make_unique<DeallocateStatement>(name);
+}
+
+int SQLParser::parseParameter()
+{
+	if (currentToken != "?" || currentType != Tokenizer::TokenType::PUNCTUATION)
+		return -1;
+	if (!parameters)
+		throw std::runtime_error("'?' placeholders are only allowed in PREPARE");
+	parameters->push_back(Parameter());
+	advance();
+	return static_cast<int>(parameters->size() - 1);
+}
+
 std::unique_ptr<AST> SQLParser::parseCreate()
 {
 	advance(); // CREATE
+	if (currentToken == "INDEX")
+		return parseCreateIndex();
 	expect("TABLE");
 	std::string table = currentToken;
 	expect(Tokenizer::TokenType::IDENTIFIER);
@@ -86,13 +177,48 @@ std::unique_ptr<AST> SQLParser::parseCreate()
 		}
 	}
 	expect(")");
-	return std::make_unique<CreateStatement>(table, columns);
+
+	std::string format;
+	if (currentToken == "USING")
+	{
+		advance();
+		format = currentToken;
+		expect(Tokenizer::TokenType::IDENTIFIER);
+		for (auto &c : format) c = std::toupper(c);
+		if (format != "ROW" && format != "COLUMNAR")
+		{
+			throw std::runtime_error("Unknown storage format '" + format + "'");
+		}
+	}
+	return std::make_unique<CreateStatement>(table, columns, format);
+}
+
+std::unique_ptr<AST> SQLParser::parseCreateIndex()
+{
+	advance(); // INDEX
+	std::string name = currentToken;
+	expect(Tokenizer::TokenType::IDENTIFIER);
+	expect("ON");
+	std::string table = currentToken;
+	expect(Tokenizer::TokenType::IDENTIFIER);
+	expect("(");
+	std::string column = currentToken;
+	expect(Tokenizer::TokenType::IDENTIFIER);
+	expect(")");
+	return std::make_unique<CreateIndexStatement>(name, table, column);
 }
 
 std::unique_ptr<AST> SQLParser::parseSelect()
 {
 	advance(); // consume SELECT
-	auto columns = parseIdentifierList();
+	std::vector<Aggregate> aggregates;
+	std::vector<std::string> columns;
+	columns.push_back(parseSelectItem(aggregates));
+	while (currentToken == ",")
+	{
+		advance();
+		columns.push_back(parseSelectItem(aggregates));
+	}
 	expect("FROM");
 
 	std::string table;
@@ -109,28 +235,73 @@ std::unique_ptr<AST> SQLParser::parseSelect()
 		table = currentToken;
 		expect(Tokenizer::TokenType::IDENTIFIER);
 	}
+	std::string alias = parseAlias();
+
+	std::vector<JoinClause> joins;
+	while (currentToken == "JOIN" || currentToken == "INNER" || currentToken == "LEFT")
+		joins.push_back(parseJoin());
 
-	std::string condition;
+	std::unique_ptr<Expr> where;
 	if (currentToken == "WHERE")
 	{
 		advance();
-		while (currentType != Tokenizer::TokenType::END && currentToken != ")" && currentToken != "ORDER")
+		where = parseOr();
+	}
+
+	std::vector<std::string> groupBy;
+	if (currentToken == "GROUP")
+	{
+		advance();
+		expect("BY");
+		while (true)
 		{
-			condition += currentToken + " ";
+			groupBy.push_back(currentToken);
+			expect(Tokenizer::TokenType::IDENTIFIER);
+			if (currentToken != ",")
+				break;
 			advance();
 		}
 	}
 
-	std::string orderBy;
+	std::vector<OrderByItem> orderBy;
 	if (currentToken == "ORDER")
 	{
 		advance();
 		expect("BY");
-		orderBy = currentToken; // Simple ORDER BY col
-		advance(); 
+		while (true)
+		{
+			OrderByItem item;
+			if (currentType != Tokenizer::TokenType::IDENTIFIER)
+				throw std::runtime_error("Expected a column after ORDER BY, got '" + currentToken + "'");
+			item.column = parseSelectItem(aggregates);
+			if (currentToken == "ASC" || currentToken == "DESC")
+			{
+				item.descending = currentToken == "DESC";
+				advance();
+			}
+			orderBy.push_back(item);
+			if (currentToken != ",")
+				break;
+			advance();
+		}
 	}
 
-	return std::make_unique<SelectStatement>(columns, table, condition, std::move(nestedSource), orderBy);
+	auto stmt = std::make_unique<SelectStatement>(columns, table, std::move(where), std::move(nestedSource), orderBy);
+	stmt->alias = alias;
+	stmt->joins = std::move(joins);
+	stmt->groupBy = groupBy;
+	stmt->aggregates = aggregates;
+	if (currentToken == "LIMIT")
+	{
+		advance();
+		stmt->limit = parseCount("LIMIT");
+	}
+	if (currentToken == "OFFSET")
+	{
+		advance();
+		stmt->offset = parseCount("OFFSET");
+	}
+	return stmt;
 }
 
 std::unique_ptr<AST> SQLParser::parseInsert()
@@ -147,12 +318,46 @@ std::unique_ptr<AST> SQLParser::parseInsert()
 
 	expect("VALUES");
 
-	// Handle (val1, val2)
-	expect("(");
-	auto values = parseIdentifierList();
-	expect(")");
+	// Handle (val1, val2), (val3, val4), ...
+	struct Slot
+	{
+		size_t row, column;
+		int parameter;
+	};
+	std::vector<std::vector<std::string>> rows;
+	std::vector<Slot> slots;
+	while (true)
+	{
+		expect("(");
+		std::vector<std::string> row;
+		while (true)
+		{
+			int parameter = parseParameter();
+			if (parameter != -1)
+			{
+				slots.push_back({rows.size(), row.size(), parameter});
+				row.push_back("?");
+			}
+			else
+			{
+				row.push_back(currentToken);
+				advance();
+			}
+			if (currentToken != ",")
+				break;
+			advance();
+		}
+		rows.push_back(row);
+		expect(")");
+		if (currentToken != ",")
+			break;
+		advance();
+	}
 
-	return std::make_unique<InsertStatement>(table, columns, values);
+	auto stmt = std::make_unique<InsertStatement>(table, columns, rows);
+	for (const auto &slot : slots)
+		(*parameters)[slot.parameter].value = &stmt->rows[slot.row][slot.column];
+	return stmt;
 }
 
 std::unique_ptr<AST> SQLParser::parseUpdate()
@@ -164,20 +369,23 @@ std::unique_ptr<AST> SQLParser::parseUpdate()
 	std::string column = currentToken;
 	advance();
 	expect("=");
-	std::string value = currentToken;
-	advance();
-	std::string condition;
+	int parameter = parseParameter();
+	std::string value;
+	if (parameter == -1)
+	{
+		value = currentToken;
+		advance();
+	}
+	std::unique_ptr<Expr> where;
 	if (currentToken == "WHERE")
 	{
 		advance();
-        // Capture everything until end or next keyword (UPDATE usually ends with WHERE, but check delimiters)
-		while (currentType != Tokenizer::TokenType::END && currentToken != ";")
-		{
-			condition += currentToken + " ";
-			advance();
-		}
+		where = parseOr();
 	}
-	return std::make_unique<UpdateStatement>(table, column, value, condition);
+	auto stmt = std::make_unique<UpdateStatement>(table, column, value, std::move(where));
+	if (parameter != -1)
+		(*parameters)[parameter].value = &stmt->value;
+	return stmt;
 }
 
 std::unique_ptr<AST> SQLParser::parseDelete()
@@ -186,18 +394,142 @@ std::unique_ptr<AST> SQLParser::parseDelete()
 	expect("FROM");
 	std::string table = currentToken;
 	advance();
-	std::string condition;
+	std::unique_ptr<Expr> where;
 	if (currentToken == "WHERE")
 	{
 		advance();
-        // Capture everything until end
-		while (currentType != Tokenizer::TokenType::END && currentToken != ";")
-		{
-			condition += currentToken + " ";
+		where = parseOr();
+	}
+	return std::make_unique<DeleteStatement>(table, std::move(where));
+}
+
+std::unique_ptr<AST> SQLParser::parseVacuum()
+{
+	advance(); // VACUUM
+	std::string table = currentToken;
+	expect(Tokenizer::TokenType::IDENTIFIER);
+	return std::make_unique<VacuumStatement>(table);
+}
+
+std::unique_ptr<AST> SQLParser::parseAnalyze()
+{
+	advance(); // ANALYZE
+	std::string table;
+	if (currentType == Tokenizer::TokenType::IDENTIFIER)
+	{
+		table = currentToken;
+		advance();
+	}
+	return std::make_unique<AnalyzeStatement>(table);
+}
+
+std::unique_ptr<AST> SQLParser::parseCopy()
+{
+	advance(); // COPY
+	std::string table = currentToken;
+	expect(Tokenizer::TokenType::IDENTIFIER);
+	expect("FROM");
+	std::string path = currentToken;
+	expect(Tokenizer::TokenType::STRING);
+	return std::make_unique<CopyStatement>(table, path);
+}
+
+std::string SQLParser::parseAlias()
+{
+	if (currentToken == "AS")
+	{
+		advance();
+		std::string alias = currentToken;
+		expect(Tokenizer::TokenType::IDENTIFIER);
+		return alias;
+	}
+	if (currentType != Tokenizer::TokenType::IDENTIFIER)
+		return "";
+	std::string alias = currentToken;
+	advance();
+	return alias;
+}
+
+JoinClause SQLParser::parseJoin()
+{
+	JoinClause join;
+	if (currentToken == "LEFT")
+	{
+		join.left = true;
+		advance();
+		if (currentToken == "OUTER")
 			advance();
-		}
 	}
-	return std::make_unique<DeleteStatement>(table, condition);
+	else if (currentToken == "INNER")
+	{
+		advance();
+	}
+	expect("JOIN");
+	join.table = currentToken;
+	expect(Tokenizer::TokenType::IDENTIFIER);
+	join.alias = parseAlias();
+
+	// Equality of columns only: ON a.x = b.y [AND a.z = b.w ...]
+	expect("ON");
+	while (true)
+	{
+		std::string leftColumn = currentToken;
+		expect(Tokenizer::TokenType::IDENTIFIER);
+		if (currentToken != "=")
+			throw std::runtime_error("JOIN ... ON supports only column = column, got '" + currentToken + "'");
+		advance();
+		std::string rightColumn = currentToken;
+		expect(Tokenizer::TokenType::IDENTIFIER);
+		join.on.push_back({leftColumn, rightColumn});
+		if (currentToken != "AND")
+			break;
+		advance();
+	}
+	return join;
+}
+
+long long SQLParser::parseCount(const std::string &clause)
+{
+	if (currentType != Tokenizer::TokenType::NUMBER || currentToken.size() > 18)
+		throw std::runtime_error("Expected a row count after " + clause + ", got '" + currentToken + "'");
+	long long count = std::stoll(currentToken);
+	advance();
+	return count;
+}
+
+std::string SQLParser::parseSelectItem(std::vector<Aggregate> &aggregates)
+{
+	std::string item = currentToken;
+	bool identifier = currentType == Tokenizer::TokenType::IDENTIFIER;
+	advance();
+	if (!identifier || currentToken != "(")
+		return item;
+
+	Aggregate agg;
+	agg.function = item;
+	for (auto &c : agg.function) c = std::toupper(c);
+	if (agg.function != "COUNT" && agg.function != "SUM" && agg.function != "MIN" &&
+		agg.function != "MAX" && agg.function != "AVG")
+		throw std::runtime_error("Unknown function '" + item + "'");
+	advance(); // consume (
+	agg.column = currentToken;
+	if (currentToken == "*")
+	{
+		if (agg.function != "COUNT")
+			throw std::runtime_error(agg.function + "(*) is not supported, only COUNT(*)");
+		advance();
+	}
+	else
+		expect(Tokenizer::TokenType::IDENTIFIER);
+	expect(")");
+	agg.text = agg.function + "(" + agg.column + ")";
+
+	bool seen = false;
+	for (const auto &other : aggregates)
+		seen = seen || other.text == agg.text;
+	if (!seen)
+		aggregates.push_back(agg);
+	return agg.text;
 }
 
 std::vector<std::string> SQLParser::parseIdentifierList()
@@ -215,4 +547,162 @@ std::vector<std::string> SQLParser::parseIdentifierList()
 		advance();
 	}
 	return list;
-}
\ No newline at end of file
+}
+
+std::unique_ptr<Expr> SQLParser::parseOr()
+{
+	auto left = parseAnd();
+	while (currentToken == "OR")
+	{
+		advance();
+		auto node = std::make_unique<Expr>(Expr::Kind::OR);
+		node->children.push_back(std::move(left));
+		node->children.push_back(parseAnd());
+		left = std::move(node);
+	}
+	return left;
+}
+
+std::unique_ptr<Expr> SQLParser::parseAnd()
+{
+	auto left = parseNot();
+	while (currentToken == "AND")
+	{
+		advance();
+		auto node = std::make_unique<Expr>(Expr::Kind::AND);
+		node->children.push_back(std::move(left));
+		node->children.push_back(parseNot());
+		left = std::move(node);
+	}
+	return left;
+}
+
+std::unique_ptr<Expr> SQLParser::parseNot()
+{
+	if (currentToken != "NOT")
+		return parsePredicate();
+	advance();
+	auto node = std::make_unique<Expr>(Expr::Kind::NOT);
+	node->children.push_back(parseNot());
+	return node;
+}
+
+std::unique_ptr<Expr> SQLParser::parsePredicate()
+{
+	if (currentToken == "(")
+	{
+		advance();
+		auto inner = parseOr();
+		expect(")");
+		return inner;
+	}
+	if (currentToken == "EXISTS")
+	{
+		advance();
+		expect("(");
+		if (currentToken != "SELECT")
+			throw std::runtime_error("Expected SELECT after EXISTS (, got '" + currentToken + "'");
+		auto node = std::make_unique<Expr>(Expr::Kind::EXISTS);
+		node->subquery = parseSelect();
+		expect(")");
+		return node;
+	}
+
+	std::string column = currentToken;
+	expect(Tokenizer::TokenType::IDENTIFIER);
+
+	// col NOT IN (...) is NOT (col IN (...))
+	bool negated = false;
+	if (currentToken == "NOT")
+	{
+		advance();
+		if (currentToken != "IN")
+			throw std::runtime_error("Expected 'IN' after NOT, got '" + currentToken + "'");
+		negated = true;
+	}
+
+	std::unique_ptr<Expr> node;
+	if (currentToken == "IN")
+	{
+		advance();
+		expect("(");
+		node = std::make_unique<Expr>(Expr::Kind::IN);
+		node->column = column;
+		if (currentToken == "SELECT")
+		{
+			node->subquery = parseSelect();
+		}
+		else
+		{
+			bool quoted;
+			std::vector<std::pair<size_t, int>> slots;
+			while (true)
+			{
+				int parameter = parseParameter();
+				if (parameter != -1)
+					slots.push_back({node->values.size(), parameter});
+				node->values.push_back(parameter != -1 ? "?" : parseLiteral(quoted));
+				if (currentToken != ",")
+					break;
+				advance();
+			}
+			for (const auto &slot : slots)
+				(*parameters)[slot.second].value = &node->values[slot.first];
+			node->parameter = !slots.empty();
+		}
+		expect(")");
+	}
+	else
+	{
+		node = std::make_unique<Expr>(Expr::Kind::COMPARE);
+		node->column = column;
+		node->op = parseComparisonOp();
+		int parameter = parseParameter();
+		node->parameter = parameter != -1;
+		if (parameter != -1)
+			(*parameters)[parameter] = {&node->value, &node->quoted};
+		else
+			node->value = parseLiteral(node->quoted);
+	}
+
+	if (!negated)
+		return node;
+	auto notNode = std::make_unique<Expr>(Expr::Kind::NOT);
+	notNode->children.push_back(std::move(node));
+	return notNode;
+}
+
+std::string SQLParser::parseComparisonOp()
+{
+	// The tokenizer splits <=, >=, != and <> into single characters
+	std::string op = currentToken;
+	if (currentType != Tokenizer::TokenType::OPERATOR || (op != "=" && op != "<" && op != ">" && op != "!"))
+		throw std::runtime_error("Expected comparison operator, got '" + op + "'");
+	advance();
+	if (op != "=" && (currentToken == "=" || (op == "<" && currentToken == ">")))
+	{
+		op = currentToken == ">" ? "!=" : op + "=";
+		advance();
+	}
+	if (op == "!")
+		throw std::runtime_error("Expected '=' after '!'");
+	return op;
+}
+
+std::string SQLParser::parseLiteral(bool &quoted)
+{
+	quoted = currentType == Tokenizer::TokenType::STRING;
+	std::string value = currentToken;
+	if (currentToken == "-")
+	{
+		advance();
+		value = "-" + currentToken;
+		expect(Tokenizer::TokenType::NUMBER);
+		return value;
+	}
+	if (currentType != Tokenizer::TokenType::NUMBER && currentType != Tokenizer::TokenType::STRING &&
+		currentType != Tokenizer::TokenType::IDENTIFIER)
+		throw std::runtime_error("Expected value, got '" + currentToken + "'");
+	advance();
+	return value;
+}
@@ -10,11 +10,17 @@ class SQLParser
 public:
 	SQLParser(Tokenizer &tokenizer);
 	std::unique_ptr<AST> parse();
+	// Parses a statement whose literals may be `?` placeholders (the body of
+	// a PREPARE). `text` gets its normalized text, see PrepareStatement.
+	std::unique_ptr<AST> parsePrepared(std::vector<Parameter> &parameters, std::string &text);
 
 private:
 	Tokenizer &tokenizer;
 	std::string currentToken;
 	Tokenizer::TokenType currentType;
+	// Set while parsing a prepared statement
+	std::vector<Parameter> *parameters = nullptr;
+	std::string *recording = nullptr;
 
 	void advance();
 	void expect(const std::string &value);
@@ -25,7 +31,31 @@ private:
 	std::unique_ptr<AST> parseUpdate();
 	std::unique_ptr<AST> parseDelete();
 	std::unique_ptr<AST> parseCreate();
+	std::unique_ptr<AST> parseCreateIndex();
+	std::unique_ptr<AST> parseVacuum();
+	std::unique_ptr<AST> parseAnalyze();
+	std::unique_ptr<AST> parseCopy();
+	std::unique_ptr<AST> parsePrepare();
+	std::unique_ptr<AST> parseExecute();
+	std::unique_ptr<AST> parseDeallocate();
+	// Consumes a `?` and returns its index in `parameters`; -1 for any other token.
+	int parseParameter();
 	std::vector<std::string> parseIdentifierList();
+	// A select list or ORDER BY entry: a column, *, or an aggregate call,
+	// which is added to `aggregates` once and named by its text.
+	std::string parseSelectItem(std::vector<Aggregate> &aggregates);
+	std::string parseAlias();
+	JoinClause parseJoin();
+	long long parseCount(const std::string &clause);
+
+	// WHERE clauses, lowest precedence first: OR, AND, NOT, then comparisons
+	// and parenthesized expressions.
+	std::unique_ptr<Expr> parseOr();
+	std::unique_ptr<Expr> parseAnd();
+	std::unique_ptr<Expr> parseNot();
+	std::unique_ptr<Expr> parsePredicate();
+	std::string parseComparisonOp();
+	std::string parseLiteral(bool &quoted);
 };
 
 #endif
\ No newline at end of file
@@ -18,8 +18,10 @@ bool Tokenizer::isKeyword(const std::string &str) const
     for (auto &c : upperStr) c = std::toupper(c);
 
 	static const std::vector<std::string> keywords = {
-		"SELECT", "INSERT", "UPDATE", "DELETE", "FROM", "WHERE", "AND", "OR", "VALUES", "LIMIT",
-        "CREATE", "TABLE", "INTO", "SET", "ORDER", "BY", "INT", "STRING", "IN"};
+		"SELECT", "INSERT", "UPDATE", "DELETE", "FROM", "WHERE", "AND", "OR", "NOT", "VALUES", "LIMIT",
+        "CREATE", "TABLE", "INTO", "SET", "ORDER", "BY", "INT", "STRING", "IN", "USING", "INDEX", "ON",
+        "VACUUM", "COPY", "ASC", "DESC", "OFFSET", "JOIN", "INNER", "LEFT", "OUTER", "AS",
+        "EXISTS", "GROUP", "PREPARE", "EXECUTE", "DEALLOCATE", "ANALYZE"};
 	for (const auto &keyword : keywords)
 	{
 		if (upperStr == keyword)
@@ -56,7 +58,7 @@ bool Tokenizer::isStringDelimiter(char c) const
 }
 bool Tokenizer::isPunctuation(char c) const
 {
-	return c == ',' || c == '(' || c == ')' || c == ';';
+	return c == ',' || c == '(' || c == ')' || c == ';' || c == '?';
 }
 
 Tokenizer::TokenType Tokenizer::getLastTokenType() const
@@ -87,8 +89,12 @@ std::string Tokenizer::nextToken()
 	if (isStringDelimiter(currentChar))
 	{
 		position++; // Skip the opening quote
-		while (position < input.size() && input[position] != '\'')
+		// '' inside a literal is one quote
+		while (position < input.size() && (input[position] != '\'' ||
+										   (position + 1 < input.size() && input[position + 1] == '\'')))
 		{
+			if (input[position] == '\'')
+				position++;
 			currentToken += input[position++];
 		}
 		if (position < input.size() && input[position] == '\'')
@@ -117,6 +123,21 @@ std::string Tokenizer::nextToken()
 		{
 			currentToken += input[position++];
 		}
+		// Qualified names (table.column, table.*) are one identifier
+		while (position + 1 < input.size() && input[position] == '.' &&
+			   (isIdentifierStart(input[position + 1]) || input[position + 1] == '*'))
+		{
+			currentToken += input[position++];
+			if (input[position] == '*')
+			{
+				currentToken += input[position++];
+				break;
+			}
+			while (position < input.size() && isIdentifierPart(input[position]))
+			{
+				currentToken += input[position++];
+			}
+		}
 		// Check for keyword
 		if (isKeyword(currentToken))
 		{
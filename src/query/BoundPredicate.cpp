@@ -0,0 +1,398 @@
+#include "BoundPredicate.h"
+#include "../utils/Validators.h"
+#include <algorithm>
+#include <stdexcept>
+
+namespace spl {
+
+namespace {
+
+CompareOp parseOp(const std::string& op) {
+    using Op = CompareOp;
+    if (op == "!=") return Op::NE;
+    if (op == "<") return Op::LT;
+    if (op == ">") return Op::GT;
+    if (op == "<=") return Op::LE;
+    if (op == ">=") return Op::GE;
+    return Op::EQ;
+}
+
+// Index of the column a WHERE term names. An unknown name is an error rather
+// than a FALSE term, which NOT would turn into TRUE for every row.
+int bindColumn(const std::vector<Column>& columns, const std::string& name) {
+    bool ambiguous;
+    int column = findColumn(columns, name, &ambiguous);
+    if (ambiguous) throw std::runtime_error("Column " + name + " is ambiguous.");
+    if (column == -1) throw std::runtime_error("Column " + name + " not found.");
+    return column;
+}
+
+// Types a literal of `expr` against its column. One written in the statement
+// that does not fit folds its term to FALSE; an EXECUTE argument that does
+// not fit is an error, as it would be in INSERT or UPDATE.
+bool parseLiteral(const Expr& expr, const std::string& text, const std::string& type, Value& out) {
+    bool ok = Value::parse(text, type, out);
+    if (expr.parameter && (!ok || (isIntType(type) && !Validators::isInteger(text)))) {
+        throw std::runtime_error("Invalid " + type + " value '" + text + "' for column " + expr.column + ".");
+    }
+    return ok;
+}
+
+BoundPredicate bindCompare(const std::vector<Column>& columns, const Expr& expr) {
+    BoundPredicate out;
+    out.column = bindColumn(columns, expr.column);
+    if (!parseLiteral(expr, expr.value, columns[out.column].type, out.literal)) {
+        return BoundPredicate::constant(false);
+    }
+    out.kind = BoundPredicate::Kind::COMPARE;
+    out.op = parseOp(expr.op);
+    return out;
+}
+
+// Adds the first cell of a subquery row to an IN list on a column of type
+// `type`. Cells of another type match by their text form.
+void addFirstCell(ValueSet& values, const Row& row, const std::string& type) {
+    if (row.values.empty()) return;
+    const Value& cell = row.values[0];
+    if (cell.isNull()) {
+        values.insert(cell);
+        return;
+    }
+    Value v;
+    if (cell.isInt() == isIntType(type)) {
+        values.insert(cell);
+    } else if (Value::parse(cell.toString(), type, v)) {
+        values.insert(v);
+    }
+}
+
+BoundPredicate bindIn(const std::vector<Column>& columns, const Expr& expr,
+                      const BoundPredicate::SubqueryRunner& runSubquery) {
+    BoundPredicate out;
+    out.column = bindColumn(columns, expr.column);
+    out.kind = BoundPredicate::Kind::IN;
+    const std::string& type = columns[out.column].type;
+
+    if (expr.subquery) {
+        runSubquery(static_cast<SelectStatement*>(expr.subquery.get()), [&](const Row& row) {
+            addFirstCell(out.values, row, type);
+            return true;
+        });
+    } else {
+        Value v;
+        for (const auto& text : expr.values) {
+            if (parseLiteral(expr, text, type, v)) out.values.insert(v);
+        }
+    }
+    if (out.values.empty() && !out.values.hasNull()) return BoundPredicate::constant(false);
+    return out;
+}
+
+// Table names and aliases a subquery's own columns can be qualified with.
+// They shadow the outer query's.
+void addQualifiers(const SelectStatement& sub, std::vector<std::string>& scope) {
+    scope.push_back(sub.table);
+    if (!sub.alias.empty()) scope.push_back(sub.alias);
+    for (const auto& join : sub.joins) {
+        scope.push_back(join.table);
+        if (!join.alias.empty()) scope.push_back(join.alias);
+    }
+}
+
+// Whether `name` is a qualified reference to one of the outer `columns`
+// rather than to a table of the subquery.
+bool isOuterRef(const std::string& name, const std::vector<Column>& columns,
+                const std::vector<std::string>& scope) {
+    size_t dot = name.find('.');
+    if (dot == std::string::npos || findColumn(columns, name) == -1) return false;
+    return std::find(scope.begin(), scope.end(), name.substr(0, dot)) == scope.end();
+}
+
+// Finds the `inner_col = outer.col` terms among the top-level AND terms of
+// an EXISTS subquery's WHERE. The outer side is an unquoted, qualified
+// literal naming one of `columns`; it may be written on either side.
+void findCorrelations(std::unique_ptr<Expr>& slot, const std::vector<Column>& columns,
+                      const std::vector<std::string>& scope, std::vector<std::unique_ptr<Expr>*>& found) {
+    Expr& expr = *slot;
+    if (expr.kind == Expr::Kind::AND) {
+        for (auto& child : expr.children) findCorrelations(child, columns, scope, found);
+        return;
+    }
+    if (expr.kind == Expr::Kind::COMPARE && expr.op == "=" && !expr.quoted &&
+        isOuterRef(expr.value, columns, scope) != isOuterRef(expr.column, columns, scope)) {
+        found.push_back(&slot);
+    }
+}
+
+// Whether `expr`, other than the `allowed` term, refers to the outer query
+// anywhere, including in nested subqueries. Such a reference would bind as a
+// literal and silently give wrong results.
+bool refersToOuter(const Expr& expr, const Expr* allowed, const std::vector<Column>& columns,
+                   const std::vector<std::string>& scope) {
+    if (&expr == allowed) return false;
+    if (isOuterRef(expr.column, columns, scope)) return true;
+    if (expr.kind == Expr::Kind::COMPARE && !expr.quoted && isOuterRef(expr.value, columns, scope)) return true;
+    for (const auto& child : expr.children) {
+        if (refersToOuter(*child, allowed, columns, scope)) return true;
+    }
+    if (expr.subquery && expr.subquery->type == "SELECT") {
+        const auto& nested = static_cast<const SelectStatement&>(*expr.subquery);
+        std::vector<std::string> nestedScope = scope;
+        addQualifiers(nested, nestedScope);
+        if (nested.where && refersToOuter(*nested.where, nullptr, columns, nestedScope)) return true;
+    }
+    return false;
+}
+
+BoundPredicate bindExists(const std::vector<Column>& columns, const Expr& expr,
+                          const BoundPredicate::SubqueryRunner& runSubquery) {
+    auto* sub = static_cast<SelectStatement*>(expr.subquery.get());
+    std::vector<std::string> scope;
+    addQualifiers(*sub, scope);
+    std::vector<std::unique_ptr<Expr>*> correlations;
+    if (sub->where) findCorrelations(sub->where, columns, scope, correlations);
+    if (correlations.size() > 1) {
+        throw std::runtime_error("EXISTS subqueries may compare only one column with the outer query");
+    }
+    const Expr* correlation = correlations.empty() ? nullptr : correlations[0]->get();
+    if (sub->where && refersToOuter(*sub->where, correlation, columns, scope)) {
+        throw std::runtime_error("Unsupported correlated subquery: the outer query may only appear in one "
+                                 "top-level inner_col = outer.col term");
+    }
+    if (correlations.empty()) {
+        bool any = false;
+        runSubquery(sub, [&](const Row&) {
+            any = true;
+            return false;
+        });
+        return BoundPredicate::constant(any);
+    }
+    // Selecting inner_col instead would change what the subquery means
+    if (!sub->aggregates.empty() || !sub->groupBy.empty()) {
+        throw std::runtime_error("Unsupported correlated subquery: aggregates and GROUP BY are not allowed");
+    }
+
+    std::unique_ptr<Expr>& slot = *correlations[0];
+    bool outerOnRight = isOuterRef(slot->value, columns, scope);
+    const std::string& outerName = outerOnRight ? slot->value : slot->column;
+    std::string innerName = outerOnRight ? slot->column : slot->value;
+
+    BoundPredicate out;
+    out.kind = BoundPredicate::Kind::IN;
+    out.exists = true;
+    out.column = findColumn(columns, outerName);
+    const std::string type = columns[out.column].type;
+
+    // Run `SELECT inner_col ...` without the correlation (an empty AND is
+    // TRUE) and without ORDER BY / LIMIT, then put the statement back
+    std::unique_ptr<Expr> term = std::move(slot);
+    slot = std::make_unique<Expr>(Expr::Kind::AND);
+    std::vector<std::string> selected = std::move(sub->columns);
+    std::vector<OrderByItem> orderBy = std::move(sub->orderBy);
+    long long limit = sub->limit, offset = sub->offset;
+    sub->columns = {innerName};
+    sub->orderBy.clear();
+    sub->limit = -1;
+    sub->offset = 0;
+    auto restore = [&]() {
+        slot = std::move(term);
+        sub->columns = std::move(selected);
+        sub->orderBy = std::move(orderBy);
+        sub->limit = limit;
+        sub->offset = offset;
+    };
+    try {
+        runSubquery(sub, [&](const Row& row) {
+            addFirstCell(out.values, row, type);
+            return true;
+        });
+    } catch (...) {
+        restore();
+        throw;
+    }
+    restore();
+
+    if (out.values.empty()) return BoundPredicate::constant(false);
+    return out;
+}
+
+// Folds `child` into the AND or OR `out`: its children are adopted if it is
+// of the same kind, constants drop out. Returns false, leaving `child` as it
+// is, for a constant that decides `out` (FALSE under AND, TRUE under OR).
+bool absorb(BoundPredicate& out, BoundPredicate& child) {
+    bool identity = out.kind == BoundPredicate::Kind::AND;
+    if (child.kind == BoundPredicate::Kind::CONSTANT) return child.value == identity;
+    if (child.kind == out.kind) {
+        for (auto& grandchild : child.children) out.children.push_back(std::move(grandchild));
+    } else {
+        out.children.push_back(std::move(child));
+    }
+    return true;
+}
+
+BoundPredicate collapse(BoundPredicate out) {
+    if (out.children.empty()) return BoundPredicate::constant(out.kind == BoundPredicate::Kind::AND);
+    if (out.children.size() == 1) return std::move(out.children[0]);
+    return out;
+}
+
+} // namespace
+
+size_t ValueSet::slotOf(int64_t value) const {
+    uint64_t hash = static_cast<uint64_t>(value) * 0x9E3779B97F4A7C15ull;
+    size_t mask = intSlots.size() - 1;
+    size_t slot = (hash ^ (hash >> 32)) & mask;
+    while (intUsed[slot] && intSlots[slot] != value) slot = (slot + 1) & mask;
+    return slot;
+}
+
+void ValueSet::insertInt(int64_t value) {
+    if ((intCount + 1) * 2 > intSlots.size()) {
+        std::vector<int64_t> oldSlots(std::max<size_t>(16, intSlots.size() * 2));
+        std::vector<uint8_t> oldUsed(oldSlots.size(), 0);
+        oldSlots.swap(intSlots);
+        oldUsed.swap(intUsed);
+        for (size_t i = 0; i < oldSlots.size(); i++) {
+            if (!oldUsed[i]) continue;
+            size_t slot = slotOf(oldSlots[i]);
+            intSlots[slot] = oldSlots[i];
+            intUsed[slot] = 1;
+        }
+    }
+    size_t slot = slotOf(value);
+    if (intUsed[slot]) return;
+    intSlots[slot] = value;
+    intUsed[slot] = 1;
+    intCount++;
+}
+
+void ValueSet::insert(const Value& value) {
+    if (value.isInt()) {
+        insertInt(value.asInt());
+    } else if (value.isString()) {
+        strings.insert(value.asString());
+    } else {
+        sawNull = true;
+    }
+}
+
+bool ValueSet::contains(const Value& value) const {
+    if (value.isInt()) return intCount > 0 && intUsed[slotOf(value.asInt())];
+    if (value.isString()) return strings.count(value.asString()) > 0;
+    return false;
+}
+
+BoundPredicate BoundPredicate::constant(bool value) {
+    BoundPredicate out;
+    out.value = value;
+    return out;
+}
+
+BoundPredicate BoundPredicate::bind(const std::vector<Column>& columns, const Expr& expr,
+                                    const SubqueryRunner& runSubquery) {
+    switch (expr.kind) {
+        case Expr::Kind::COMPARE:
+            return bindCompare(columns, expr);
+        case Expr::Kind::IN:
+            return bindIn(columns, expr, runSubquery);
+        case Expr::Kind::EXISTS:
+            return bindExists(columns, expr, runSubquery);
+        case Expr::Kind::NOT: {
+            BoundPredicate child = bind(columns, *expr.children[0], runSubquery);
+            if (child.kind == Kind::CONSTANT) return constant(!child.value);
+            BoundPredicate out;
+            out.kind = Kind::NOT;
+            out.children.push_back(std::move(child));
+            return out;
+        }
+        case Expr::Kind::AND:
+        case Expr::Kind::OR: {
+            // A AND (B AND C) becomes one AND of three
+            BoundPredicate out;
+            out.kind = expr.kind == Expr::Kind::AND ? Kind::AND : Kind::OR;
+            for (const auto& childExpr : expr.children) {
+                BoundPredicate child = bind(columns, *childExpr, runSubquery);
+                if (!absorb(out, child)) return child;
+            }
+            return collapse(std::move(out));
+        }
+    }
+    return constant(false);
+}
+
+BoundPredicate BoundPredicate::bindAll(const std::vector<Column>& columns, const std::vector<const Expr*>& terms,
+                                       const SubqueryRunner& runSubquery) {
+    BoundPredicate out;
+    out.kind = Kind::AND;
+    for (const Expr* term : terms) {
+        BoundPredicate child = bind(columns, *term, runSubquery);
+        if (!absorb(out, child)) return child;
+    }
+    return collapse(std::move(out));
+}
+
+BoundPredicate::Truth BoundPredicate::test(const Row& row) const {
+    switch (kind) {
+        case Kind::CONSTANT:
+            return value ? Truth::YES : Truth::NO;
+        case Kind::COMPARE: {
+            const Value& cell = row.values[column];
+            if (cell.isNull()) return Truth::UNKNOWN;
+            if (cell.type() != literal.type()) return Truth::NO;
+            bool holds = false;
+            switch (op) {
+                case Op::EQ: holds = cell == literal; break;
+                case Op::NE: holds = cell != literal; break;
+                case Op::LT: holds = cell < literal; break;
+                case Op::GT: holds = literal < cell; break;
+                case Op::LE: holds = !(literal < cell); break;
+                case Op::GE: holds = !(cell < literal); break;
+            }
+            return holds ? Truth::YES : Truth::NO;
+        }
+        case Kind::IN: {
+            // inner_col = NULL never holds, so EXISTS just finds no row
+            const Value& cell = row.values[column];
+            if (values.contains(cell)) return Truth::YES;
+            if (exists) return Truth::NO;
+            return cell.isNull() || values.hasNull() ? Truth::UNKNOWN : Truth::NO;
+        }
+        case Kind::AND: {
+            Truth result = Truth::YES;
+            for (const auto& child : children) {
+                Truth t = child.test(row);
+                if (t == Truth::NO) return Truth::NO;
+                if (t == Truth::UNKNOWN) result = Truth::UNKNOWN;
+            }
+            return result;
+        }
+        case Kind::OR: {
+            Truth result = Truth::NO;
+            for (const auto& child : children) {
+                Truth t = child.test(row);
+                if (t == Truth::YES) return Truth::YES;
+                if (t == Truth::UNKNOWN) result = Truth::UNKNOWN;
+            }
+            return result;
+        }
+        case Kind::NOT:
+            switch (children[0].test(row)) {
+                case Truth::YES: return Truth::NO;
+                case Truth::NO: return Truth::YES;
+                case Truth::UNKNOWN: return Truth::UNKNOWN;
+            }
+    }
+    return Truth::NO;
+}
+
+std::vector<const BoundPredicate*> BoundPredicate::conjuncts() const {
+    std::vector<const BoundPredicate*> terms;
+    if (kind == Kind::AND) {
+        for (const auto& child : children) terms.push_back(&child);
+    } else {
+        terms.push_back(this);
+    }
+    return terms;
+}
+
+} // namespace spl
@@ -0,0 +1,94 @@
+#ifndef SPL_BOUNDPREDICATE_H
+#define SPL_BOUNDPREDICATE_H
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <unordered_set>
+#include <vector>
+#include "../parser/AST.h"
+#include "../storage/StorageStructs.h"
+#include "../utils/SimdFilter.h"
+
+namespace spl {
+
+// The values of an IN list or subquery, hashed by type: checking a cell is
+// one lookup, without comparing Values. INTs live in an open addressing
+// table (linear probing, at most half full), which builds several times
+// faster than a node based set for the million-row subqueries of a semi join.
+// NULLs are not stored, only remembered: they decide whether a miss is FALSE
+// or UNKNOWN.
+class ValueSet {
+public:
+    void insert(const Value& value);
+    bool contains(const Value& value) const;
+    bool hasNull() const { return sawNull; }
+    bool empty() const { return intCount == 0 && strings.empty(); }
+    size_t size() const { return intCount + strings.size(); }
+
+private:
+    void insertInt(int64_t value);
+    size_t slotOf(int64_t value) const;
+
+    std::vector<int64_t> intSlots;
+    std::vector<uint8_t> intUsed;
+    size_t intCount = 0;
+    std::unordered_set<std::string> strings;
+    bool sawNull = false;
+};
+
+// A WHERE clause bound to the columns of its input once per query: column
+// names are resolved to indices and literals converted to the column's type,
+// so checking a row does no parsing or lookups.
+//
+// A column the input does not have (or a bare name several join columns
+// end in) is an error, thrown while binding so the statement never runs. A
+// comparison that can never hold (non-numeric literal for an INT column)
+// binds to a FALSE constant, and constants are folded into their parents.
+//
+// Logic is SQL's three-valued one: a comparison or IN on a NULL cell is
+// UNKNOWN, as is an IN that misses a list holding NULL. NOT keeps UNKNOWN,
+// AND and OR combine it as usual, and a row passes only if the whole WHERE
+// is TRUE. So `NOT (c = 5)` skips NULL `c`, and `x NOT IN (SELECT y ...)`
+// passes nothing once `y` has a NULL. A decorrelated EXISTS is never
+// UNKNOWN.
+//
+// Subqueries run once, while binding. `col IN (SELECT ...)` keeps the
+// subquery's first column in a ValueSet, which makes the filter a hash semi
+// join (an anti join under NOT). EXISTS is a constant, unless the subquery's
+// WHERE has an `inner_col = outer.col` term; then it binds as
+// `outer.col IN (SELECT inner_col ...)` without that term.
+struct BoundPredicate {
+    enum class Kind { CONSTANT, COMPARE, IN, AND, OR, NOT };
+    enum class Truth { NO, YES, UNKNOWN };
+    using Op = CompareOp;
+
+    // Runs a subquery, handing its rows to `each` until that returns false.
+    using SubqueryRunner = std::function<void(SelectStatement*, const std::function<bool(const Row&)>& each)>;
+
+    static BoundPredicate bind(const std::vector<Column>& columns, const Expr& expr,
+                               const SubqueryRunner& runSubquery);
+    // The AND of `terms`; TRUE if there are none.
+    static BoundPredicate bindAll(const std::vector<Column>& columns, const std::vector<const Expr*>& terms,
+                                  const SubqueryRunner& runSubquery);
+    static BoundPredicate constant(bool value);
+
+    // Whether the row passes: the predicate is TRUE for it.
+    bool evaluate(const Row& row) const { return test(row) == Truth::YES; }
+    Truth test(const Row& row) const;
+    // The terms that must all hold: the children of an AND, or the predicate itself.
+    std::vector<const BoundPredicate*> conjuncts() const;
+
+    Kind kind = Kind::CONSTANT;
+    bool value = true;                    // CONSTANT
+    int column = -1;                      // COMPARE, IN
+    Op op = Op::EQ;                       // COMPARE
+    Value literal;                        // COMPARE
+    ValueSet values;                      // IN
+    bool exists = false;                  // IN: a decorrelated EXISTS, FALSE rather than UNKNOWN
+    std::vector<BoundPredicate> children; // AND, OR (flattened), NOT
+};
+
+} // namespace spl
+
+#endif // SPL_BOUNDPREDICATE_H
@@ -0,0 +1,76 @@
+#include "CostModel.h"
+#include <algorithm>
+
+namespace spl {
+
+double CostModel::selectivity(const BoundPredicate& where, const TableStats* stats) {
+    using Kind = BoundPredicate::Kind;
+    const ColumnStats* column = nullptr;
+    if (stats && where.column >= 0 && static_cast<size_t>(where.column) < stats->columns.size()) {
+        column = &stats->columns[where.column];
+    }
+    switch (where.kind) {
+        case Kind::CONSTANT:
+            return where.value ? 1.0 : 0.0;
+        case Kind::COMPARE:
+            if (column) return column->selectivity(where.op, where.literal);
+            if (where.op == CompareOp::EQ) return DEFAULT_EQUAL;
+            if (where.op == CompareOp::NE) return 1.0 - DEFAULT_EQUAL;
+            return DEFAULT_RANGE;
+        case Kind::IN: {
+            // Each value is taken to be as common as an average one
+            double each = DEFAULT_EQUAL;
+            if (column) each = (1.0 - column->nullFraction) / std::max(1.0, column->distinct);
+            return std::min(1.0, each * where.values.size());
+        }
+        case Kind::AND: {
+            double result = 1.0;
+            for (const auto& child : where.children) result *= selectivity(child, stats);
+            return result;
+        }
+        case Kind::OR: {
+            double none = 1.0;
+            for (const auto& child : where.children) none *= 1.0 - selectivity(child, stats);
+            return 1.0 - none;
+        }
+        case Kind::NOT:
+            return 1.0 - selectivity(where.children[0], stats);
+    }
+    return 1.0;
+}
+
+double CostModel::rangeSelectivity(const std::vector<const BoundPredicate*>& terms, const ColumnStats& stats) {
+    // A lower and an upper bound overlap in what lies between them
+    double equal = 1.0, lower = 1.0, upper = 1.0;
+    bool hasLower = false, hasUpper = false;
+    for (const BoundPredicate* term : terms) {
+        double s = stats.selectivity(term->op, term->literal);
+        if (term->op == CompareOp::EQ) {
+            equal = std::min(equal, s);
+        } else if (term->op == CompareOp::GT || term->op == CompareOp::GE) {
+            lower = std::min(lower, s);
+            hasLower = true;
+        } else if (term->op == CompareOp::LT || term->op == CompareOp::LE) {
+            upper = std::min(upper, s);
+            hasUpper = true;
+        }
+    }
+    double range = std::min(lower, upper);
+    if (hasLower && hasUpper) range = std::max(0.0, lower + upper - (1.0 - stats.nullFraction));
+    return std::min(equal, range);
+}
+
+double CostModel::scanCost(double rows, size_t workers) {
+    return rows / std::max<size_t>(1, workers);
+}
+
+double CostModel::indexScanCost(double matches) {
+    return INDEX_PROBE_COST + matches * RANDOM_ROW_COST;
+}
+
+double CostModel::joinRows(double left, double right, double leftDistinct, double rightDistinct) {
+    double distinct = std::max(1.0, std::max(leftDistinct, rightDistinct));
+    return left * right / distinct;
+}
+
+} // namespace spl
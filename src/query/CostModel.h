@@ -0,0 +1,38 @@
+#ifndef SPL_COSTMODEL_H
+#define SPL_COSTMODEL_H
+
+#include <vector>
+#include "BoundPredicate.h"
+#include "../storage/TableStats.h"
+
+namespace spl {
+
+// Row estimates and costs the planner compares plans with, from the
+// statistics of ANALYZE. Costs are in rows read by a sequential scan.
+// Without statistics, selectivities fall back on fixed guesses; the planner
+// then keeps its rule-based choices, so only analyzed tables change plans.
+class CostModel {
+public:
+    // A row fetched by id through an index: a random page read, not a sequential one
+    static constexpr double RANDOM_ROW_COST = 4.0;
+    // Descending the B+tree to the first key of a range
+    static constexpr double INDEX_PROBE_COST = 50.0;
+    static constexpr double DEFAULT_EQUAL = 0.005;
+    static constexpr double DEFAULT_RANGE = 1.0 / 3;
+
+    // Estimated fraction of a table's rows that pass `where`; `stats` may be null.
+    static double selectivity(const BoundPredicate& where, const TableStats* stats);
+    // Fraction of rows in the key range that `terms`, comparisons on one
+    // column ANDed together, leave to an index scan.
+    static double rangeSelectivity(const std::vector<const BoundPredicate*>& terms, const ColumnStats& stats);
+
+    static double scanCost(double rows, size_t workers);
+    static double indexScanCost(double matches);
+    // Rows of an equi-join given each side's rows and the distinct values of
+    // its key, assuming every key of the side with fewer finds a partner.
+    static double joinRows(double left, double right, double leftDistinct, double rightDistinct);
+};
+
+} // namespace spl
+
+#endif // SPL_COSTMODEL_H
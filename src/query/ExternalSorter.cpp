@@ -0,0 +1,163 @@
+#include "ExternalSorter.h"
+#include <atomic>
+#include <filesystem>
+
+namespace spl {
+
+namespace fs = std::filesystem;
+
+namespace {
+
+std::atomic<size_t> budget{64 * 1024 * 1024};
+
+} // namespace
+
+ExternalSorter::ExternalSorter(std::vector<SortColumn> keys) : sorter(std::move(keys)) {}
+
+ExternalSorter::~ExternalSorter() {
+    merge.reset();
+    readers.clear();
+    std::error_code ec;
+    for (const auto& path : runs) fs::remove(path, ec);
+}
+
+void ExternalSorter::setMemoryBudget(size_t bytes) {
+    budget = bytes;
+}
+
+size_t ExternalSorter::memoryBudget() {
+    return budget;
+}
+
+bool ExternalSorter::add(Row row) {
+    if (failed) return false;
+    bufferedBytes += rowMemory(row);
+    rows.push_back(std::move(row));
+    if (bufferedBytes > budget && !spill()) {
+        failed = true;
+        return false;
+    }
+    return true;
+}
+
+bool ExternalSorter::spill() {
+    std::string path = tempRowFile("sort");
+    runs.push_back(path);
+    RowFileWriter out;
+    if (!out.open(path)) return false;
+    std::string key;
+    for (uint32_t idx : sorter.order(rows)) {
+        sorter.encodeKey(rows[idx], key);
+        out.write(key, rows[idx]);
+    }
+    if (!out.close()) return false;
+    rows.clear();
+    bufferedBytes = 0;
+    return true;
+}
+
+bool ExternalSorter::finish() {
+    if (failed) return false;
+    if (runs.empty()) {
+        order = sorter.order(rows);
+        pos = 0;
+        return true;
+    }
+    if (!rows.empty() && !spill()) {
+        failed = true;
+        return false;
+    }
+    rows.clear();
+    rows.shrink_to_fit();
+    if (!reduceRuns()) return false;
+    return openMerge(runs);
+}
+
+bool ExternalSorter::openMerge(const std::vector<std::string>& paths) {
+    merge.reset();
+    readers.clear();
+    for (const auto& path : paths) {
+        auto reader = std::make_unique<RunReader>();
+        if (!reader->file.open(path) || !reader->advance()) return false;
+        readers.push_back(std::move(reader));
+    }
+    merge = std::make_unique<LoserTree>(readers);
+    return true;
+}
+
+bool ExternalSorter::reduceRuns() {
+    // Merging a prefix of the runs keeps earlier rows in earlier runs, so
+    // equal keys still come out in input order
+    while (runs.size() > MAX_FAN_IN) {
+        std::vector<std::string> inputs(runs.begin(), runs.begin() + MAX_FAN_IN);
+        if (!openMerge(inputs)) return false;
+        std::string path = tempRowFile("sort");
+        RowFileWriter out;
+        if (!out.open(path)) return false;
+        while (!merge->winner()->done) {
+            out.write(merge->winner()->key, merge->winner()->row);
+            if (!merge->pop()) return false;
+        }
+        if (!out.close()) return false;
+        merge.reset();
+        readers.clear();
+        std::error_code ec;
+        for (const auto& input : inputs) fs::remove(input, ec);
+        runs.erase(runs.begin(), runs.begin() + MAX_FAN_IN);
+        runs.insert(runs.begin(), path);
+    }
+    return true;
+}
+
+bool ExternalSorter::next(Row& row) {
+    if (!merge) {
+        if (pos >= order.size()) return false;
+        row = std::move(rows[order[pos++]]);
+        return true;
+    }
+    RunReader* top = merge->winner();
+    if (top->done) return false;
+    row = std::move(top->row);
+    return merge->pop();
+}
+
+bool ExternalSorter::RunReader::advance() {
+    if (file.next(key, row)) return true;
+    done = true;
+    return !file.failed();
+}
+
+ExternalSorter::LoserTree::LoserTree(std::vector<std::unique_ptr<RunReader>>& readers)
+    : readers(readers), tree(readers.size()) {
+    // Leaves sit at k..2k-1 of a heap-shaped tree; play it bottom up
+    size_t k = readers.size();
+    std::vector<size_t> winners(2 * k);
+    for (size_t i = 0; i < k; ++i) winners[k + i] = i;
+    for (size_t n = k - 1; n >= 1; --n) {
+        size_t a = winners[2 * n], b = winners[2 * n + 1];
+        winners[n] = less(b, a) ? b : a;
+        tree[n] = less(b, a) ? a : b;
+    }
+    tree[0] = winners[1];
+}
+
+bool ExternalSorter::LoserTree::less(size_t a, size_t b) const {
+    const RunReader& ra = *readers[a];
+    const RunReader& rb = *readers[b];
+    if (ra.done || rb.done) return !ra.done && rb.done;
+    int c = ra.key.compare(rb.key);
+    return c < 0 || (c == 0 && a < b);
+}
+
+bool ExternalSorter::LoserTree::pop() {
+    size_t winner = tree[0];
+    if (!readers[winner]->advance()) return false;
+    size_t k = readers.size();
+    for (size_t n = (winner + k) / 2; n >= 1; n /= 2) {
+        if (less(tree[n], winner)) std::swap(tree[n], winner);
+    }
+    tree[0] = winner;
+    return true;
+}
+
+} // namespace spl
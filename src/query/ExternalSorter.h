@@ -0,0 +1,84 @@
+#ifndef SPL_EXTERNALSORTER_H
+#define SPL_EXTERNALSORTER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "RowFile.h"
+#include "RowSorter.h"
+
+namespace spl {
+
+// Sorts a stream of rows in bounded memory. Rows are buffered until they
+// pass the sort budget (`.set sort_memory_mb`); then the buffer is sorted
+// with RowSorter and written out as a run, db/sort_<n>.run, holding each
+// row's normalized key and cells. If nothing was spilled the result comes
+// straight from memory; otherwise the runs are merged with a loser tree,
+// MAX_FAN_IN at a time, and the last merge streams to next().
+//
+// Runs are deleted as they are consumed and by the destructor; leftovers of
+// a crashed process are removed at startup by removeTempRowFiles.
+class ExternalSorter {
+public:
+    explicit ExternalSorter(std::vector<SortColumn> keys);
+    ~ExternalSorter();
+
+    bool add(Row row);
+    // Call once after the last add, before next.
+    bool finish();
+    bool next(Row& row);
+
+    size_t runCount() const { return runs.size(); }
+
+    static void setMemoryBudget(size_t bytes);
+    static size_t memoryBudget();
+
+    static constexpr size_t MAX_FAN_IN = 64;
+
+private:
+    // Reads one run back, a record at a time.
+    struct RunReader {
+        RowFileReader file;
+        std::string key;
+        Row row;
+        bool done = false;
+        bool advance();
+    };
+
+    // Tournament over the current record of each reader. tree[0] is the
+    // reader holding the smallest record, tree[1..k-1] the losers of each match.
+    class LoserTree {
+    public:
+        explicit LoserTree(std::vector<std::unique_ptr<RunReader>>& readers);
+        RunReader* winner() { return readers[tree[0]].get(); }
+        // Advances the winning reader and replays its path to the root.
+        bool pop();
+
+    private:
+        std::vector<std::unique_ptr<RunReader>>& readers;
+        std::vector<size_t> tree;
+        bool less(size_t a, size_t b) const;
+    };
+
+    RowSorter sorter;
+    std::vector<Row> rows;
+    size_t bufferedBytes = 0;
+    std::vector<uint32_t> order;
+    size_t pos = 0;
+
+    std::vector<std::string> runs;
+    std::vector<std::unique_ptr<RunReader>> readers;
+    std::unique_ptr<LoserTree> merge;
+    bool failed = false;
+
+    bool spill();
+    bool openMerge(const std::vector<std::string>& paths);
+    // Merges the first MAX_FAN_IN runs into one until a single merge is left.
+    bool reduceRuns();
+};
+
+} // namespace spl
+
+#endif // SPL_EXTERNALSORTER_H
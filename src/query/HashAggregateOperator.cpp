@@ -0,0 +1,437 @@
+#include "HashAggregateOperator.h"
+#include <algorithm>
+#include <atomic>
+#include <filesystem>
+#include <functional>
+#include <iostream>
+#include "../utils/TaskScheduler.h"
+
+namespace spl {
+
+namespace fs = std::filesystem;
+
+namespace {
+
+std::atomic<size_t> budget{64 * 1024 * 1024};
+
+// Per group on top of its key and cells: two slots, the hash and the key's end.
+const size_t GROUP_OVERHEAD = 2 * sizeof(uint32_t) + sizeof(uint64_t) + sizeof(size_t);
+
+uint64_t hashKey(std::string_view key) {
+    return std::hash<std::string_view>{}(key);
+}
+
+// Each level of partitioning uses the next 5 bits of the key's hash, from the
+// top: the low bits pick the slot in a group table.
+size_t partitionOf(uint64_t hash, int depth) {
+    return (hash >> (64 - 5 * (depth + 1))) % HashAggregateOperator::PARTITIONS;
+}
+
+std::vector<SortColumn> keyColumns(const std::vector<int>& columns) {
+    std::vector<SortColumn> keys;
+    for (int column : columns) keys.push_back({column, false});
+    return keys;
+}
+
+void removeFile(const std::string& path) {
+    std::error_code ec;
+    fs::remove(path, ec);
+}
+
+// Wraps on overflow instead of being undefined.
+int64_t addInt(int64_t a, int64_t b) {
+    return static_cast<int64_t>(static_cast<uint64_t>(a) + static_cast<uint64_t>(b));
+}
+
+} // namespace
+
+std::string_view HashAggregateOperator::GroupTable::key(size_t group) const {
+    size_t begin = group == 0 ? 0 : keyEnds[group - 1];
+    return std::string_view(keyBytes).substr(begin, keyEnds[group] - begin);
+}
+
+void HashAggregateOperator::GroupTable::clear() {
+    *this = GroupTable();
+}
+
+HashAggregateOperator::HashAggregateOperator(std::unique_ptr<Operator> child, std::vector<int> groupColumns,
+                                             std::vector<AggregateSpec> aggregates, std::vector<Column> columns)
+    : child(std::move(child)),
+      groupColumns(std::move(groupColumns)),
+      aggregates(std::move(aggregates)),
+      groupKey(keyColumns(this->groupColumns)) {
+    outputColumns = std::move(columns);
+}
+
+HashAggregateOperator::~HashAggregateOperator() {
+    removeFiles();
+}
+
+void HashAggregateOperator::setMemoryBudget(size_t bytes) {
+    budget = bytes;
+}
+
+size_t HashAggregateOperator::memoryBudget() {
+    return budget;
+}
+
+size_t HashAggregateOperator::findGroup(GroupTable& table, std::string_view key, uint64_t hash,
+                                        bool& added) const {
+    if ((table.size() + 1) * 2 > table.slots.size()) {
+        table.slots.assign(std::max<size_t>(64, table.slots.size() * 2), 0);
+        size_t mask = table.slots.size() - 1;
+        for (size_t group = 0; group < table.size(); ++group) {
+            size_t slot = table.hashes[group] & mask;
+            while (table.slots[slot]) slot = (slot + 1) & mask;
+            table.slots[slot] = static_cast<uint32_t>(group + 1);
+        }
+    }
+
+    size_t mask = table.slots.size() - 1;
+    size_t slot = hash & mask;
+    while (uint32_t entry = table.slots[slot]) {
+        size_t group = entry - 1;
+        if (table.hashes[group] == hash && table.key(group) == key) {
+            added = false;
+            return group;
+        }
+        slot = (slot + 1) & mask;
+    }
+
+    added = true;
+    size_t group = table.size();
+    table.slots[slot] = static_cast<uint32_t>(group + 1);
+    table.hashes.push_back(hash);
+    table.keyBytes.append(key);
+    table.keyEnds.push_back(table.keyBytes.size());
+    table.keyCells.resize(table.keyCells.size() + groupColumns.size());
+    table.states.resize(table.states.size() + aggregates.size());
+    table.bytes += key.size() + groupColumns.size() * sizeof(Value) + aggregates.size() * sizeof(Accumulator) +
+                   GROUP_OVERHEAD;
+    return group;
+}
+
+void HashAggregateOperator::accumulate(GroupTable& table, const Row& row, std::string& key) {
+    groupKey.encodeKey(row, key);
+    bool added;
+    size_t group = findGroup(table, key, hashKey(key), added);
+    if (added) {
+        Value* cells = &table.keyCells[group * groupColumns.size()];
+        for (int column : groupColumns) {
+            *cells = row.values[column];
+            if (cells->isString()) table.bytes += cells->asString().size();
+            cells++;
+        }
+    }
+    Accumulator* state = &table.states[group * aggregates.size()];
+    for (const auto& agg : aggregates) {
+        Accumulator& acc = *state++;
+        if (agg.column < 0) {
+            acc.count++;
+            continue;
+        }
+        const Value& cell = row.values[agg.column];
+        if (cell.isNull()) continue;
+        acc.count++;
+        switch (agg.function) {
+            case AggregateFunction::SUM:
+            case AggregateFunction::AVG:
+                if (cell.isInt()) acc.sum = addInt(acc.sum, cell.asInt());
+                break;
+            case AggregateFunction::MIN:
+                if (acc.value.isNull() || cell < acc.value) acc.value = cell;
+                break;
+            case AggregateFunction::MAX:
+                if (acc.value.isNull() || acc.value < cell) acc.value = cell;
+                break;
+            case AggregateFunction::COUNT:
+                break;
+        }
+    }
+}
+
+void HashAggregateOperator::merge(Accumulator& into, const Accumulator& from, AggregateFunction function) {
+    into.count += from.count;
+    into.sum = addInt(into.sum, from.sum);
+    if (from.value.isNull()) return;
+    bool replace = into.value.isNull() ||
+                   (function == AggregateFunction::MIN ? from.value < into.value : into.value < from.value);
+    if (replace) into.value = from.value;
+}
+
+void HashAggregateOperator::mergeTable(GroupTable& into, GroupTable& from) {
+    size_t width = groupColumns.size();
+    bool added;
+    for (size_t group = 0; group < from.size(); ++group) {
+        size_t target = findGroup(into, from.key(group), from.hashes[group], added);
+        if (added) {
+            for (size_t i = 0; i < width; ++i) {
+                Value& cell = into.keyCells[target * width + i];
+                cell = std::move(from.keyCells[group * width + i]);
+                if (cell.isString()) into.bytes += cell.asString().size();
+            }
+        }
+        for (size_t i = 0; i < aggregates.size(); ++i) {
+            merge(into.states[target * aggregates.size() + i], from.states[group * aggregates.size() + i],
+                  aggregates[i].function);
+        }
+    }
+    from.clear();
+}
+
+void HashAggregateOperator::writeGroup(const GroupTable& table, size_t group, Row& record) const {
+    size_t width = groupColumns.size();
+    record.values.assign(table.keyCells.begin() + group * width, table.keyCells.begin() + (group + 1) * width);
+    const Accumulator* state = &table.states[group * aggregates.size()];
+    for (size_t i = 0; i < aggregates.size(); ++i, ++state) {
+        record.values.push_back(Value(state->count));
+        record.values.push_back(Value(state->sum));
+        record.values.push_back(state->value);
+    }
+}
+
+void HashAggregateOperator::readGroup(GroupTable& table, const std::string& key, Row& record) {
+    size_t width = groupColumns.size();
+    bool added;
+    size_t group = findGroup(table, key, hashKey(key), added);
+    if (added) {
+        for (size_t i = 0; i < width; ++i) {
+            Value& cell = table.keyCells[group * width + i];
+            cell = std::move(record.values[i]);
+            if (cell.isString()) table.bytes += cell.asString().size();
+        }
+    }
+    Accumulator state;
+    for (size_t i = 0; i < aggregates.size(); ++i) {
+        state.count = record.values[width + 3 * i].asInt();
+        state.sum = record.values[width + 3 * i + 1].asInt();
+        state.value = std::move(record.values[width + 3 * i + 2]);
+        merge(table.states[group * aggregates.size() + i], state, aggregates[i].function);
+    }
+}
+
+void HashAggregateOperator::open() {
+    close();
+    size_t threads = TaskScheduler::instance().workers();
+    partials.resize(threads);
+    child->open();
+    try {
+        consume(threads);
+    } catch (...) {
+        child->close();
+        close();
+        throw;
+    }
+    child->close();
+
+    if (!spillFiles.empty() || spillFailed) {
+        bool ok = !spillFailed;
+        for (auto& table : partials) {
+            if (ok) spillTable(table, spillFiles, 0);
+        }
+        for (auto& file : spillFiles) ok = file.close() && ok;
+        spillFiles.clear();
+        partials.clear();
+        if (!ok) fail();
+        // next() merges the partitions one by one
+        return;
+    }
+
+    size_t biggest = 0;
+    for (size_t i = 1; i < partials.size(); ++i) {
+        if (partials[i].size() > partials[biggest].size()) biggest = i;
+    }
+    result = std::move(partials[biggest]);
+    for (size_t i = 0; i < partials.size(); ++i) {
+        if (i != biggest) mergeTable(result, partials[i]);
+    }
+    partials.clear();
+    if (groupColumns.empty() && result.size() == 0) {
+        bool added;
+        findGroup(result, std::string_view(), hashKey(std::string_view()), added);
+    }
+}
+
+void HashAggregateOperator::consume(size_t threads) {
+    size_t share = budget / threads;
+    TaskGroup group;
+    bool parallel = false;
+
+    std::vector<Row> batch;
+    batch.reserve(BATCH_ROWS);
+    Row row;
+    std::string key;
+    size_t inlineRows = 0;
+    while (child->next(row)) {
+        // The first batch is aggregated on this thread, so small inputs
+        // use no workers; with one worker, everything is
+        if (!parallel && (threads == 1 || inlineRows < BATCH_ROWS)) {
+            inlineRows++;
+            accumulate(partials[0], row, key);
+            if (partials[0].bytes > share) spillShared(partials[0]);
+            continue;
+        }
+        parallel = true;
+        batch.push_back(std::move(row));
+        if (batch.size() < BATCH_ROWS) continue;
+        aggregateBatch(group, std::move(batch), share);
+        batch = std::vector<Row>();
+        batch.reserve(BATCH_ROWS);
+        // Stay at most two batches per worker ahead
+        group.wait(threads * 2);
+    }
+    if (!batch.empty()) aggregateBatch(group, std::move(batch), share);
+    group.wait();
+}
+
+void HashAggregateOperator::aggregateBatch(TaskGroup& group, std::vector<Row> batch, size_t share) {
+    auto rows = std::make_shared<std::vector<Row>>(std::move(batch));
+    group.run([this, rows, share] {
+        // Tasks run on workers, one at a time each: the worker's table is its own
+        GroupTable& table = partials[TaskScheduler::currentWorker()];
+        std::string key;
+        for (const auto& row : *rows) accumulate(table, row, key);
+        if (table.bytes > share) spillShared(table);
+    });
+}
+
+void HashAggregateOperator::spillShared(GroupTable& table) {
+    std::lock_guard<std::mutex> lock(spillMutex);
+    if (spillFiles.empty() && !spillFailed) spillFailed = !openPartitions(0, spillFiles);
+    if (spillFailed) {
+        // The query fails once the input is read; stop holding on to memory
+        table.clear();
+        return;
+    }
+    spillTable(table, spillFiles, 0);
+}
+
+bool HashAggregateOperator::openPartitions(int depth, std::vector<RowFileWriter>& files) {
+    files.resize(PARTITIONS);
+    for (size_t i = 0; i < PARTITIONS; ++i) {
+        Partition part{tempRowFile("agg"), depth};
+        pending.push_back(part);
+        if (!files[i].open(part.path)) return false;
+    }
+    return true;
+}
+
+void HashAggregateOperator::spillTable(GroupTable& table, std::vector<RowFileWriter>& files, int depth) {
+    Row record;
+    std::string key;
+    for (size_t group = 0; group < table.size(); ++group) {
+        writeGroup(table, group, record);
+        key = table.key(group);
+        files[partitionOf(table.hashes[group], depth)].write(key, record);
+    }
+    table.clear();
+}
+
+bool HashAggregateOperator::loadPartition(bool& loaded) {
+    loaded = false;
+    result.clear();
+    pos = 0;
+
+    std::string key;
+    Row record;
+    while (!pending.empty()) {
+        Partition part = pending.back();
+        pending.pop_back();
+
+        RowFileReader in;
+        if (!in.open(part.path)) {
+            removeFile(part.path);
+            return false;
+        }
+        bool split = false;
+        while (!split && in.next(key, record)) {
+            readGroup(result, key, record);
+            split = result.bytes > budget && part.depth + 1 < MAX_DEPTH;
+        }
+        if (in.failed()) {
+            removeFile(part.path);
+            return false;
+        }
+
+        if (!split) {
+            removeFile(part.path);
+            if (result.size() == 0) continue;
+            loaded = true;
+            return true;
+        }
+
+        // Still over budget: split again on the next hash bits
+        int depth = part.depth + 1;
+        std::vector<RowFileWriter> files;
+        bool ok = openPartitions(depth, files);
+        if (ok) {
+            spillTable(result, files, depth);
+            while (in.next(key, record)) files[partitionOf(hashKey(key), depth)].write(key, record);
+            ok = !in.failed();
+        }
+        for (auto& file : files) ok = file.close() && ok;
+        in = RowFileReader();
+        removeFile(part.path);
+        if (!ok) return false;
+    }
+    return true;
+}
+
+bool HashAggregateOperator::next(Row& row) {
+    while (pos >= result.size()) {
+        if (pending.empty()) return false;
+        bool loaded;
+        if (!loadPartition(loaded)) return fail();
+        if (!loaded) return false;
+    }
+    output(pos++, row);
+    return true;
+}
+
+void HashAggregateOperator::output(size_t group, Row& row) const {
+    size_t width = groupColumns.size();
+    row.values.assign(result.keyCells.begin() + group * width, result.keyCells.begin() + (group + 1) * width);
+    const Accumulator* state = &result.states[group * aggregates.size()];
+    for (const auto& agg : aggregates) {
+        const Accumulator& acc = *state++;
+        switch (agg.function) {
+            case AggregateFunction::COUNT:
+                row.values.push_back(Value(acc.count));
+                break;
+            case AggregateFunction::SUM:
+                row.values.push_back(acc.count > 0 ? Value(acc.sum) : Value());
+                break;
+            case AggregateFunction::AVG:
+                row.values.push_back(acc.count > 0 ? Value(acc.sum / acc.count) : Value());
+                break;
+            case AggregateFunction::MIN:
+            case AggregateFunction::MAX:
+                row.values.push_back(acc.value);
+                break;
+        }
+    }
+}
+
+void HashAggregateOperator::close() {
+    partials.clear();
+    result.clear();
+    pos = 0;
+    removeFiles();
+}
+
+void HashAggregateOperator::removeFiles() {
+    spillFiles.clear();
+    spillFailed = false;
+    for (const auto& part : pending) removeFile(part.path);
+    pending.clear();
+}
+
+bool HashAggregateOperator::fail() {
+    std::cout << "Error: could not write aggregate partitions to db/.\n";
+    result.clear();
+    pos = 0;
+    removeFiles();
+    return false;
+}
+
+} // namespace spl
@@ -0,0 +1,125 @@
+#ifndef SPL_HASHAGGREGATEOPERATOR_H
+#define SPL_HASHAGGREGATEOPERATOR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "Operators.h"
+#include "RowFile.h"
+#include "RowSorter.h"
+
+namespace spl {
+
+class TaskGroup;
+
+enum class AggregateFunction { COUNT, SUM, MIN, MAX, AVG };
+
+struct AggregateSpec {
+    AggregateFunction function;
+    int column; // -1 for COUNT(*)
+};
+
+// GROUP BY: one output row per distinct combination of the group columns
+// (NULLs form a group of their own), the group columns followed by one cell
+// per aggregate. Without group columns there is exactly one output row, even
+// for an empty input. NULL cells are skipped by every aggregate but COUNT(*);
+// SUM, MIN, MAX and AVG of no cells are NULL. AVG of INTs is an INT, rounded
+// toward zero.
+//
+// Blocking: open() reads the whole input. Rows are handed out in batches to
+// the TaskScheduler's workers, each with its own group table, and the
+// tables are merged at the end. A group table is open addressing on the hash
+// of the RowSorter encoded key, with keys and states in flat arrays, so adding
+// a group allocates nothing most of the time. A worker whose table outgrows its share of
+// the aggregate memory budget (`.set agg_memory_mb`) writes its partial
+// states to PARTITIONS files (db/agg_<n>.run) by key hash; each partition is
+// then merged and emitted on its own, split again if it still does not fit,
+// up to MAX_DEPTH levels deep.
+class HashAggregateOperator : public Operator {
+public:
+    static constexpr size_t PARTITIONS = 32;
+    static constexpr int MAX_DEPTH = 3;
+    static constexpr size_t BATCH_ROWS = 1024;
+
+    HashAggregateOperator(std::unique_ptr<Operator> child, std::vector<int> groupColumns,
+                          std::vector<AggregateSpec> aggregates, std::vector<Column> columns);
+    ~HashAggregateOperator() override;
+    void open() override;
+    bool next(Row& row) override;
+    void close() override;
+
+    static void setMemoryBudget(size_t bytes);
+    static size_t memoryBudget();
+
+private:
+    struct Accumulator {
+        int64_t count = 0;
+        int64_t sum = 0;
+        Value value; // MIN, MAX
+    };
+
+    struct GroupTable {
+        std::vector<uint32_t> slots;     // group + 1, 0 when free; at most half full
+        std::vector<uint64_t> hashes;    // per group
+        std::string keyBytes;            // encoded keys, back to back
+        std::vector<size_t> keyEnds;     // per group
+        std::vector<Value> keyCells;     // groupColumns.size() per group
+        std::vector<Accumulator> states; // aggregates.size() per group
+        size_t bytes = 0;
+
+        size_t size() const { return hashes.size(); }
+        std::string_view key(size_t group) const;
+        void clear();
+    };
+
+    struct Partition {
+        std::string path;
+        int depth;
+    };
+
+    std::unique_ptr<Operator> child;
+    std::vector<int> groupColumns;
+    std::vector<AggregateSpec> aggregates;
+    RowSorter groupKey;
+
+    std::vector<GroupTable> partials;
+    GroupTable result;
+    size_t pos = 0;
+
+    // Guards spillFiles, pending and spillFailed while the workers run.
+    std::mutex spillMutex;
+    std::vector<RowFileWriter> spillFiles;
+    bool spillFailed = false;
+    std::vector<Partition> pending;
+
+    // Index of the group with `key` in `table`. A new group is added with
+    // NULL key cells and empty states, and `added` set.
+    size_t findGroup(GroupTable& table, std::string_view key, uint64_t hash, bool& added) const;
+    void accumulate(GroupTable& table, const Row& row, std::string& key);
+    static void merge(Accumulator& into, const Accumulator& from, AggregateFunction function);
+    void mergeTable(GroupTable& into, GroupTable& from);
+    // A group's key cells and states as one record, and back.
+    void writeGroup(const GroupTable& table, size_t group, Row& record) const;
+    void readGroup(GroupTable& table, const std::string& key, Row& record);
+
+    // Reads the input into `partials`, one per worker.
+    void consume(size_t threads);
+    void aggregateBatch(TaskGroup& group, std::vector<Row> batch, size_t share);
+    bool openPartitions(int depth, std::vector<RowFileWriter>& files);
+    // Moves `table` into `files`; the table is empty afterwards.
+    void spillTable(GroupTable& table, std::vector<RowFileWriter>& files, int depth);
+    // Spills a worker's table into the shared first level partitions.
+    void spillShared(GroupTable& table);
+    bool loadPartition(bool& loaded);
+    void output(size_t group, Row& row) const;
+    void removeFiles();
+    bool fail();
+};
+
+} // namespace spl
+
+#endif // SPL_HASHAGGREGATEOPERATOR_H
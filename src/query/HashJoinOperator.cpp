@@ -0,0 +1,349 @@
+#include "HashJoinOperator.h"
+#include <atomic>
+#include <filesystem>
+#include <functional>
+#include <iostream>
+
+namespace spl {
+
+namespace fs = std::filesystem;
+
+namespace {
+
+std::atomic<size_t> budget{64 * 1024 * 1024};
+
+// Hash table overhead of an entry on top of its row: map node and chain link.
+const size_t ENTRY_OVERHEAD = 64;
+
+// Each level of partitioning uses the next 5 bits of the key's hash.
+size_t partitionOf(const std::string& key, int depth) {
+    return (std::hash<std::string>{}(key) >> (depth * 5)) % HashJoinOperator::PARTITIONS;
+}
+
+std::vector<SortColumn> keyColumns(const std::vector<int>& columns) {
+    std::vector<SortColumn> keys;
+    for (int column : columns) keys.push_back({column, false});
+    return keys;
+}
+
+void removeFile(const std::string& path) {
+    std::error_code ec;
+    fs::remove(path, ec);
+}
+
+} // namespace
+
+HashJoinOperator::HashJoinOperator(std::unique_ptr<Operator> left, std::unique_ptr<Operator> right,
+                                   std::vector<int> leftKeys, std::vector<int> rightKeys,
+                                   JoinType type, bool buildLeft, std::vector<Column> columns)
+    : build(buildLeft ? std::move(left) : std::move(right)),
+      probe(buildLeft ? std::move(right) : std::move(left)),
+      buildColumns(buildLeft ? std::move(leftKeys) : std::move(rightKeys)),
+      probeColumns(buildLeft ? std::move(rightKeys) : std::move(leftKeys)),
+      buildKey(keyColumns(buildColumns)),
+      probeKey(keyColumns(probeColumns)),
+      buildLeft(buildLeft),
+      keepProbe(type == JoinType::LEFT && !buildLeft),
+      keepBuild(type == JoinType::LEFT && buildLeft) {
+    leftWidth = (buildLeft ? build : probe)->columns().size();
+    rightWidth = (buildLeft ? probe : build)->columns().size();
+    outputColumns = std::move(columns);
+}
+
+HashJoinOperator::~HashJoinOperator() {
+    removeFiles();
+}
+
+void HashJoinOperator::setMemoryBudget(size_t bytes) {
+    budget = bytes;
+}
+
+size_t HashJoinOperator::memoryBudget() {
+    return budget;
+}
+
+bool HashJoinOperator::encodeKey(const RowSorter& sorter, const std::vector<int>& columns, const Row& row,
+                                 std::string& key) {
+    for (int column : columns) {
+        if (row.values[column].isNull()) return false;
+    }
+    sorter.encodeKey(row, key);
+    return true;
+}
+
+void HashJoinOperator::insert(const std::string& rowKey, Row row) {
+    uint32_t idx = static_cast<uint32_t>(entries.size());
+    uint32_t next = NONE;
+    // Rows without a key are kept for the NULL padding of a LEFT join only
+    if (!rowKey.empty()) {
+        auto head = heads.try_emplace(rowKey, idx);
+        if (!head.second) {
+            next = head.first->second;
+            head.first->second = idx;
+        }
+    }
+    tableBytes += rowMemory(row) + rowKey.size() + ENTRY_OVERHEAD;
+    entries.push_back({std::move(row), next, false});
+}
+
+void HashJoinOperator::clearTable() {
+    entries.clear();
+    entries.shrink_to_fit();
+    heads.clear();
+    heads.rehash(0);
+    tableBytes = 0;
+    match = NONE;
+    padProbe = false;
+}
+
+void HashJoinOperator::combine(const Row* buildSide, const Row* probeSide, Row& out) const {
+    const Row* left = buildLeft ? buildSide : probeSide;
+    const Row* right = buildLeft ? probeSide : buildSide;
+    out.values.clear();
+    out.values.reserve(leftWidth + rightWidth);
+    if (left) {
+        out.values.insert(out.values.end(), left->values.begin(), left->values.end());
+    } else {
+        out.values.resize(leftWidth);
+    }
+    if (right) {
+        out.values.insert(out.values.end(), right->values.begin(), right->values.end());
+    } else {
+        out.values.resize(leftWidth + rightWidth);
+    }
+}
+
+void HashJoinOperator::open() {
+    close();
+    std::vector<RowFileWriter> buildFiles, probeFiles;
+    bool spilled = false;
+    bool ok = true;
+    Row row;
+    std::string rowKey;
+
+    build->open();
+    while (ok && build->next(row)) {
+        if (!encodeKey(buildKey, buildColumns, row, rowKey)) {
+            if (!keepBuild) continue;
+            rowKey.clear();
+        }
+        if (spilled) {
+            buildFiles[partitionOf(rowKey, 0)].write(rowKey, row);
+            continue;
+        }
+        insert(rowKey, std::move(row));
+        if (tableBytes > budget) {
+            spilled = true;
+            ok = openPartitions(0, buildFiles, probeFiles);
+            if (ok) spillTable(buildFiles, 0);
+        }
+    }
+    build->close();
+    for (auto& file : buildFiles) ok = file.close() && ok;
+
+    probe->open();
+    probeOpen = true;
+    if (ok && spilled) {
+        ok = partitionProbe(probeFiles, 0);
+        probe->close();
+        probeOpen = false;
+    }
+    if (!ok) {
+        fail();
+        return;
+    }
+    phase = spilled ? Phase::NEXT_PARTITION : Phase::PROBE;
+}
+
+bool HashJoinOperator::readProbe() {
+    bool hasKey;
+    if (!probePath.empty()) {
+        if (!probeFile.next(key, probeRow)) return false;
+        hasKey = !key.empty();
+    } else {
+        if (!probe->next(probeRow)) return false;
+        hasKey = encodeKey(probeKey, probeColumns, probeRow, key);
+    }
+    match = NONE;
+    if (hasKey) {
+        auto head = heads.find(key);
+        if (head != heads.end()) match = head->second;
+    }
+    padProbe = keepProbe && match == NONE;
+    return true;
+}
+
+bool HashJoinOperator::next(Row& row) {
+    while (true) {
+        switch (phase) {
+            case Phase::PROBE:
+                if (match != NONE) {
+                    Entry& entry = entries[match];
+                    match = entry.next;
+                    entry.matched = true;
+                    combine(&entry.row, &probeRow, row);
+                    return true;
+                }
+                if (padProbe) {
+                    padProbe = false;
+                    combine(nullptr, &probeRow, row);
+                    return true;
+                }
+                if (readProbe()) break;
+                if (!probePath.empty() && probeFile.failed()) return fail();
+                unmatchedPos = 0;
+                phase = keepBuild ? Phase::UNMATCHED : Phase::NEXT_PARTITION;
+                break;
+            case Phase::UNMATCHED:
+                while (unmatchedPos < entries.size()) {
+                    const Entry& entry = entries[unmatchedPos++];
+                    if (!entry.matched) {
+                        combine(&entry.row, nullptr, row);
+                        return true;
+                    }
+                }
+                phase = Phase::NEXT_PARTITION;
+                break;
+            case Phase::NEXT_PARTITION: {
+                bool loaded;
+                if (!loadPartition(loaded)) return fail();
+                phase = loaded ? Phase::PROBE : Phase::DONE;
+                break;
+            }
+            case Phase::DONE:
+                return false;
+        }
+    }
+}
+
+void HashJoinOperator::close() {
+    if (probeOpen) {
+        probe->close();
+        probeOpen = false;
+    }
+    clearTable();
+    removeFiles();
+    phase = Phase::DONE;
+}
+
+bool HashJoinOperator::openPartitions(int depth, std::vector<RowFileWriter>& buildFiles,
+                                      std::vector<RowFileWriter>& probeFiles) {
+    buildFiles.resize(PARTITIONS);
+    probeFiles.resize(PARTITIONS);
+    for (size_t i = 0; i < PARTITIONS; ++i) {
+        Partition part{tempRowFile("join"), tempRowFile("join"), depth};
+        pending.push_back(part);
+        if (!buildFiles[i].open(part.buildPath) || !probeFiles[i].open(part.probePath)) return false;
+    }
+    return true;
+}
+
+void HashJoinOperator::spillTable(std::vector<RowFileWriter>& files, int depth) {
+    std::string rowKey;
+    for (const auto& entry : entries) {
+        if (!encodeKey(buildKey, buildColumns, entry.row, rowKey)) rowKey.clear();
+        files[partitionOf(rowKey, depth)].write(rowKey, entry.row);
+    }
+    clearTable();
+}
+
+bool HashJoinOperator::partitionProbe(std::vector<RowFileWriter>& files, int depth) {
+    Row row;
+    std::string rowKey;
+    while (probe->next(row)) {
+        if (!encodeKey(probeKey, probeColumns, row, rowKey)) {
+            if (!keepProbe) continue;
+            rowKey.clear();
+        }
+        files[partitionOf(rowKey, depth)].write(rowKey, row);
+    }
+    bool ok = true;
+    for (auto& file : files) ok = file.close() && ok;
+    return ok;
+}
+
+bool HashJoinOperator::loadPartition(bool& loaded) {
+    loaded = false;
+    clearTable();
+    if (!probePath.empty()) {
+        probeFile = RowFileReader();
+        removeFile(probePath);
+        probePath.clear();
+    }
+
+    std::string rowKey;
+    Row row;
+    while (!pending.empty()) {
+        Partition part = pending.back();
+        pending.pop_back();
+        // Owned by probePath or removed below from here on
+        probePath = part.probePath;
+
+        RowFileReader in;
+        if (!in.open(part.buildPath)) return false;
+        bool split = false;
+        while (!split && in.next(rowKey, row)) {
+            insert(rowKey, std::move(row));
+            split = tableBytes > budget && part.depth + 1 < MAX_DEPTH;
+        }
+        if (in.failed()) {
+            removeFile(part.buildPath);
+            return false;
+        }
+
+        if (!split) {
+            removeFile(part.buildPath);
+            if (entries.empty() && !keepProbe) {
+                // Nothing to join with and nothing to pad
+                removeFile(probePath);
+                probePath.clear();
+                continue;
+            }
+            if (!probeFile.open(probePath)) return false;
+            loaded = true;
+            return true;
+        }
+
+        // Still over budget: split both sides again on the next hash bits
+        int depth = part.depth + 1;
+        std::vector<RowFileWriter> buildFiles, probeFiles;
+        bool ok = openPartitions(depth, buildFiles, probeFiles);
+        if (ok) {
+            spillTable(buildFiles, depth);
+            while (in.next(rowKey, row)) buildFiles[partitionOf(rowKey, depth)].write(rowKey, row);
+            RowFileReader probeIn;
+            ok = !in.failed() && probeIn.open(probePath);
+            while (ok && probeIn.next(rowKey, row)) probeFiles[partitionOf(rowKey, depth)].write(rowKey, row);
+            ok = ok && !probeIn.failed();
+        }
+        for (auto& file : buildFiles) ok = file.close() && ok;
+        for (auto& file : probeFiles) ok = file.close() && ok;
+        in = RowFileReader();
+        removeFile(part.buildPath);
+        removeFile(probePath);
+        probePath.clear();
+        if (!ok) return false;
+    }
+    return true;
+}
+
+void HashJoinOperator::removeFiles() {
+    probeFile = RowFileReader();
+    if (!probePath.empty()) removeFile(probePath);
+    probePath.clear();
+    for (const auto& part : pending) {
+        removeFile(part.buildPath);
+        removeFile(part.probePath);
+    }
+    pending.clear();
+}
+
+bool HashJoinOperator::fail() {
+    std::cout << "Error: could not write join partitions to db/.\n";
+    clearTable();
+    removeFiles();
+    phase = Phase::DONE;
+    return false;
+}
+
+} // namespace spl
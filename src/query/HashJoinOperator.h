@@ -0,0 +1,105 @@
+#ifndef SPL_HASHJOINOPERATOR_H
+#define SPL_HASHJOINOPERATOR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "Operators.h"
+#include "RowFile.h"
+#include "RowSorter.h"
+
+namespace spl {
+
+enum class JoinType { INNER, LEFT };
+
+// Equi-join on one or more key columns. The build side (the smaller input,
+// by the planner's estimate) is read into a hash table on open(); the other
+// input is streamed through it by next(). Output rows are the left input's
+// cells followed by the right's. A LEFT join pads left rows without a match
+// with NULLs, whichever side was built. NULL keys match nothing.
+//
+// Past the join memory budget (`.set join_memory_mb`) both inputs are hash
+// partitioned into PARTITIONS files each (db/join_<n>.run) and joined one
+// pair of partitions at a time. A build partition that is still too big is
+// split again on other hash bits, up to MAX_DEPTH levels deep.
+class HashJoinOperator : public Operator {
+public:
+    static constexpr size_t PARTITIONS = 32;
+    static constexpr int MAX_DEPTH = 3;
+
+    HashJoinOperator(std::unique_ptr<Operator> left, std::unique_ptr<Operator> right,
+                     std::vector<int> leftKeys, std::vector<int> rightKeys,
+                     JoinType type, bool buildLeft, std::vector<Column> columns);
+    ~HashJoinOperator() override;
+    void open() override;
+    bool next(Row& row) override;
+    void close() override;
+
+    static void setMemoryBudget(size_t bytes);
+    static size_t memoryBudget();
+
+private:
+    static constexpr uint32_t NONE = UINT32_MAX;
+
+    struct Entry {
+        Row row;
+        uint32_t next; // next entry with the same key
+        bool matched;
+    };
+
+    struct Partition {
+        std::string buildPath;
+        std::string probePath;
+        int depth;
+    };
+
+    enum class Phase { PROBE, UNMATCHED, NEXT_PARTITION, DONE };
+
+    std::unique_ptr<Operator> build, probe;
+    std::vector<int> buildColumns, probeColumns;
+    RowSorter buildKey, probeKey;
+    bool buildLeft;
+    bool keepProbe; // LEFT join probing with the left input
+    bool keepBuild; // LEFT join built on the left input
+    size_t leftWidth, rightWidth;
+
+    std::vector<Entry> entries;
+    std::unordered_map<std::string, uint32_t> heads;
+    size_t tableBytes = 0;
+
+    std::vector<Partition> pending;
+    std::string probePath; // partition being probed, empty while probing the input
+    RowFileReader probeFile;
+    bool probeOpen = false;
+
+    Phase phase = Phase::DONE;
+    Row probeRow;
+    std::string key;
+    uint32_t match = NONE;
+    bool padProbe = false;
+    size_t unmatchedPos = 0;
+
+    // Encodes the key columns of `row`; false if one of them is NULL.
+    static bool encodeKey(const RowSorter& sorter, const std::vector<int>& columns, const Row& row,
+                          std::string& key);
+    void insert(const std::string& key, Row row);
+    void clearTable();
+    void combine(const Row* buildRow, const Row* probeRow, Row& out) const;
+    bool readProbe();
+
+    // Opens PARTITIONS new build and probe files at `depth`, queued in `pending`.
+    bool openPartitions(int depth, std::vector<RowFileWriter>& buildFiles, std::vector<RowFileWriter>& probeFiles);
+    // Moves the hash table into `files`; the table is empty afterwards.
+    void spillTable(std::vector<RowFileWriter>& files, int depth);
+    bool partitionProbe(std::vector<RowFileWriter>& files, int depth);
+    bool loadPartition(bool& loaded);
+    void removeFiles();
+    bool fail();
+};
+
+} // namespace spl
+
+#endif // SPL_HASHJOINOPERATOR_H
@@ -0,0 +1,208 @@
+#include "Operators.h"
+#include <algorithm>
+#include <iostream>
+#include "../storage/StorageManager.h"
+
+namespace spl {
+
+ScanOperator::ScanOperator(const Table& schema, const std::vector<bool>& needed,
+                           std::vector<ZonePredicate> where, std::vector<IntComparison> intFilter)
+    : schema(schema), needed(needed), where(std::move(where)), intFilter(std::move(intFilter)) {
+    outputColumns = schema.columns;
+}
+
+void ScanOperator::open() {
+    cursor = StorageManager::openCursor(schema, needed, where, intFilter);
+}
+
+bool ScanOperator::next(Row& row) {
+    return cursor && cursor->next(row);
+}
+
+void ScanOperator::close() {
+    cursor.reset();
+}
+
+IndexScanOperator::IndexScanOperator(const Table& schema, const std::string& indexPath,
+                                     std::optional<std::string> low, std::optional<std::string> high)
+    : schema(schema), indexPath(indexPath), low(std::move(low)), high(std::move(high)) {
+    outputColumns = schema.columns;
+}
+
+void IndexScanOperator::open() {
+    BPlusTree tree(indexPath);
+    cursor = tree.scan(low ? &*low : nullptr, high ? &*high : nullptr);
+}
+
+bool IndexScanOperator::next(Row& row) {
+    uint64_t rid;
+    while (cursor && cursor->next(rid)) {
+        if (StorageManager::fetchRow(schema, rid, row)) return true;
+    }
+    return false;
+}
+
+void IndexScanOperator::close() {
+    cursor.reset();
+}
+
+SubqueryScanOperator::SubqueryScanOperator(std::unique_ptr<Operator> child) : child(std::move(child)) {
+    outputColumns = this->child->columns();
+}
+
+void SubqueryScanOperator::open() {
+    child->open();
+}
+
+bool SubqueryScanOperator::next(Row& row) {
+    return child->next(row);
+}
+
+void SubqueryScanOperator::close() {
+    child->close();
+}
+
+FilterOperator::FilterOperator(std::unique_ptr<Operator> child, Predicate predicate)
+    : child(std::move(child)), predicate(std::move(predicate)) {
+    outputColumns = this->child->columns();
+}
+
+void FilterOperator::open() {
+    child->open();
+}
+
+bool FilterOperator::next(Row& row) {
+    while (child->next(row)) {
+        if (predicate(row)) return true;
+    }
+    return false;
+}
+
+void FilterOperator::close() {
+    child->close();
+}
+
+ProjectOperator::ProjectOperator(std::unique_ptr<Operator> child, const std::vector<int>& indices)
+    : child(std::move(child)), indices(indices) {
+    for (int idx : indices) {
+        outputColumns.push_back(this->child->columns()[idx]);
+    }
+}
+
+void ProjectOperator::open() {
+    child->open();
+}
+
+bool ProjectOperator::next(Row& row) {
+    if (!child->next(input)) return false;
+    row.values.clear();
+    for (int idx : indices) {
+        row.values.push_back(std::move(input.values[idx]));
+    }
+    return true;
+}
+
+void ProjectOperator::close() {
+    child->close();
+}
+
+SortOperator::SortOperator(std::unique_ptr<Operator> child, std::vector<SortColumn> keys)
+    : child(std::move(child)), keys(std::move(keys)) {
+    outputColumns = this->child->columns();
+}
+
+void SortOperator::open() {
+    child->open();
+    sorter = std::make_unique<ExternalSorter>(keys);
+    Row row;
+    bool ok = true;
+    while (ok && child->next(row)) {
+        ok = sorter->add(std::move(row));
+    }
+    child->close();
+    if (!ok || !sorter->finish()) {
+        std::cout << "Error: could not write sort runs to db/.\n";
+        sorter.reset();
+    }
+}
+
+bool SortOperator::next(Row& row) {
+    return sorter && sorter->next(row);
+}
+
+void SortOperator::close() {
+    sorter.reset();
+}
+
+TopNOperator::TopNOperator(std::unique_ptr<Operator> child, std::vector<SortColumn> keys, size_t count)
+    : child(std::move(child)), sorter(std::move(keys)), count(count) {
+    outputColumns = this->child->columns();
+}
+
+void TopNOperator::open() {
+    heap.clear();
+    pos = 0;
+    child->open();
+    Entry entry;
+    uint64_t seq = 0;
+    while (count > 0 && child->next(entry.row)) {
+        sorter.encodeKey(entry.row, entry.key);
+        entry.seq = seq++;
+        if (heap.size() < count) {
+            heap.push_back(std::move(entry));
+            std::push_heap(heap.begin(), heap.end());
+        } else if (entry < heap.front()) {
+            // The largest kept row drops out
+            std::pop_heap(heap.begin(), heap.end());
+            heap.back() = std::move(entry);
+            std::push_heap(heap.begin(), heap.end());
+        }
+    }
+    child->close();
+    std::sort_heap(heap.begin(), heap.end());
+}
+
+bool TopNOperator::next(Row& row) {
+    if (pos >= heap.size()) return false;
+    row = std::move(heap[pos++].row);
+    return true;
+}
+
+void TopNOperator::close() {
+    heap.clear();
+    heap.shrink_to_fit();
+}
+
+LimitOperator::LimitOperator(std::unique_ptr<Operator> child, long long limit, long long offset)
+    : child(std::move(child)), limit(limit), offset(offset) {
+    outputColumns = this->child->columns();
+}
+
+void LimitOperator::open() {
+    returned = 0;
+    child->open();
+    childOpen = true;
+    for (long long skipped = 0; skipped < offset; ++skipped) {
+        Row row;
+        if (!child->next(row)) break;
+    }
+}
+
+bool LimitOperator::next(Row& row) {
+    if (!childOpen) return false;
+    if (limit >= 0 && returned >= limit) {
+        close();
+        return false;
+    }
+    if (!child->next(row)) return false;
+    returned++;
+    return true;
+}
+
+void LimitOperator::close() {
+    if (!childOpen) return;
+    child->close();
+    childOpen = false;
+}
+
+} // namespace spl
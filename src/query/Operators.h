@@ -0,0 +1,173 @@
+#ifndef SPL_OPERATORS_H
+#define SPL_OPERATORS_H
+
+#include <functional>
+#include <memory>
+#include <optional>
+#include <vector>
+#include "../storage/BPlusTree.h"
+#include "../storage/StorageStructs.h"
+#include "../storage/TableCursor.h"
+#include "../storage/ZoneMap.h"
+#include "ExternalSorter.h"
+
+namespace spl {
+
+// Pull-based (Volcano style) operator. A SELECT is compiled into a tree of
+// these; the root is pulled with next() until it runs dry, so rows stream from
+// storage to output without materializing the table in between.
+class Operator {
+public:
+    virtual ~Operator() = default;
+
+    virtual void open() = 0;
+    virtual bool next(Row& row) = 0;
+    virtual void close() = 0;
+
+    const std::vector<Column>& columns() const { return outputColumns; }
+
+protected:
+    std::vector<Column> outputColumns;
+};
+
+class ScanOperator : public Operator {
+public:
+    // `needed` limits which columns are read; skipped cells come back NULL.
+    // `where` lets the scan skip blocks the zone map rules out; `intFilter`
+    // is pushed into the cursor (see StorageManager::openCursor).
+    ScanOperator(const Table& schema, const std::vector<bool>& needed = {},
+                 std::vector<ZonePredicate> where = {}, std::vector<IntComparison> intFilter = {});
+    void open() override;
+    bool next(Row& row) override;
+    void close() override;
+
+private:
+    Table schema;
+    std::vector<bool> needed;
+    std::vector<ZonePredicate> where;
+    std::vector<IntComparison> intFilter;
+    std::unique_ptr<TableCursor> cursor;
+};
+
+// Fetches the rows whose index key lies in [low, high]; either bound may be
+// missing. Keys can be truncated, so a FilterOperator must re-check the rows.
+class IndexScanOperator : public Operator {
+public:
+    IndexScanOperator(const Table& schema, const std::string& indexPath,
+                      std::optional<std::string> low, std::optional<std::string> high);
+    void open() override;
+    bool next(Row& row) override;
+    void close() override;
+
+private:
+    Table schema;
+    std::string indexPath;
+    std::optional<std::string> low, high;
+    std::optional<BPlusTree::Cursor> cursor;
+};
+
+// Wraps the plan of a nested SELECT used as a FROM source.
+class SubqueryScanOperator : public Operator {
+public:
+    explicit SubqueryScanOperator(std::unique_ptr<Operator> child);
+    void open() override;
+    bool next(Row& row) override;
+    void close() override;
+
+private:
+    std::unique_ptr<Operator> child;
+};
+
+class FilterOperator : public Operator {
+public:
+    using Predicate = std::function<bool(const Row&)>;
+
+    FilterOperator(std::unique_ptr<Operator> child, Predicate predicate);
+    void open() override;
+    bool next(Row& row) override;
+    void close() override;
+
+private:
+    std::unique_ptr<Operator> child;
+    Predicate predicate;
+};
+
+class ProjectOperator : public Operator {
+public:
+    ProjectOperator(std::unique_ptr<Operator> child, const std::vector<int>& indices);
+    void open() override;
+    bool next(Row& row) override;
+    void close() override;
+
+private:
+    std::unique_ptr<Operator> child;
+    std::vector<int> indices;
+    Row input;
+};
+
+// Blocking: pulls all input rows on open() and returns them in order,
+// spilling sorted runs to disk past the sort memory budget.
+class SortOperator : public Operator {
+public:
+    SortOperator(std::unique_ptr<Operator> child, std::vector<SortColumn> keys);
+    void open() override;
+    bool next(Row& row) override;
+    void close() override;
+
+private:
+    std::unique_ptr<Operator> child;
+    std::vector<SortColumn> keys;
+    std::unique_ptr<ExternalSorter> sorter;
+};
+
+// ORDER BY ... LIMIT: keeps only the first `count` rows in a bounded max-heap,
+// so n input rows cost O(n log count) and count rows of memory. Blocking like
+// SortOperator; equal keys keep their input order.
+class TopNOperator : public Operator {
+public:
+    // Above this, SortOperator (which can spill) is used instead.
+    static constexpr size_t MAX_ROWS = 100000;
+
+    TopNOperator(std::unique_ptr<Operator> child, std::vector<SortColumn> keys, size_t count);
+    void open() override;
+    bool next(Row& row) override;
+    void close() override;
+
+private:
+    struct Entry {
+        std::string key;
+        uint64_t seq;
+        Row row;
+        bool operator<(const Entry& other) const {
+            int c = key.compare(other.key);
+            return c < 0 || (c == 0 && seq < other.seq);
+        }
+    };
+
+    std::unique_ptr<Operator> child;
+    RowSorter sorter;
+    size_t count;
+    std::vector<Entry> heap;
+    size_t pos = 0;
+};
+
+// Skips `offset` rows, then passes on at most `limit` (-1: all). Stops pulling
+// from its child once the limit is reached, so a plain scan stops reading.
+class LimitOperator : public Operator {
+public:
+    LimitOperator(std::unique_ptr<Operator> child, long long limit, long long offset);
+    void open() override;
+    bool next(Row& row) override;
+    void close() override;
+
+private:
+    std::unique_ptr<Operator> child;
+    long long limit;
+    long long offset;
+    long long returned = 0;
+    bool childOpen = false;
+};
+
+} // namespace spl
+
+#endif // SPL_OPERATORS_H
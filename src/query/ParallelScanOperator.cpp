@@ -0,0 +1,155 @@
+#include "ParallelScanOperator.h"
+#include <algorithm>
+#include "../storage/StorageManager.h"
+
+namespace spl {
+
+ParallelScanOperator::ParallelScanOperator(const Table& schema, const std::vector<bool>& needed,
+                                           std::vector<ZonePredicate> where, std::vector<IntComparison> intFilter,
+                                           std::shared_ptr<const BoundPredicate> filter, bool ordered)
+    : schema(schema), needed(needed), where(std::move(where)), intFilter(std::move(intFilter)),
+      filter(std::move(filter)), ordered(ordered) {
+    outputColumns = schema.columns;
+}
+
+ParallelScanOperator::~ParallelScanOperator() {
+    stopTasks();
+}
+
+bool ParallelScanOperator::worthwhile(const Table& schema) {
+    if (TaskScheduler::instance().workers() < 2) return false;
+    return StorageManager::openCursor(schema)->blockCount() >= 2 * MORSEL_BLOCKS;
+}
+
+void ParallelScanOperator::project(const std::vector<int>& indices) {
+    projection = indices;
+    outputColumns.clear();
+    for (int idx : indices) {
+        outputColumns.push_back(schema.columns[idx]);
+    }
+}
+
+void ParallelScanOperator::open() {
+    stopTasks();
+    window.clear();
+    base = 0;
+    nextMorsel = 0;
+    stopping = false;
+    current = Morsel();
+    pos = 0;
+
+    // Cursors are opened here so that tasks only read pages
+    size_t threads = TaskScheduler::instance().workers();
+    cursors.clear();
+    for (size_t i = 0; i < threads; ++i) {
+        cursors.push_back(StorageManager::openCursor(schema, needed, where, intFilter));
+    }
+    morselCount = (cursors[0]->blockCount() + MORSEL_BLOCKS - 1) / MORSEL_BLOCKS;
+    windowSize = WINDOW * threads;
+    tasks = std::make_unique<TaskGroup>();
+    std::lock_guard<std::mutex> lock(mutex);
+    submitMorsels();
+}
+
+void ParallelScanOperator::submitMorsels() {
+    while (nextMorsel < morselCount && nextMorsel < base + windowSize) {
+        uint64_t m = nextMorsel++;
+        window.emplace_back();
+        tasks->run([this, m] { readMorsel(m); });
+    }
+}
+
+void ParallelScanOperator::readMorsel(uint64_t m) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (stopping) return;
+    }
+    TableCursor& cursor = *cursors[TaskScheduler::currentWorker()];
+    Morsel morsel;
+    Row row;
+    cursor.setBlockRange(m * MORSEL_BLOCKS, (m + 1) * MORSEL_BLOCKS);
+    while (cursor.next(row)) {
+        if (filter && !filter->evaluate(row)) continue;
+        if (projection.empty()) {
+            morsel.rows.push_back(std::move(row));
+        } else {
+            Row out;
+            out.values.reserve(projection.size());
+            for (int idx : projection) {
+                out.values.push_back(std::move(row.values[idx]));
+            }
+            morsel.rows.push_back(std::move(out));
+        }
+        morsel.rids.push_back(cursor.currentRid());
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (stopping) return;
+        Morsel& slot = window[m - base];
+        slot.rows = std::move(morsel.rows);
+        slot.rids = std::move(morsel.rids);
+        slot.done = true;
+    }
+    finished.notify_one();
+}
+
+bool ParallelScanOperator::takeMorsel() {
+    std::unique_lock<std::mutex> lock(mutex);
+    for (;;) {
+        Morsel* found = nullptr;
+        if (ordered) {
+            if (!window.empty() && window.front().done) found = &window.front();
+        } else {
+            for (auto& morsel : window) {
+                if (morsel.done && !morsel.taken) {
+                    found = &morsel;
+                    break;
+                }
+            }
+        }
+        if (found) {
+            current.rows = std::move(found->rows);
+            current.rids = std::move(found->rids);
+            found->taken = true;
+            while (!window.empty() && window.front().taken) {
+                window.pop_front();
+                ++base;
+            }
+            pos = 0;
+            submitMorsels();
+            return true;
+        }
+        if (base >= morselCount) return false;
+        finished.wait(lock);
+    }
+}
+
+bool ParallelScanOperator::next(Row& row) {
+    while (pos >= current.rows.size()) {
+        if (!takeMorsel()) return false;
+    }
+    rid = current.rids[pos];
+    row = std::move(current.rows[pos++]);
+    return true;
+}
+
+void ParallelScanOperator::close() {
+    stopTasks();
+    window.clear();
+    cursors.clear();
+    current = Morsel();
+    pos = 0;
+}
+
+void ParallelScanOperator::stopTasks() {
+    if (!tasks) return;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    // Waits for the tasks; those not yet started return at once
+    tasks.reset();
+}
+
+} // namespace spl
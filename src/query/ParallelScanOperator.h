@@ -0,0 +1,89 @@
+#ifndef SPL_PARALLELSCANOPERATOR_H
+#define SPL_PARALLELSCANOPERATOR_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "../storage/TableCursor.h"
+#include "../storage/ZoneMap.h"
+#include "../utils/TaskScheduler.h"
+#include "BoundPredicate.h"
+#include "Operators.h"
+
+namespace spl {
+
+// Morsel-driven table scan: the table's blocks (see TableCursor::blockCount)
+// are cut into morsels of MORSEL_BLOCKS, each read by a TaskScheduler task
+// with its worker's cursor, applying the WHERE and the projection there. The
+// consumer gets whole morsels back, in table order when `ordered` (the rows
+// come out as a ScanOperator's would), otherwise in the order they finish.
+// At most WINDOW morsels per worker are submitted ahead of the consumer,
+// which bounds memory and lets a LIMIT stop the scan early.
+class ParallelScanOperator : public Operator {
+public:
+    static constexpr uint64_t MORSEL_BLOCKS = 16;
+    static constexpr size_t WINDOW = 4;
+
+    // `filter` may be null when the cursor's int filter covers the WHERE.
+    ParallelScanOperator(const Table& schema, const std::vector<bool>& needed, std::vector<ZonePredicate> where,
+                         std::vector<IntComparison> intFilter, std::shared_ptr<const BoundPredicate> filter,
+                         bool ordered);
+    ~ParallelScanOperator() override;
+    void open() override;
+    bool next(Row& row) override;
+    void close() override;
+
+    // Output only these columns of the table; call before open().
+    void project(const std::vector<int>& indices);
+    // Row id of the row last returned by next().
+    uint64_t currentRid() const { return rid; }
+
+    // Whether a scan of `schema` has enough blocks to split, and cores to split it over.
+    static bool worthwhile(const Table& schema);
+
+private:
+    struct Morsel {
+        std::vector<Row> rows;
+        std::vector<uint64_t> rids;
+        bool done = false;
+        bool taken = false;
+    };
+
+    Table schema;
+    std::vector<bool> needed;
+    std::vector<ZonePredicate> where;
+    std::vector<IntComparison> intFilter;
+    std::shared_ptr<const BoundPredicate> filter;
+    bool ordered;
+    std::vector<int> projection;
+
+    std::vector<std::unique_ptr<TableCursor>> cursors; // one per worker
+    std::unique_ptr<TaskGroup> tasks;
+    std::mutex mutex;
+    std::condition_variable finished; // a morsel is done
+    std::deque<Morsel> window;        // morsels [base, base + window.size())
+    uint64_t base = 0;
+    uint64_t nextMorsel = 0;
+    uint64_t morselCount = 0;
+    size_t windowSize = 0;
+    bool stopping = false;
+
+    Morsel current;
+    size_t pos = 0;
+    uint64_t rid = 0;
+
+    // Submits morsels until the window is full; called with `mutex` held.
+    void submitMorsels();
+    void readMorsel(uint64_t m);
+    // Moves a finished morsel into `current`; false once all were taken.
+    bool takeMorsel();
+    void stopTasks();
+};
+
+} // namespace spl
+
+#endif // SPL_PARALLELSCANOPERATOR_H
@@ -0,0 +1,54 @@
+#include "PlanCache.h"
+#include "../parser/SQLParser.h"
+#include "../parser/Tokenizer.h"
+
+namespace spl {
+
+PlanCache& PlanCache::instance() {
+    static PlanCache cache;
+    return cache;
+}
+
+void PlanCache::prepare(const std::string& name, const std::string& text, std::shared_ptr<Plan> plan) {
+    names[name] = text;
+    auto it = byText.find(text);
+    if (it != byText.end()) {
+        plans.splice(plans.begin(), plans, it->second);
+        return;
+    }
+    insert(text, std::move(plan));
+}
+
+std::shared_ptr<PlanCache::Plan> PlanCache::find(const std::string& name) {
+    auto named = names.find(name);
+    if (named == names.end()) return nullptr;
+    const std::string& text = named->second;
+    auto it = byText.find(text);
+    if (it != byText.end()) {
+        plans.splice(plans.begin(), plans, it->second);
+        return it->second->second;
+    }
+
+    Tokenizer tokenizer(text);
+    SQLParser parser(tokenizer);
+    auto plan = std::make_shared<Plan>();
+    std::string normalized;
+    plan->body = parser.parsePrepared(plan->parameters, normalized);
+    insert(text, plan);
+    return plan;
+}
+
+bool PlanCache::deallocate(const std::string& name) {
+    return names.erase(name) > 0;
+}
+
+void PlanCache::insert(const std::string& text, std::shared_ptr<Plan> plan) {
+    plans.emplace_front(text, std::move(plan));
+    byText[text] = plans.begin();
+    if (plans.size() > CAPACITY) {
+        byText.erase(plans.back().first);
+        plans.pop_back();
+    }
+}
+
+} // namespace spl
@@ -0,0 +1,56 @@
+#ifndef SPL_PLANCACHE_H
+#define SPL_PLANCACHE_H
+
+#include <cstddef>
+#include <list>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "../parser/AST.h"
+
+namespace spl {
+
+// Parsed PREPAREd statements, kept for the CAPACITY most recently executed
+// texts (see PrepareStatement::text). Statements prepared with the same
+// text share one plan. A prepared name refers to its text, so a statement
+// whose plan was evicted is parsed again on its next EXECUTE.
+//
+// A plan is the statement's AST with its `?` slots, not bound to any table:
+// EXECUTE writes the arguments into the slots and runs the AST like a parsed
+// statement, binding the WHERE then. Schema changes never make one stale.
+class PlanCache {
+public:
+    static constexpr size_t CAPACITY = 64;
+
+    struct Plan {
+        std::unique_ptr<AST> body;
+        std::vector<Parameter> parameters;
+    };
+
+    static PlanCache& instance();
+
+    // Names `text` (replacing an earlier statement of that name); `plan` is
+    // cached unless the text has one already.
+    void prepare(const std::string& name, const std::string& text, std::shared_ptr<Plan> plan);
+    // The plan of a prepared name, null if there is none. Throws like
+    // SQLParser if an evicted statement no longer parses.
+    std::shared_ptr<Plan> find(const std::string& name);
+    bool deallocate(const std::string& name);
+
+private:
+    PlanCache() = default;
+
+    using Entry = std::pair<std::string, std::shared_ptr<Plan>>;
+
+    std::list<Entry> plans; // most recently used first
+    std::unordered_map<std::string, std::list<Entry>::iterator> byText;
+    std::unordered_map<std::string, std::string> names; // name -> text
+
+    void insert(const std::string& text, std::shared_ptr<Plan> plan);
+};
+
+} // namespace spl
+
+#endif // SPL_PLANCACHE_H
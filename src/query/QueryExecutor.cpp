@@ -1,84 +1,414 @@
+#include <algorithm>
 #include <iostream>
-#include <set>
+#include <functional>
 
 #include "QueryExecutor.h"
+#include "Operators.h"
+#include "HashJoinOperator.h"
+#include "HashAggregateOperator.h"
+#include "ParallelScanOperator.h"
+#include "PlanCache.h"
+#include "ResultCache.h"
+#include "BoundPredicate.h"
+#include "CostModel.h"
 #include "../storage/StorageManager.h"
-#include "../parser/Tokenizer.h"
-#include "../parser/SQLParser.h"
+#include "../storage/BPlusTree.h"
+#include "../storage/ZoneMap.h"
+#include "../utils/Validators.h"
 
 
 namespace spl {
 
-bool isInteger(const std::string& s) {
-    if(s.empty()) return false;
-    size_t start = 0;
-    if(s[0] == '-' || s[0] == '+') {
-         if(s.size() == 1) return false;
-         start = 1;
+int getColumnIndex(const Table& table, const std::string& colName) {
+    return findColumn(table.columns, colName);
+}
+
+// The columns renamed `name.column`, so queries can qualify them with their
+// table or alias. Bare names still resolve (see findColumn).
+std::vector<Column> qualifiedColumns(const std::vector<Column>& columns, const std::string& name) {
+    if (name.empty()) return columns;
+    std::vector<Column> qualified;
+    for (const auto& col : columns) qualified.push_back({name + "." + col.name, col.type});
+    return qualified;
+}
+
+// Key range of an index covering the WHERE: the comparisons among its terms
+// on one indexed column, narrowed to their intersection. Without statistics
+// that is the first indexed column that has any. With them it is the one
+// whose range holds the fewest rows, and only if fetching those through the
+// index costs less than scanning the table.
+bool findIndexRange(const Table& schema, const BoundPredicate& where, std::string& indexPath,
+                    std::optional<std::string>& low, std::optional<std::string>& high) {
+    using Op = BoundPredicate::Op;
+    auto terms = where.conjuncts();
+    auto stats = StorageManager::tableStats(schema.name);
+    bool found = false;
+    double best = 1.0;
+    for (const auto& index : schema.indexes) {
+        int idx = getColumnIndex(schema, index.column);
+        std::optional<std::string> from, to;
+        std::vector<const BoundPredicate*> used;
+        for (const BoundPredicate* term : terms) {
+            if (term->kind != BoundPredicate::Kind::COMPARE || term->column != idx || term->op == Op::NE) continue;
+            std::string key;
+            if (!BPlusTree::encodeKey(term->literal, key)) continue;
+            // Keys compare like the values they encode
+            if (term->op == Op::EQ || term->op == Op::GT || term->op == Op::GE) {
+                if (!from || key > *from) from = key;
+            }
+            if (term->op == Op::EQ || term->op == Op::LT || term->op == Op::LE) {
+                if (!to || key < *to) to = key;
+            }
+            used.push_back(term);
+        }
+        if (used.empty()) continue;
+        double fraction = 0;
+        if (stats && static_cast<size_t>(idx) < stats->columns.size()) {
+            fraction = CostModel::rangeSelectivity(used, stats->columns[idx]);
+        }
+        if (found && fraction >= best) continue;
+        found = true;
+        best = fraction;
+        low = from;
+        high = to;
+        indexPath = StorageManager::indexPath(schema.name, index.name);
+        if (!stats) return true;
     }
-    for (size_t i = start; i < s.size(); ++i) {
-        if (!std::isdigit(static_cast<unsigned char>(s[i]))) return false;
+    if (!found || !stats) return found;
+
+    // Rows as of the ANALYZE: counting them now could read the whole table
+    double rows = static_cast<double>(stats->rows);
+    size_t workers = ParallelScanOperator::worthwhile(schema) ? TaskScheduler::instance().workers() : 1;
+    if (CostModel::indexScanCost(best * rows) < CostModel::scanCost(rows, workers)) {
+        return true;
     }
-    return true;
+    low.reset();
+    high.reset();
+    return false;
 }
 
-int getColumnIndex(const Table& table, const std::string& colName) {
-    for (size_t i = 0; i < table.columns.size(); ++i) {
-        if (table.columns[i].name == colName) return i;
+// Picks an index range scan when the WHERE compares an indexed column.
+std::unique_ptr<Operator> chooseIndexScan(const Table& schema, const BoundPredicate& where) {
+    std::string indexPath;
+    std::optional<std::string> low, high;
+    if (!findIndexRange(schema, where, indexPath, low, high)) return nullptr;
+    return std::make_unique<IndexScanOperator>(schema, indexPath, low, high);
+}
+
+// The comparisons of the WHERE that zone maps can prune blocks with.
+std::vector<ZonePredicate> findZonePredicates(const BoundPredicate& where) {
+    using Op = BoundPredicate::Op;
+    std::vector<ZonePredicate> preds;
+    for (const BoundPredicate* term : where.conjuncts()) {
+        if (term->kind != BoundPredicate::Kind::COMPARE || term->op == Op::NE) continue;
+        ZonePredicate pred;
+        switch (term->op) {
+            case Op::EQ: pred.op = "="; break;
+            case Op::LT: pred.op = "<"; break;
+            case Op::GT: pred.op = ">"; break;
+            case Op::LE: pred.op = "<="; break;
+            default: pred.op = ">="; break;
+        }
+        pred.column = term->column;
+        pred.value = term->literal.toString();
+        preds.push_back(pred);
     }
-    return -1;
+    return preds;
 }
 
-bool evaluateSimple(const Row& row, const Table& table, const std::string& condition) {
-    std::stringstream ss(condition);
-    std::string colName, op, val;
-    ss >> colName >> op >> val; 
-    
-    if (colName.empty() || op.empty() || val.empty()) return true; // Malformed/Empty condition? Treat as true? Or false.
+// The comparisons of the WHERE on INT columns, for the scan to evaluate in
+// batches. `complete` tells whether they are the whole WHERE.
+std::vector<IntComparison> findIntComparisons(const BoundPredicate& where, bool& complete) {
+    std::vector<IntComparison> comparisons;
+    auto terms = where.conjuncts();
+    for (const BoundPredicate* term : terms) {
+        // Only INT columns bind INT literals
+        if (term->kind != BoundPredicate::Kind::COMPARE || !term->literal.isInt()) continue;
+        comparisons.push_back({term->column, term->op, term->literal.asInt()});
+    }
+    complete = comparisons.size() == terms.size();
+    return comparisons;
+}
+
+// Row ids and contents of the rows an UPDATE or DELETE applies to. Collected
+// before anything is changed, so rows that move are not visited twice.
+std::vector<std::pair<uint64_t, Row>> findMatchingRows(const Table& schema, const BoundPredicate& where) {
+    std::vector<std::pair<uint64_t, Row>> matches;
+    if (where.kind == BoundPredicate::Kind::CONSTANT && !where.value) return matches;
+    std::string indexPath;
+    std::optional<std::string> low, high;
+    Row row;
+    if (findIndexRange(schema, where, indexPath, low, high)) {
+        BPlusTree::Cursor cursor = BPlusTree(indexPath).scan(low ? &*low : nullptr, high ? &*high : nullptr);
+        uint64_t rid;
+        while (cursor.next(rid)) {
+            if (StorageManager::fetchRow(schema, rid, row) && where.evaluate(row)) {
+                matches.push_back({rid, row});
+            }
+        }
+        return matches;
+    }
+
+    bool complete;
+    auto intFilter = findIntComparisons(where, complete);
+    if (ParallelScanOperator::worthwhile(schema)) {
+        // `where` outlives the scan
+        ParallelScanOperator scan(schema, {}, findZonePredicates(where), std::move(intFilter),
+                                  std::shared_ptr<const BoundPredicate>(&where, [](const BoundPredicate*) {}), true);
+        scan.open();
+        while (scan.next(row)) {
+            matches.push_back({scan.currentRid(), std::move(row)});
+        }
+        scan.close();
+        return matches;
+    }
+    auto cursor = StorageManager::openCursor(schema, {}, findZonePredicates(where), std::move(intFilter));
+    while (cursor->next(row)) {
+        if (where.evaluate(row)) {
+            matches.push_back({cursor->currentRid(), row});
+        }
+    }
+    return matches;
+}
+
+// Outer columns a correlated EXISTS compares with: any unquoted literal of
+// the subquery's top-level AND terms may name one.
+void markCorrelations(const Expr& expr, const std::function<void(const std::string&)>& mark) {
+    if (expr.kind == Expr::Kind::COMPARE && !expr.quoted) {
+        mark(expr.column);
+        mark(expr.value);
+    }
+    if (expr.kind != Expr::Kind::AND) return;
+    for (const auto& child : expr.children) markCorrelations(*child, mark);
+}
+
+void markColumns(const Expr& expr, const std::function<void(const std::string&)>& mark) {
+    if (!expr.column.empty()) mark(expr.column);
+    if (expr.kind == Expr::Kind::EXISTS) {
+        auto* sub = static_cast<const SelectStatement*>(expr.subquery.get());
+        if (sub->where) markCorrelations(*sub->where, mark);
+    }
+    for (const auto& child : expr.children) markColumns(*child, mark);
+}
+
+// The terms of a WHERE that must all hold.
+void splitConjuncts(const Expr& expr, std::vector<const Expr*>& terms) {
+    if (expr.kind != Expr::Kind::AND) {
+        terms.push_back(&expr);
+        return;
+    }
+    for (const auto& child : expr.children) splitConjuncts(*child, terms);
+}
+
+std::unique_ptr<Operator> filterRows(std::unique_ptr<Operator> plan, BoundPredicate where) {
+    auto predicate = std::make_shared<BoundPredicate>(std::move(where));
+    return std::make_unique<FilterOperator>(std::move(plan), [predicate](const Row& row) {
+        return predicate->evaluate(row);
+    });
+}
+
+// The rows of a table that pass `where`, read with the cheapest access path:
+// an index range, or a scan with zone map pruning and the INT comparisons
+// pushed into the cursor. Big tables are scanned in parallel morsels, with
+// the rest of `where` checked by the workers; `ordered` keeps table order.
+std::unique_ptr<Operator> scanTable(const Table& schema, BoundPredicate where, const std::vector<bool>& needed,
+                                    bool ordered) {
+    // A WHERE that never holds (say, an empty IN subquery) reads nothing
+    if (where.kind == BoundPredicate::Kind::CONSTANT && !where.value) {
+        return std::make_unique<LimitOperator>(std::make_unique<ScanOperator>(schema, needed), 0, 0);
+    }
+    auto plan = chooseIndexScan(schema, where);
+    if (plan) return filterRows(std::move(plan), std::move(where));
+    bool complete;
+    auto intFilter = findIntComparisons(where, complete);
+    // Columnar scans apply the int filter exactly, which may leave nothing to re-check
+    bool filtered = where.kind == BoundPredicate::Kind::CONSTANT || (complete && schema.format == TableFormat::COLUMNAR);
+    auto zones = findZonePredicates(where);
+    if (ParallelScanOperator::worthwhile(schema)) {
+        std::shared_ptr<const BoundPredicate> filter;
+        if (!filtered) filter = std::make_shared<BoundPredicate>(std::move(where));
+        return std::make_unique<ParallelScanOperator>(schema, needed, std::move(zones), std::move(intFilter),
+                                                      std::move(filter), ordered);
+    }
+    plan = std::make_unique<ScanOperator>(schema, needed, std::move(zones), std::move(intFilter));
+    if (!filtered) plan = filterRows(std::move(plan), std::move(where));
+    return plan;
+}
+
+// GROUP BY and aggregates: a HashAggregateOperator that outputs the group
+// columns, then the aggregates named by their text ("SUM(v)"). `columns`,
+// the input's names for lookups, is replaced with the output's.
+std::unique_ptr<Operator> aggregateRows(const SelectStatement* stmt, std::unique_ptr<Operator> plan,
+                                        std::vector<Column>& columns) {
+    auto resolve = [&](const std::string& name) {
+        bool ambiguous;
+        int idx = findColumn(columns, name, &ambiguous);
+        if (ambiguous) {
+            std::cout << "Error: Column '" << name << "' is ambiguous; qualify it with its table.\n";
+        } else if (idx == -1) {
+            std::cout << "Error: Column " << name << " not found.\n";
+        }
+        return idx;
+    };
+
+    std::vector<int> groupColumns;
+    std::vector<Column> named, output;
+    for (const auto& name : stmt->groupBy) {
+        int idx = resolve(name);
+        if (idx == -1) return nullptr;
+        groupColumns.push_back(idx);
+        named.push_back(columns[idx]);
+        output.push_back(plan->columns()[idx]);
+    }
+
+    std::vector<AggregateSpec> specs;
+    for (const auto& agg : stmt->aggregates) {
+        AggregateSpec spec{AggregateFunction::COUNT, -1};
+        if (agg.function == "SUM") spec.function = AggregateFunction::SUM;
+        if (agg.function == "MIN") spec.function = AggregateFunction::MIN;
+        if (agg.function == "MAX") spec.function = AggregateFunction::MAX;
+        if (agg.function == "AVG") spec.function = AggregateFunction::AVG;
+        std::string type = "INT";
+        if (agg.column != "*") {
+            spec.column = resolve(agg.column);
+            if (spec.column == -1) return nullptr;
+            const Column& col = columns[spec.column];
+            bool numeric = spec.function == AggregateFunction::SUM || spec.function == AggregateFunction::AVG;
+            if (numeric && !isIntType(col.type)) {
+                std::cout << "Error: " << agg.function << " needs an INT column, " << agg.column << " is " << col.type << ".\n";
+                return nullptr;
+            }
+            if (spec.function == AggregateFunction::MIN || spec.function == AggregateFunction::MAX) type = col.type;
+        }
+        specs.push_back(spec);
+        named.push_back({agg.text, type});
+        output.push_back({agg.text, type});
+    }
+
+    for (const auto& name : stmt->columns) {
+        if (name == "*" || (name.size() > 2 && name.compare(name.size() - 2, 2, ".*") == 0)) {
+            std::cout << "Error: " << name << " cannot be selected with GROUP BY or aggregates.\n";
+            return nullptr;
+        }
+        if (findColumn(named, name) == -1) {
+            std::cout << "Error: Column " << name << " must appear in GROUP BY or an aggregate.\n";
+            return nullptr;
+        }
+    }
+
+    columns = std::move(named);
+    return std::make_unique<HashAggregateOperator>(std::move(plan), std::move(groupColumns), std::move(specs),
+                                                   std::move(output));
+}
+
+// The names a SELECT's select list, GROUP BY, aggregates and ORDER BY refer to.
+void markSelectColumns(const SelectStatement* stmt, const std::function<void(const std::string&)>& mark) {
+    for (const auto& col : stmt->columns) mark(col);
+    for (const auto& name : stmt->groupBy) mark(name);
+    for (const auto& agg : stmt->aggregates) {
+        if (agg.column != "*") mark(agg.column);
+    }
+    for (const auto& item : stmt->orderBy) mark(item.column);
+}
 
-    int idx = getColumnIndex(table, colName);
-    if (idx == -1) return false; 
+// Which of `columns` (a table's, qualified) a SELECT touches, so the scan can skip the rest.
+std::vector<bool> referencedColumns(const SelectStatement* stmt, const std::vector<Column>& columns) {
+    std::vector<bool> needed(columns.size(), false);
+    auto mark = [&](const std::string& name) {
+        if (name == "*" || (name.size() > 2 && name.compare(name.size() - 2, 2, ".*") == 0)) {
+            needed.assign(needed.size(), true);
+            return;
+        }
+        int idx = findColumn(columns, name);
+        if (idx != -1) needed[idx] = true;
+    };
 
-    std::string rowVal = row.values[idx];
+    markSelectColumns(stmt, mark);
+    if (stmt->where) markColumns(*stmt->where, mark);
+    return needed;
+}
 
-    // Remove quotes
-    if (val.size() >= 2 && val.front() == '\'' && val.back() == '\'') {
-        val = val.substr(1, val.size() - 2);
+// The select list of `stmt` out of `plan`, whose columns are `source`'s.
+std::unique_ptr<Operator> projectColumns(const SelectStatement* stmt, std::unique_ptr<Operator> plan,
+                                         const Table& source) {
+    if (stmt->columns.size() == 1 && stmt->columns[0] == "*") {
+        return plan;
     }
     
-    if (table.columns[idx].type == "INT" || table.columns[idx].type == "int") {
-        try {
-            int r = std::stoi(rowVal);
-            int v = std::stoi(val);
-            if (op == "=") return r == v;
-            if (op == ">") return r > v;
-            if (op == "<") return r < v;
-            if (op == ">=") return r >= v;
-            if (op == "<=") return r <= v;
-            if (op == "!=") return r != v;
-        } catch (...) { return false; }
+    std::vector<int> colIndices;
+    for(const auto& colName : stmt->columns) {
+        // t.* is every column of table t in a join
+        if (colName.size() > 2 && colName.compare(colName.size() - 2, 2, ".*") == 0) {
+            std::string prefix = colName.substr(0, colName.size() - 1);
+            for (size_t i = 0; i < source.columns.size(); ++i) {
+                if (source.columns[i].name.compare(0, prefix.size(), prefix) == 0) colIndices.push_back(i);
+            }
+            continue;
+        }
+        int idx = getColumnIndex(source, colName);
+        if(idx != -1) {
+            colIndices.push_back(idx);
+        } else {
+             // Ignore unknown columns or handle? AST parser puts them in.
+        }
+    }
+    if (auto* scan = dynamic_cast<ParallelScanOperator*>(plan.get())) {
+        scan->project(colIndices);
+        return plan;
+    }
+    return std::make_unique<ProjectOperator>(std::move(plan), colIndices);
+}
+
+// Every table a SELECT reads, those of its subqueries included.
+void collectTables(const AST* ast, std::vector<std::string>& tables);
+
+void collectTables(const Expr& expr, std::vector<std::string>& tables) {
+    if (expr.subquery) collectTables(expr.subquery.get(), tables);
+    for (const auto& child : expr.children) collectTables(*child, tables);
+}
+
+void collectTables(const AST* ast, std::vector<std::string>& tables) {
+    if (ast->type != "SELECT") return;
+    auto* stmt = static_cast<const SelectStatement*>(ast);
+    if (stmt->nestedFrom) {
+        collectTables(stmt->nestedFrom.get(), tables);
     } else {
-        if (op == "=") return rowVal == val;
-        if (op == "!=") return rowVal != val;
-        if (op == ">") return rowVal > val;
-        if (op == "<") return rowVal < val;
+        tables.push_back(stmt->table);
     }
-    return false;
+    for (const auto& join : stmt->joins) tables.push_back(join.table);
+    if (stmt->where) collectTables(*stmt->where, tables);
 }
 
 void QueryExecutor::execute(std::unique_ptr<AST> ast) {
+    run(ast.get());
+}
+
+void QueryExecutor::run(AST* ast) {
     if (!ast) return;
     if (ast->type == "CREATE") {
-        handleCreate(static_cast<CreateStatement*>(ast.get()));
+        handleCreate(static_cast<CreateStatement*>(ast));
+    } else if (ast->type == "CREATE_INDEX") {
+        handleCreateIndex(static_cast<CreateIndexStatement*>(ast));
     } else if (ast->type == "INSERT") {
-        handleInsert(static_cast<InsertStatement*>(ast.get()));
+        handleInsert(static_cast<InsertStatement*>(ast));
     } else if (ast->type == "SELECT") {
-         Table t = executeSelect(static_cast<SelectStatement*>(ast.get()));
-         t.print();
+        handleSelect(static_cast<SelectStatement*>(ast));
     } else if (ast->type == "UPDATE") {
-        handleUpdate(static_cast<UpdateStatement*>(ast.get()));
+        handleUpdate(static_cast<UpdateStatement*>(ast));
     } else if (ast->type == "DELETE") {
-        handleDelete(static_cast<DeleteStatement*>(ast.get()));
+        handleDelete(static_cast<DeleteStatement*>(ast));
+    } else if (ast->type == "COPY") {
+        handleCopy(static_cast<CopyStatement*>(ast));
+    } else if (ast->type == "VACUUM") {
+        handleVacuum(static_cast<VacuumStatement*>(ast));
+    } else if (ast->type == "ANALYZE") {
+        handleAnalyze(static_cast<AnalyzeStatement*>(ast));
+    } else if (ast->type == "PREPARE") {
+        handlePrepare(static_cast<PrepareStatement*>(ast));
+    } else if (ast->type == "EXECUTE") {
+        handleExecute(static_cast<ExecuteStatement*>(ast));
+    } else if (ast->type == "DEALLOCATE") {
+        handleDeallocate(static_cast<DeallocateStatement*>(ast));
     } else {
         std::cout << "Unknown query type: " << ast->type << "\n";
     }
@@ -89,13 +419,31 @@ void QueryExecutor::handleCreate(CreateStatement* stmt) {
     for (const auto& p : stmt->columns) {
         cols.push_back({p.first, p.second});
     }
-    if (StorageManager::createTable(stmt->table, cols)) {
+    TableFormat format = stmt->format == "COLUMNAR" ? TableFormat::COLUMNAR : TableFormat::ROW;
+    if (StorageManager::createTable(stmt->table, cols, format)) {
         std::cout << "Table '" << stmt->table << "' created.\n";
     } else {
         std::cout << "Error: Table '" << stmt->table << "' already exists or create failed.\n";
     }
 }
 
+void QueryExecutor::handleCreateIndex(CreateIndexStatement* stmt) {
+    Table schema = StorageManager::getTableSchema(stmt->table);
+    if (schema.columns.empty()) {
+        std::cout << "Error: Table '" << stmt->table << "' not found.\n";
+        return;
+    }
+    if (getColumnIndex(schema, stmt->column) == -1) {
+        std::cout << "Error: Column '" << stmt->column << "' not found.\n";
+        return;
+    }
+    if (StorageManager::createIndex(stmt->table, stmt->name, stmt->column)) {
+        std::cout << "Index '" << stmt->name << "' created.\n";
+    } else {
+        std::cout << "Error: Index '" << stmt->name << "' already exists or create failed.\n";
+    }
+}
+
 void QueryExecutor::handleInsert(InsertStatement* stmt) {
     Table table = StorageManager::getTableSchema(stmt->table);
     if (table.columns.empty()) {
@@ -103,185 +451,395 @@ void QueryExecutor::handleInsert(InsertStatement* stmt) {
          return;
     }
 
-    if (stmt->values.size() != table.columns.size()) {
-         std::cout << "Error: Column count mismatch.\n";
-         return;
-    }
+    // Validate every tuple before writing any of them
+    std::vector<Row> rows;
+    rows.reserve(stmt->rows.size());
+    for (auto& values : stmt->rows) {
+        if (values.size() != table.columns.size()) {
+             std::cout << "Error: Column count mismatch.\n";
+             return;
+        }
 
-    for (size_t i = 0; i < table.columns.size(); ++i) {
-        std::string val = stmt->values[i];
-        std::string type = table.columns[i].type;
-        if (type == "INT" || type == "int") {
-            if (!isInteger(val)) {
+        Row row;
+        row.values.resize(values.size());
+        for (size_t i = 0; i < table.columns.size(); ++i) {
+            const std::string& val = values[i];
+            if ((isIntType(table.columns[i].type) && !Validators::isInteger(val)) ||
+                !Value::parse(val, table.columns[i].type, row.values[i])) {
                 std::cout << "Error: Invalid INT value '" << val << "' for column '" << table.columns[i].name << "'\n";
                 return;
             }
         }
+        if (!StorageManager::rowFits(table, row)) {
+            std::cout << "Error: Row " << rows.size() + 1 << " is too large to store.\n";
+            return;
+        }
+        rows.push_back(std::move(row));
     }
 
-    Row row;
-    row.values = stmt->values;
-    if (StorageManager::appendRow(stmt->table, row)) {
-        std::cout << "1 row inserted.\n";
+    // A write that still fails part way is rolled back, not committed
+    StorageManager::beginTransaction();
+    if (StorageManager::appendRows(stmt->table, rows)) {
+        StorageManager::commitTransaction();
+        std::cout << rows.size() << (rows.size() == 1 ? " row inserted.\n" : " rows inserted.\n");
     } else {
+        StorageManager::abortTransaction();
         std::cout << "Error: Could not write to table.\n";
     }
 }
 
-// Quicksort Helpers
-void swapRows(Row& a, Row& b) {
-    Row temp = a;
-    a = b;
-    b = temp;
-}
-
-int partition(std::vector<Row>& rows, int low, int high, int colIdx, bool isInt) {
-    std::string pivotStr = rows[high].values[colIdx];
-    int i = (low - 1);
-
-    for (int j = low; j <= high - 1; j++) {
-        std::string curStr = rows[j].values[colIdx];
-        bool less = false;
-        if (isInt) {
-            try {
-                int p = std::stoi(pivotStr);
-                int c = std::stoi(curStr);
-                less = (c < p);
-            } catch (...) { less = (curStr < pivotStr); }
+std::unique_ptr<Operator> QueryExecutor::buildSelectPlan(SelectStatement* stmt) {
+    std::unique_ptr<Operator> plan;
+    // Bound against the table, or against the nested SELECT's output
+    BoundPredicate where = BoundPredicate::constant(true);
+    bool scanFiltered = false;
+    // What columns can be qualified with: the table's alias or name, a nested SELECT's alias
+    std::string qualifier = stmt->alias.empty() ? stmt->table : stmt->alias;
+    if (!stmt->joins.empty()) {
+        plan = buildJoinPlan(stmt);
+        if (!plan) return nullptr;
+        // The join plan applies the WHERE itself
+        scanFiltered = true;
+    } else if (stmt->nestedFrom) {
+        if(stmt->nestedFrom->type == "SELECT") {
+             auto nested = buildSelectPlan(static_cast<SelectStatement*>(stmt->nestedFrom.get()));
+             if (!nested) return nullptr;
+             plan = std::make_unique<SubqueryScanOperator>(std::move(nested));
         } else {
-             less = (curStr < pivotStr);
+             std::cout << "Error: Nested FROM must be SELECT\n";
+             return nullptr;
+        }
+    } else {
+        Table schema = StorageManager::getTableSchema(stmt->table);
+        if (schema.columns.empty()) {
+             std::cout << "Error: Table " << stmt->table << " not found.\n";
+             return nullptr;
+        }
+        auto columns = qualifiedColumns(schema.columns, qualifier);
+        if (stmt->where) {
+            where = BoundPredicate::bind(columns, *stmt->where, runSubquery());
         }
+        // Aggregates do not depend on the order of their input
+        bool ordered = stmt->groupBy.empty() && stmt->aggregates.empty();
+        plan = scanTable(schema, std::move(where), referencedColumns(stmt, columns), ordered);
+        scanFiltered = true;
+    }
+
+    // Join columns are qualified already
+    Table source;
+    source.columns = stmt->joins.empty() ? qualifiedColumns(plan->columns(), qualifier) : plan->columns();
 
-        if (less) {
-            i++;
-            swapRows(rows[i], rows[j]);
+    if (stmt->where && !scanFiltered) {
+        if (stmt->nestedFrom) {
+            where = BoundPredicate::bind(source.columns, *stmt->where, runSubquery());
         }
+        plan = filterRows(std::move(plan), std::move(where));
     }
-    swapRows(rows[i + 1], rows[high]);
-    return (i + 1);
-}
 
-void quickSort(std::vector<Row>& rows, int low, int high, int colIdx, bool isInt) {
-    if (low < high) {
-        int pi = partition(rows, low, high, colIdx, isInt);
-        quickSort(rows, low, pi - 1, colIdx, isInt);
-        quickSort(rows, pi + 1, high, colIdx, isInt);
+    if (!stmt->groupBy.empty() || !stmt->aggregates.empty()) {
+        plan = aggregateRows(stmt, std::move(plan), source.columns);
+        if (!plan) return nullptr;
+    }
+    
+    // Sort
+    std::vector<SortColumn> sortKeys;
+    for (const auto& item : stmt->orderBy) {
+        int sortIdx = getColumnIndex(source, item.column);
+        if (sortIdx != -1) {
+             sortKeys.push_back({sortIdx, item.descending});
+        } else {
+             std::cout << "Warning: Order By column " << item.column << " not found.\n";
+        }
+    }
+    bool limited = stmt->limit >= 0 || stmt->offset > 0;
+    // Without a sort, projecting below the LIMIT lets a parallel scan project in its workers
+    bool projectFirst = sortKeys.empty();
+    if (!sortKeys.empty()) {
+        unsigned long long keep = static_cast<unsigned long long>(stmt->limit) + stmt->offset;
+        if (stmt->limit >= 0 && keep <= TopNOperator::MAX_ROWS) {
+            plan = std::make_unique<TopNOperator>(std::move(plan), std::move(sortKeys), static_cast<size_t>(keep));
+        } else {
+            plan = std::make_unique<SortOperator>(std::move(plan), std::move(sortKeys));
+        }
     }
+    if (projectFirst) plan = projectColumns(stmt, std::move(plan), source);
+    if (limited) {
+        plan = std::make_unique<LimitOperator>(std::move(plan), stmt->limit, stmt->offset);
+    }
+    if (!projectFirst) plan = projectColumns(stmt, std::move(plan), source);
+    return plan;
 }
 
-Table QueryExecutor::executeSelect(SelectStatement* stmt) {
-    Table sourceTable;
+// A table of a FROM ... JOIN list. Its columns are qualified with its alias
+// (or its name) and start at `first` among the columns of the whole join.
+struct JoinInput {
+    Table schema;
+    std::string name;
+    std::vector<Column> columns;
+    size_t first = 0;
+    uint64_t rows = 0;
+    // WHERE terms on this table alone filter it before the join, except on
+    // the right of a LEFT JOIN, where they would remove the NULL padding
+    bool pushable = true;
+    std::vector<const Expr*> where;
+    BoundPredicate filter; // `where`, bound
+    std::vector<bool> needed;
+    std::shared_ptr<const TableStats> stats;
+    double estimate = 0; // rows left by `filter`
+};
+
+std::unique_ptr<Operator> QueryExecutor::buildJoinPlan(SelectStatement* stmt) {
     if (stmt->nestedFrom) {
-        if(stmt->nestedFrom->type == "SELECT") {
-             sourceTable = executeSelect(static_cast<SelectStatement*>(stmt->nestedFrom.get()));
-             sourceTable.name = "nested"; // anonymous
-        } else {
-             std::cout << "Error: Nested FROM must be SELECT\n";
-             return Table();
-        }
-    } else {
-        sourceTable = StorageManager::loadTable(stmt->table);
+        std::cout << "Error: JOIN needs a table on its left, not a nested SELECT.\n";
+        return nullptr;
     }
-    
-    if(sourceTable.columns.empty() && sourceTable.name.empty() && !stmt->nestedFrom) {
-         std::cout << "Error: Table " << stmt->table << " not found.\n";
-         return Table();
+
+    std::vector<JoinInput> inputs;
+    std::vector<Column> columns; // of the whole join
+    std::vector<size_t> owner;   // input each column comes from
+    auto addInput = [&](const std::string& table, const std::string& alias, bool pushable) {
+        JoinInput input;
+        input.schema = StorageManager::getTableSchema(table);
+        if (input.schema.columns.empty()) {
+            std::cout << "Error: Table " << table << " not found.\n";
+            return false;
+        }
+        input.name = alias.empty() ? table : alias;
+        for (const auto& other : inputs) {
+            if (other.name == input.name) {
+                std::cout << "Error: Table name '" << input.name << "' is used twice; give one an alias.\n";
+                return false;
+            }
+        }
+        input.first = columns.size();
+        input.columns = qualifiedColumns(input.schema.columns, input.name);
+        columns.insert(columns.end(), input.columns.begin(), input.columns.end());
+        owner.resize(columns.size(), inputs.size());
+        uint64_t dead;
+        StorageManager::rowCounts(table, input.rows, dead);
+        input.pushable = pushable;
+        input.needed.assign(input.columns.size(), false);
+        inputs.push_back(std::move(input));
+        return true;
+    };
+    if (!addInput(stmt->table, stmt->alias, true)) return nullptr;
+    for (const auto& join : stmt->joins) {
+        if (!addInput(join.table, join.alias, !join.left)) return nullptr;
     }
-    
-    Table filteredTable;
-    filteredTable.name = sourceTable.name;
-    filteredTable.columns = sourceTable.columns;
-    
-    if (stmt->condition.empty()) {
-        filteredTable.rows = sourceTable.rows;
-    } else {
-        std::string condition = stmt->condition;
-        std::set<std::string> inValues;
-        std::string inCol;
-        bool hasIn = false;
-        
-        size_t inPos = condition.find(" IN (SELECT");
-        if (inPos != std::string::npos) {
-             hasIn = true;
-             size_t spacePos = condition.rfind(" ", inPos - 1);
-             if (spacePos != std::string::npos) {
-                 inCol = condition.substr(spacePos + 1, inPos - spacePos - 1);
-             } else {
-                 inCol = condition.substr(0, inPos);
-             }
-             
-             size_t startParen = condition.find("(", inPos);
-             size_t endParen = condition.rfind(")");
-             std::string subSQL = condition.substr(startParen + 1, endParen - startParen - 1);
-             
-             Tokenizer tokenizer(subSQL);
-             SQLParser parser(tokenizer);
-             std::unique_ptr<AST> subAst = parser.parse();
-             QueryExecutor subExec;
-             if (subAst && subAst->type == "SELECT") {
-                  Table subRes = subExec.executeSelect(static_cast<SelectStatement*>(subAst.get()));
-                  for(const auto& r : subRes.rows) {
-                      if(!r.values.empty()) inValues.insert(r.values[0]);
-                  }
-             }
-        }
-        
-        for (const auto& row : sourceTable.rows) {
-            bool pass = false;
-            if (hasIn) {
-                int idx = getColumnIndex(sourceTable, inCol);
-                if (idx != -1) {
-                    if (inValues.count(row.values[idx])) pass = true;
-                }
-            } else {
-                if (evaluateSimple(row, sourceTable, condition)) pass = true;
+
+    // Resolves a column of the join; unknown columns are left to the WHERE
+    // and select list, which treat them as before
+    bool ok = true;
+    auto resolve = [&](const std::string& name) {
+        bool ambiguous;
+        int idx = findColumn(columns, name, &ambiguous);
+        if (ambiguous && ok) {
+            std::cout << "Error: Column '" << name << "' is ambiguous; qualify it with its table.\n";
+            ok = false;
+        }
+        return idx;
+    };
+    auto mark = [&](const std::string& name) {
+        bool star = name == "*";
+        bool tableStar = name.size() > 2 && name.compare(name.size() - 2, 2, ".*") == 0;
+        if (star || tableStar) {
+            for (auto& input : inputs) {
+                if (star || input.name + ".*" == name) input.needed.assign(input.needed.size(), true);
+            }
+            return;
+        }
+        int idx = resolve(name);
+        if (idx != -1) inputs[owner[idx]].needed[idx - inputs[owner[idx]].first] = true;
+    };
+    markSelectColumns(stmt, mark);
+
+    // ON a = b: one side from the joined table, the other from those before it.
+    // Kept as (a, b) pairs of join columns, which also link the tables when
+    // the joins are reordered
+    std::vector<std::pair<int, int>> keys;
+    for (size_t j = 0; j < stmt->joins.size() && ok; ++j) {
+        size_t right = j + 1;
+        for (const auto& pair : stmt->joins[j].on) {
+            int a = resolve(pair.first);
+            int b = resolve(pair.second);
+            if (!ok) return nullptr;
+            if (a == -1 || b == -1) {
+                std::cout << "Error: Column " << (a == -1 ? pair.first : pair.second) << " not found.\n";
+                return nullptr;
+            }
+            if (owner[a] == right) std::swap(a, b);
+            if (owner[b] != right || owner[a] >= right) {
+                std::cout << "Error: JOIN " << inputs[right].name << " ON must compare one of its columns with a column of a table before it.\n";
+                return nullptr;
+            }
+            if (isIntType(columns[a].type) != isIntType(columns[b].type)) {
+                std::cout << "Error: JOIN ON compares " << columns[a].name << " and " << columns[b].name
+                          << ", which have different types.\n";
+                return nullptr;
             }
-            if (pass) filteredTable.rows.push_back(row);
+            mark(columns[a].name);
+            mark(columns[b].name);
+            keys.push_back({a, b});
         }
     }
-    
-    // Sort
-    if (!stmt->orderBy.empty()) {
-        int sortIdx = getColumnIndex(filteredTable, stmt->orderBy);
-        if (sortIdx != -1) {
-             bool isInt = (filteredTable.columns[sortIdx].type == "INT" || filteredTable.columns[sortIdx].type == "int");
-             if (!filteredTable.rows.empty())
-                quickSort(filteredTable.rows, 0, filteredTable.rows.size() - 1, sortIdx, isInt);
+
+    // WHERE terms on a single table go below the join
+    std::vector<const Expr*> terms, residual;
+    if (stmt->where) splitConjuncts(*stmt->where, terms);
+    for (const Expr* term : terms) {
+        int single = -1;
+        bool local = true;
+        markColumns(*term, [&](const std::string& name) {
+            mark(name);
+            int idx = resolve(name);
+            if (idx == -1 || (single != -1 && single != static_cast<int>(owner[idx]))) {
+                local = false;
+            } else {
+                single = static_cast<int>(owner[idx]);
+            }
+        });
+        if (local && single != -1 && inputs[single].pushable) {
+            inputs[single].where.push_back(term);
         } else {
-             std::cout << "Warning: Order By column " << stmt->orderBy << " not found.\n";
+            residual.push_back(term);
         }
     }
-    
-    if (stmt->columns.size() == 1 && stmt->columns[0] == "*") {
-        return filteredTable;
+    if (!ok) return nullptr;
+
+    // Bound before any scan is built, for the estimates
+    bool analyzed = true;
+    for (auto& input : inputs) {
+        input.filter = BoundPredicate::bindAll(input.columns, input.where, runSubquery());
+        input.stats = StorageManager::tableStats(input.schema.name);
+        analyzed = analyzed && input.stats;
+        input.estimate = input.rows * CostModel::selectivity(input.filter, input.stats.get());
     }
-    
-    Table resultTable;
-    resultTable.name = filteredTable.name;
-    std::vector<int> colIndices;
-    for(const auto& colName : stmt->columns) {
-        int idx = getColumnIndex(filteredTable, colName);
-        if(idx != -1) {
-            resultTable.columns.push_back(filteredTable.columns[idx]);
-            colIndices.push_back(idx);
-        } else {
-             // Ignore unknown columns or handle? AST parser puts them in.
+    auto inputRows = [&](const JoinInput& input) {
+        return analyzed ? input.estimate : static_cast<double>(input.rows);
+    };
+    // Distinct values of a join column among `rows` rows
+    auto distinct = [&](int column, double rows) {
+        const JoinInput& input = inputs[owner[column]];
+        return std::min(rows, input.stats->columns[column - input.first].distinct);
+    };
+
+    std::vector<bool> joined(inputs.size(), false);
+    double planRows = 0;
+    // The rows of a join of the plan so far with `input`, given the key pairs
+    // between them: without statistics, as many as its bigger side (a
+    // foreign key join)
+    auto estimateJoin = [&](size_t input, const std::vector<std::pair<int, int>>& pairs) {
+        double rows = inputRows(inputs[input]);
+        if (!analyzed) return std::max(planRows, rows);
+        double result = planRows * rows;
+        for (const auto& pair : pairs) {
+            result = std::min(result, CostModel::joinRows(planRows, rows, distinct(pair.first, planRows),
+                                                          distinct(pair.second, rows)));
+        }
+        return result;
+    };
+    // Key pairs between the plan so far and `input`, the plan's column first
+    auto keysTo = [&](size_t input) {
+        std::vector<std::pair<int, int>> pairs;
+        for (const auto& key : keys) {
+            if (owner[key.second] == input && joined[owner[key.first]]) pairs.push_back(key);
+            if (owner[key.first] == input && joined[owner[key.second]]) pairs.push_back({key.second, key.first});
         }
+        return pairs;
+    };
+
+    // Tables join in FROM order, unless all of them are analyzed and all
+    // joins are INNER: then the plan starts from the table with the fewest
+    // estimated rows and each time adds the one giving the smallest join
+    std::vector<size_t> order;
+    bool inner = std::none_of(stmt->joins.begin(), stmt->joins.end(), [](const JoinClause& j) { return j.left; });
+    if (analyzed && inner && inputs.size() > 2) {
+        size_t first = 0;
+        for (size_t i = 1; i < inputs.size(); ++i) {
+            if (inputs[i].estimate < inputs[first].estimate) first = i;
+        }
+        order.push_back(first);
+        joined[first] = true;
+        planRows = inputs[first].estimate;
+        while (order.size() < inputs.size()) {
+            size_t next = inputs.size();
+            double nextRows = 0;
+            for (size_t i = 0; i < inputs.size(); ++i) {
+                if (joined[i]) continue;
+                auto pairs = keysTo(i);
+                if (pairs.empty()) continue;
+                double rows = estimateJoin(i, pairs);
+                if (next == inputs.size() || rows < nextRows) {
+                    next = i;
+                    nextRows = rows;
+                }
+            }
+            order.push_back(next);
+            joined[next] = true;
+            planRows = nextRows;
+        }
+        joined.assign(inputs.size(), false);
+    } else {
+        for (size_t i = 0; i < inputs.size(); ++i) order.push_back(i);
     }
-    
-    for(const auto& row : filteredTable.rows) {
-        Row newRow;
-        for(int idx : colIndices) {
-            newRow.values.push_back(row.values[idx]);
+
+    // Left deep: each JOIN takes the plan so far on its left and builds on
+    // the side with fewer (estimated) rows
+    std::vector<int> position(columns.size(), -1); // of each join column in the plan
+    std::vector<Column> planColumns;
+    std::unique_ptr<Operator> plan;
+    for (size_t input : order) {
+        JoinInput& next = inputs[input];
+        auto scan = scanTable(next.schema, std::move(next.filter), next.needed, true);
+        for (size_t i = 0; i < next.columns.size(); ++i) position[next.first + i] = planColumns.size() + i;
+        planColumns.insert(planColumns.end(), next.columns.begin(), next.columns.end());
+        if (!plan) {
+            plan = std::move(scan);
+            planRows = inputRows(next);
+            joined[input] = true;
+            continue;
+        }
+        auto pairs = keysTo(input);
+        std::vector<int> leftKeys, rightKeys;
+        for (const auto& pair : pairs) {
+            leftKeys.push_back(position[pair.first]);
+            rightKeys.push_back(pair.second - static_cast<int>(next.first));
         }
-        resultTable.rows.push_back(newRow);
+        bool left = input > 0 && stmt->joins[input - 1].left;
+        bool buildLeft = planRows < inputRows(next);
+        plan = std::make_unique<HashJoinOperator>(std::move(plan), std::move(scan), leftKeys, rightKeys,
+                                                  left ? JoinType::LEFT : JoinType::INNER, buildLeft, planColumns);
+        double rows = estimateJoin(input, pairs);
+        planRows = left ? std::max(planRows, rows) : rows;
+        joined[input] = true;
     }
-    
-    return resultTable;
+    // Back to FROM order, which the WHERE and select list are bound to
+    for (size_t i = 0; i < order.size(); ++i) {
+        if (order[i] == i) continue;
+        plan = std::make_unique<ProjectOperator>(std::move(plan), position);
+        break;
+    }
+
+    if (!residual.empty()) {
+        plan = filterRows(std::move(plan), BoundPredicate::bindAll(columns, residual, runSubquery()));
+    }
+    return plan;
+}
+
+BoundPredicate::SubqueryRunner QueryExecutor::runSubquery() {
+    return [this](SelectStatement* stmt, const std::function<bool(const Row&)>& each) {
+        auto plan = buildSelectPlan(stmt);
+        // An empty answer would make NOT IN pass every row
+        if (!plan) throw std::runtime_error("Subquery failed.");
+        plan->open();
+        Row row;
+        while (plan->next(row) && each(row)) {}
+        plan->close();
+    };
 }
 
 void QueryExecutor::handleUpdate(UpdateStatement* stmt) {
-    Table table = StorageManager::loadTable(stmt->table);
+    Table table = StorageManager::getTableSchema(stmt->table);
     if (table.columns.empty()) {
         std::cout << "Error: Table " << stmt->table << " not found.\n";
         return;
@@ -292,16 +850,38 @@ void QueryExecutor::handleUpdate(UpdateStatement* stmt) {
          std::cout << "Error: Column " << stmt->column << " not found.\n";
          return;
     }
+    Value newValue;
+    if ((isIntType(table.columns[setIdx].type) && !Validators::isInteger(stmt->value)) ||
+        !Value::parse(stmt->value, table.columns[setIdx].type, newValue)) {
+         std::cout << "Error: Invalid INT value '" << stmt->value << "' for column '" << stmt->column << "'\n";
+         return;
+    }
     
+    BoundPredicate where = BoundPredicate::constant(true);
+    if (stmt->where) {
+        where = BoundPredicate::bind(qualifiedColumns(table.columns, stmt->table), *stmt->where, runSubquery());
+    }
+    auto matches = findMatchingRows(table, where);
     int count = 0;
-    for (auto& row : table.rows) {
-        if (stmt->condition.empty() || evaluateSimple(row, table, stmt->condition)) {
-            row.values[setIdx] = stmt->value;
-            count++;
+    bool ok = true;
+    StorageManager::beginTransaction();
+    for (const auto& match : matches) {
+        Row row = match.second;
+        row.values[setIdx] = newValue;
+        if (!StorageManager::updateRow(table, match.first, match.second, row)) {
+            ok = false;
+            break;
         }
+        count++;
+    }
+    // A row that fails part way rolls back the rows already written
+    if (ok) {
+        StorageManager::commitTransaction();
+    } else {
+        StorageManager::abortTransaction();
     }
     
-    if (StorageManager::saveTable(table)) {
+    if (ok) {
         std::cout << count << " rows updated.\n";
     } else {
         std::cout << "Error saving table.\n";
@@ -309,34 +889,157 @@ void QueryExecutor::handleUpdate(UpdateStatement* stmt) {
 }
 
 void QueryExecutor::handleDelete(DeleteStatement* stmt) {
-    Table table = StorageManager::loadTable(stmt->table);
-    if (table.columns.empty()) {
+    Table schema = StorageManager::getTableSchema(stmt->table);
+    if (schema.columns.empty()) {
         std::cout << "Error: Table " << stmt->table << " not found.\n";
         return;
     }
-    
-    Table newTable;
-    newTable.name = table.name;
-    newTable.columns = table.columns;
-    
+    if (!stmt->where) {
+        std::cout << "0 rows deleted.\n";
+        return;
+    }
+
+    auto matches = findMatchingRows(schema, BoundPredicate::bind(qualifiedColumns(schema.columns, stmt->table),
+                                                                 *stmt->where, runSubquery()));
     int count = 0;
-    for (const auto& row : table.rows) {
-        if (!stmt->condition.empty() && evaluateSimple(row, table, stmt->condition)) {
-            count++; // Skip (delete)
-        } else {
-            newTable.rows.push_back(row);
+    bool ok = true;
+    StorageManager::beginTransaction();
+    for (const auto& match : matches) {
+        if (!StorageManager::deleteRow(schema, match.first, match.second)) {
+            ok = false;
+            break;
         }
+        count++;
     }
-    
-    if (StorageManager::saveTable(newTable)) {
+    // A row that fails part way rolls back the rows already written
+    if (ok) {
+        StorageManager::commitTransaction();
+    } else {
+        StorageManager::abortTransaction();
+    }
+
+    if (ok) {
         std::cout << count << " rows deleted.\n";
     } else {
-         std::cout << "Error saving table.\n";
+        std::cout << "Error saving table.\n";
+    }
+}
+
+void QueryExecutor::handleCopy(CopyStatement* stmt) {
+    uint64_t rows = 0;
+    std::string error;
+    if (StorageManager::copyFrom(stmt->table, stmt->path, rows, error)) {
+        std::cout << rows << " rows copied.\n";
+    } else {
+        std::cout << "Error: " << error << "\n";
+    }
+}
+
+void QueryExecutor::handleVacuum(VacuumStatement* stmt) {
+    if (StorageManager::getTableSchema(stmt->table).columns.empty()) {
+        std::cout << "Error: Table " << stmt->table << " not found.\n";
+        return;
+    }
+    int64_t removed = StorageManager::vacuumTable(stmt->table);
+    if (removed < 0) {
+        std::cout << "Error saving table.\n";
+    } else {
+        std::cout << "Table '" << stmt->table << "' vacuumed, " << removed << " dead rows removed.\n";
+    }
+}
+
+void QueryExecutor::handleAnalyze(AnalyzeStatement* stmt) {
+    std::vector<std::string> tables = {stmt->table};
+    if (stmt->table.empty()) tables = StorageManager::listTables();
+    for (const auto& table : tables) {
+        if (StorageManager::getTableSchema(table).columns.empty()) {
+            std::cout << "Error: Table " << table << " not found.\n";
+        } else if (!StorageManager::analyzeTable(table)) {
+            std::cout << "Error saving statistics of " << table << ".\n";
+        } else {
+            std::cout << "Table '" << table << "' analyzed, " << StorageManager::tableStats(table)->rows << " rows.\n";
+        }
+    }
+}
+
+void QueryExecutor::handlePrepare(PrepareStatement* stmt) {
+    auto plan = std::make_shared<PlanCache::Plan>();
+    plan->body = std::move(stmt->body);
+    plan->parameters = std::move(stmt->parameters);
+    PlanCache::instance().prepare(stmt->name, stmt->text, std::move(plan));
+    std::cout << "Statement '" << stmt->name << "' prepared.\n";
+}
+
+void QueryExecutor::handleExecute(ExecuteStatement* stmt) {
+    std::shared_ptr<PlanCache::Plan> plan = PlanCache::instance().find(stmt->name);
+    if (!plan) {
+        std::cout << "Error: Prepared statement " << stmt->name << " not found.\n";
+        return;
+    }
+    if (stmt->arguments.size() != plan->parameters.size()) {
+        std::cout << "Error: " << stmt->name << " takes " << plan->parameters.size() << " parameter(s), got "
+                  << stmt->arguments.size() << ".\n";
+        return;
+    }
+    for (size_t i = 0; i < plan->parameters.size(); ++i) {
+        *plan->parameters[i].value = stmt->arguments[i];
+        // An argument is a value, never a column of an outer query
+        if (plan->parameters[i].quoted) *plan->parameters[i].quoted = true;
+    }
+    run(plan->body.get());
+}
+
+void QueryExecutor::handleDeallocate(DeallocateStatement* stmt) {
+    if (PlanCache::instance().deallocate(stmt->name)) {
+        std::cout << "Statement '" << stmt->name << "' deallocated.\n";
+    } else {
+        std::cout << "Error: Prepared statement " << stmt->name << " not found.\n";
     }
 }
 
 void QueryExecutor::handleSelect(SelectStatement* stmt) {
-    executeSelect(stmt).print();
+    ResultCache& cache = ResultCache::instance();
+    std::string key;
+    ResultCache::Versions versions;
+    if (cache.enabled()) {
+        key = stmt->cacheKey();
+        if (auto cached = cache.find(key)) {
+            Table::printHeader(cached->columns);
+            for (const auto& row : cached->rows) Table::printRow(row);
+            return;
+        }
+        std::vector<std::string> tables;
+        collectTables(stmt, tables);
+        for (const auto& table : tables) versions.push_back({table, StorageManager::tableVersion(table)});
+    }
+
+    auto plan = buildSelectPlan(stmt);
+    if (!plan) return;
+
+    // Stream rows straight from the plan to the console, keeping a copy for
+    // the cache as long as it fits
+    auto result = std::make_shared<ResultCache::Result>();
+    bool keep = cache.enabled();
+    size_t bytes = 0;
+    Table::printHeader(plan->columns());
+    plan->open();
+    Row row;
+    while (plan->next(row)) {
+        Table::printRow(row);
+        if (!keep) continue;
+        bytes += ResultCache::rowBytes(row);
+        if (bytes > cache.capacity()) {
+            keep = false;
+            result->rows = std::vector<Row>();
+        } else {
+            result->rows.push_back(std::move(row));
+        }
+    }
+    plan->close();
+    if (keep) {
+        result->columns = plan->columns();
+        cache.insert(key, std::move(versions), std::move(result), bytes);
+    }
 }
 
 } // namespace spl
\ No newline at end of file
@@ -4,9 +4,12 @@
 #include <memory>
 #include "../parser/AST.h"
 #include "../storage/StorageStructs.h"
+#include "BoundPredicate.h"
 
 namespace spl {
 
+class Operator;
+
 class QueryExecutor {
 public:
 	QueryExecutor() = default;
@@ -16,14 +19,26 @@ public:
 	void execute(std::unique_ptr<AST> ast);
 
 private:
+	void run(AST* ast);
 	void handleCreate(CreateStatement* stmt);
+	void handleCreateIndex(CreateIndexStatement* stmt);
 	void handleInsert(InsertStatement* stmt);
-	void handleSelect(SelectStatement* stmt); // Changed to void for now, will print result or return Table later.
-    // Making it return Table is better for nested queries.
-    Table executeSelect(SelectStatement* stmt);
+	void handleSelect(SelectStatement* stmt); // Streams the result to the console.
+    std::unique_ptr<Operator> buildSelectPlan(SelectStatement* stmt);
+    // FROM a JOIN b ...: scans with the single table WHERE terms pushed
+    // down, hash joins, then the rest of the WHERE.
+    std::unique_ptr<Operator> buildJoinPlan(SelectStatement* stmt);
+    // Runs IN and EXISTS subqueries while a WHERE is bound.
+    BoundPredicate::SubqueryRunner runSubquery();
 
 	void handleUpdate(UpdateStatement* stmt);
 	void handleDelete(DeleteStatement* stmt);
+	void handleCopy(CopyStatement* stmt);
+	void handleVacuum(VacuumStatement* stmt);
+	void handleAnalyze(AnalyzeStatement* stmt);
+	void handlePrepare(PrepareStatement* stmt);
+	void handleExecute(ExecuteStatement* stmt);
+	void handleDeallocate(DeallocateStatement* stmt);
 };
 
 } // namespace spl
@@ -0,0 +1,64 @@
+#include "ResultCache.h"
+#include <iterator>
+#include "../storage/StorageManager.h"
+
+namespace spl {
+
+ResultCache& ResultCache::instance() {
+    static ResultCache cache;
+    return cache;
+}
+
+void ResultCache::setCapacity(size_t bytes) {
+    std::lock_guard<std::mutex> lock(mutex);
+    budget = bytes;
+    shrink();
+}
+
+std::shared_ptr<const ResultCache::Result> ResultCache::find(const std::string& key) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = byKey.find(key);
+    if (it == byKey.end()) return nullptr;
+    for (const auto& table : it->second->versions) {
+        if (StorageManager::tableVersion(table.first) != table.second) {
+            erase(it->second);
+            return nullptr;
+        }
+    }
+    entries.splice(entries.begin(), entries, it->second);
+    return it->second->result;
+}
+
+void ResultCache::insert(const std::string& key, Versions versions, std::shared_ptr<const Result> result,
+                         size_t bytes) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (bytes > budget) return;
+    auto it = byKey.find(key);
+    if (it != byKey.end()) erase(it->second);
+    entries.push_front({key, std::move(versions), std::move(result), bytes});
+    byKey[key] = entries.begin();
+    used += bytes;
+    shrink();
+}
+
+size_t ResultCache::rowBytes(const Row& row) {
+    size_t bytes = sizeof(Row) + row.values.size() * sizeof(Value);
+    for (const auto& value : row.values) {
+        if (value.isString()) bytes += value.asString().size();
+    }
+    return bytes;
+}
+
+void ResultCache::erase(std::list<Entry>::iterator it) {
+    used -= it->bytes;
+    byKey.erase(it->key);
+    entries.erase(it);
+}
+
+void ResultCache::shrink() {
+    while (used > budget && !entries.empty()) {
+        erase(std::prev(entries.end()));
+    }
+}
+
+} // namespace spl
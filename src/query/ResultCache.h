@@ -0,0 +1,71 @@
+#ifndef SPL_RESULTCACHE_H
+#define SPL_RESULTCACHE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "../storage/StorageStructs.h"
+
+namespace spl {
+
+// Results of SELECT statements, keyed by the statement's normalized text
+// (SelectStatement::toString) and kept up to a budget of bytes, least
+// recently used first out. Each entry remembers the StorageManager::tableVersion
+// of every table the statement read; a lookup that finds one of them changed
+// drops the entry instead of returning it. Off (budget 0) unless
+// `.set result_cache_mb <n>` turns it on.
+class ResultCache {
+public:
+    struct Result {
+        std::vector<Column> columns;
+        std::vector<Row> rows;
+    };
+    // Table names with the version each had when the result was computed.
+    using Versions = std::vector<std::pair<std::string, uint64_t>>;
+
+    static ResultCache& instance();
+
+    // Drops entries until the cache fits; 0 empties it and turns it off.
+    void setCapacity(size_t bytes);
+    bool enabled() const { return budget > 0; }
+    size_t capacity() const { return budget; }
+
+    // Null on a miss or when a table changed since the result was stored.
+    std::shared_ptr<const Result> find(const std::string& key);
+    // `versions` must be taken before the statement ran. Results bigger
+    // than the whole budget are not kept.
+    void insert(const std::string& key, Versions versions, std::shared_ptr<const Result> result, size_t bytes);
+
+    // What a row costs the budget.
+    static size_t rowBytes(const Row& row);
+
+private:
+    ResultCache() = default;
+
+    struct Entry {
+        std::string key;
+        Versions versions;
+        std::shared_ptr<const Result> result;
+        size_t bytes;
+    };
+
+    std::mutex mutex;
+    size_t budget = 0;
+    size_t used = 0;
+    std::list<Entry> entries; // most recently used first
+    std::unordered_map<std::string, std::list<Entry>::iterator> byKey;
+
+    // Caller holds mutex.
+    void erase(std::list<Entry>::iterator it);
+    void shrink();
+};
+
+} // namespace spl
+
+#endif // SPL_RESULTCACHE_H
@@ -0,0 +1,110 @@
+#include "RowFile.h"
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+
+namespace spl {
+
+namespace fs = std::filesystem;
+
+namespace {
+
+std::atomic<uint64_t> fileCounter{0};
+
+template <typename T>
+void writeRaw(std::ofstream& out, T value) {
+    out.write(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+template <typename T>
+bool readRaw(std::ifstream& in, T& value) {
+    return static_cast<bool>(in.read(reinterpret_cast<char*>(&value), sizeof(value)));
+}
+
+} // namespace
+
+bool RowFileWriter::open(const std::string& path) {
+    out.open(path, std::ios::binary | std::ios::trunc);
+    return out.is_open();
+}
+
+void RowFileWriter::write(const std::string& key, const Row& row) {
+    writeRaw<uint32_t>(out, static_cast<uint32_t>(key.size()));
+    out.write(key.data(), key.size());
+    writeRaw<uint16_t>(out, static_cast<uint16_t>(row.values.size()));
+    for (const auto& v : row.values) {
+        writeRaw<uint8_t>(out, static_cast<uint8_t>(v.type()));
+        if (v.isInt()) {
+            writeRaw<int64_t>(out, v.asInt());
+        } else if (v.isString()) {
+            writeRaw<uint32_t>(out, static_cast<uint32_t>(v.asString().size()));
+            out.write(v.asString().data(), v.asString().size());
+        }
+    }
+}
+
+bool RowFileWriter::close() {
+    bool ok = static_cast<bool>(out.flush());
+    out.close();
+    return ok;
+}
+
+bool RowFileReader::open(const std::string& path) {
+    in.open(path, std::ios::binary);
+    error = !in.is_open();
+    return !error;
+}
+
+bool RowFileReader::next(std::string& key, Row& row) {
+    uint32_t keyLength;
+    if (!readRaw(in, keyLength)) {
+        error = !in.eof();
+        return false;
+    }
+    error = true;
+    key.resize(keyLength);
+    uint16_t cells;
+    if (!in.read(&key[0], keyLength) || !readRaw(in, cells)) return false;
+    row.values.resize(cells);
+    for (auto& v : row.values) {
+        uint8_t type;
+        if (!readRaw(in, type)) return false;
+        if (type == static_cast<uint8_t>(Value::Type::INT)) {
+            int64_t number;
+            if (!readRaw(in, number)) return false;
+            v = Value(number);
+        } else if (type == static_cast<uint8_t>(Value::Type::STRING)) {
+            uint32_t length;
+            if (!readRaw(in, length)) return false;
+            std::string text(length, '\0');
+            if (length > 0 && !in.read(&text[0], length)) return false;
+            v = Value(std::move(text));
+        } else {
+            v = Value();
+        }
+    }
+    error = false;
+    return true;
+}
+
+std::string tempRowFile(const std::string& prefix) {
+    return "db/" + prefix + "_" + std::to_string(fileCounter++) + ".run";
+}
+
+void removeTempRowFiles() {
+    std::error_code ec;
+    if (!fs::exists("db", ec)) return;
+    for (const auto& entry : fs::directory_iterator("db", ec)) {
+        if (entry.path().extension() == ".run") fs::remove(entry.path(), ec);
+    }
+}
+
+size_t rowMemory(const Row& row) {
+    size_t bytes = sizeof(Row) + row.values.size() * sizeof(Value);
+    for (const auto& v : row.values) {
+        if (v.isString()) bytes += v.asString().size();
+    }
+    return bytes;
+}
+
+} // namespace spl
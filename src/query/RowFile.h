@@ -0,0 +1,47 @@
+#ifndef SPL_ROWFILE_H
+#define SPL_ROWFILE_H
+
+#include <cstddef>
+#include <fstream>
+#include <string>
+#include "../storage/StorageStructs.h"
+
+namespace spl {
+
+// Temporary files of (key, row) records written by operators that spill to
+// disk (ExternalSorter, HashJoinOperator, HashAggregateOperator). Record: u32
+// key length, key, u16 cell count, then per cell a type byte followed by an
+// i64 (INT) or a u32 length and the bytes (STRING).
+class RowFileWriter {
+public:
+    bool open(const std::string& path);
+    void write(const std::string& key, const Row& row);
+    // Flushes; false if any write failed.
+    bool close();
+
+private:
+    std::ofstream out;
+};
+
+class RowFileReader {
+public:
+    bool open(const std::string& path);
+    // False at the end of the file or on a read error; failed() tells which.
+    bool next(std::string& key, Row& row);
+    bool failed() const { return error; }
+
+private:
+    std::ifstream in;
+    bool error = false;
+};
+
+// A new path db/<prefix>_<n>.run, unique within the process.
+std::string tempRowFile(const std::string& prefix);
+// Removes the .run files a crashed process left in db/.
+void removeTempRowFiles();
+// Rough memory a buffered row takes, for the operators' budgets.
+size_t rowMemory(const Row& row);
+
+} // namespace spl
+
+#endif // SPL_ROWFILE_H
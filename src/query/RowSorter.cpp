@@ -0,0 +1,102 @@
+#include "RowSorter.h"
+#include <algorithm>
+#include <numeric>
+
+namespace spl {
+
+namespace {
+
+const char TAG_NULL = 1, TAG_INT = 2, TAG_STRING = 3;
+
+uint64_t intKey(int64_t v) {
+    return static_cast<uint64_t>(v) ^ (uint64_t(1) << 63);
+}
+
+} // namespace
+
+void RowSorter::encodeKey(const Row& row, std::string& key) const {
+    key.clear();
+    for (const auto& col : columns) {
+        size_t start = key.size();
+        const Value& v = row.values[col.column];
+        if (v.isInt()) {
+            key.push_back(TAG_INT);
+            uint64_t k = intKey(v.asInt());
+            for (int shift = 56; shift >= 0; shift -= 8) key.push_back(static_cast<char>(k >> shift));
+        } else if (v.isString()) {
+            key.push_back(TAG_STRING);
+            for (char c : v.asString()) {
+                key.push_back(c);
+                if (c == '\0') key.push_back('\xFF');
+            }
+            key.append(2, '\0');
+        } else {
+            key.push_back(TAG_NULL);
+        }
+        if (col.descending) {
+            for (size_t i = start; i < key.size(); ++i) key[i] = static_cast<char>(~key[i]);
+        }
+    }
+}
+
+std::vector<uint32_t> RowSorter::order(const std::vector<Row>& rows) const {
+    std::vector<uint32_t> out;
+    if (radixOrder(rows, out)) return out;
+
+    std::vector<std::string> keys(rows.size());
+    for (size_t i = 0; i < rows.size(); ++i) encodeKey(rows[i], keys[i]);
+    out.resize(rows.size());
+    std::iota(out.begin(), out.end(), 0);
+    // The position breaks ties, so the order is stable without stable_sort
+    std::sort(out.begin(), out.end(), [&keys](uint32_t a, uint32_t b) {
+        int c = keys[a].compare(keys[b]);
+        return c < 0 || (c == 0 && a < b);
+    });
+    return out;
+}
+
+// LSD radix sort, 8 bits per pass; passes where every key has the same digit
+// are skipped, so narrow value ranges take few passes.
+bool RowSorter::radixOrder(const std::vector<Row>& rows, std::vector<uint32_t>& out) const {
+    if (columns.size() != 1) return false;
+    int col = columns[0].column;
+    bool desc = columns[0].descending;
+
+    struct Entry {
+        uint64_t key;
+        uint32_t pos;
+    };
+    std::vector<Entry> entries;
+    std::vector<uint32_t> nulls;
+    entries.reserve(rows.size());
+    for (size_t i = 0; i < rows.size(); ++i) {
+        const Value& v = rows[i].values[col];
+        if (v.isInt()) {
+            uint64_t k = intKey(v.asInt());
+            entries.push_back({desc ? ~k : k, static_cast<uint32_t>(i)});
+        } else if (v.isNull()) {
+            nulls.push_back(static_cast<uint32_t>(i));
+        } else {
+            return false;
+        }
+    }
+
+    std::vector<Entry> scratch(entries.size());
+    for (int shift = 0; shift < 64; shift += 8) {
+        size_t counts[257] = {0};
+        for (const auto& e : entries) counts[((e.key >> shift) & 0xFF) + 1]++;
+        if (std::find(counts + 1, counts + 257, entries.size()) != counts + 257) continue;
+        for (int d = 0; d < 256; ++d) counts[d + 1] += counts[d];
+        for (const auto& e : entries) scratch[counts[(e.key >> shift) & 0xFF]++] = e;
+        entries.swap(scratch);
+    }
+
+    out.clear();
+    out.reserve(rows.size());
+    if (!desc) out.insert(out.end(), nulls.begin(), nulls.end());
+    for (const auto& e : entries) out.push_back(e.pos);
+    if (desc) out.insert(out.end(), nulls.begin(), nulls.end());
+    return true;
+}
+
+} // namespace spl
@@ -0,0 +1,42 @@
+#ifndef SPL_ROWSORTER_H
+#define SPL_ROWSORTER_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "../storage/StorageStructs.h"
+
+namespace spl {
+
+struct SortColumn {
+    int column;
+    bool descending = false;
+};
+
+// Orders rows by an ORDER BY list without comparing Values: each row's sort
+// columns are encoded once into a normalized key whose byte order (memcmp) is
+// the ORDER BY order. Per column:
+//   tag byte   NULL 1, INT 2, STRING 3 (NULL sorts first)
+//   INT        8 bytes, big endian with the sign bit flipped
+//   STRING     the bytes with 0x00 escaped as 0x00 0xFF, then 0x00 0x00
+// DESC columns have all their bytes inverted.
+//
+// A single INT column is radix sorted on its 8 byte key; anything else goes
+// through std::sort (introsort) on the keys. Both are stable.
+class RowSorter {
+public:
+    explicit RowSorter(std::vector<SortColumn> columns) : columns(std::move(columns)) {}
+
+    void encodeKey(const Row& row, std::string& key) const;
+    // Positions of `rows` in sorted order.
+    std::vector<uint32_t> order(const std::vector<Row>& rows) const;
+
+private:
+    std::vector<SortColumn> columns;
+
+    bool radixOrder(const std::vector<Row>& rows, std::vector<uint32_t>& out) const;
+};
+
+} // namespace spl
+
+#endif // SPL_ROWSORTER_H
@@ -0,0 +1,434 @@
+#include "BPlusTree.h"
+#include "BufferPool.h"
+#include "StorageStructs.h"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+namespace spl {
+
+namespace fs = std::filesystem;
+
+namespace {
+
+const uint32_t INDEX_MAGIC = 0x58494246; // "FBIX"
+
+// Node page: header followed by fixed size entries.
+//   leaf entry:     key | rid
+//   internal entry: key | rid | child   (child holds entries >= key|rid)
+// `link` is the next leaf for leaves and the leftmost child for internal nodes.
+struct NodeHeader {
+    uint8_t leaf;
+    uint8_t pad;
+    uint16_t count;
+    uint32_t link;
+};
+
+NodeHeader* header(char* page) { return reinterpret_cast<NodeHeader*>(page); }
+
+size_t leafEntrySize(size_t keySize) { return keySize + sizeof(uint64_t); }
+size_t innerEntrySize(size_t keySize) { return keySize + sizeof(uint64_t) + sizeof(uint32_t); }
+size_t entrySize(bool leaf, size_t keySize) { return leaf ? leafEntrySize(keySize) : innerEntrySize(keySize); }
+size_t capacity(bool leaf, size_t keySize) { return (PAGE_SIZE - sizeof(NodeHeader)) / entrySize(leaf, keySize); }
+
+char* entryAt(char* page, size_t i, bool leaf, size_t keySize) {
+    return page + sizeof(NodeHeader) + i * entrySize(leaf, keySize);
+}
+
+uint64_t ridOf(const char* entry, size_t keySize) {
+    uint64_t rid;
+    std::memcpy(&rid, entry + keySize, sizeof(rid));
+    return rid;
+}
+
+uint32_t childOf(const char* entry, size_t keySize) {
+    uint32_t child;
+    std::memcpy(&child, entry + keySize + sizeof(uint64_t), sizeof(child));
+    return child;
+}
+
+void setChild(char* entry, size_t keySize, uint32_t child) {
+    std::memcpy(entry + keySize + sizeof(uint64_t), &child, sizeof(child));
+}
+
+// Orders by key bytes, then by rid.
+int compareEntry(const char* a, const char* b, size_t keySize) {
+    int c = std::memcmp(a, b, keySize);
+    if (c != 0) return c;
+    uint64_t ra = ridOf(a, keySize), rb = ridOf(b, keySize);
+    return ra < rb ? -1 : (ra > rb ? 1 : 0);
+}
+
+} // namespace
+
+bool BPlusTree::encodeKey(const Value& value, std::string& key) {
+    if (value.isInt()) {
+        uint64_t u = static_cast<uint64_t>(value.asInt()) ^ (1ULL << 63);
+        key.resize(INT_KEY_SIZE);
+        for (size_t i = 0; i < INT_KEY_SIZE; ++i) {
+            key[i] = static_cast<char>((u >> (8 * (INT_KEY_SIZE - 1 - i))) & 0xFF);
+        }
+    } else if (value.isString()) {
+        key = value.asString().substr(0, STRING_KEY_SIZE);
+        key.resize(STRING_KEY_SIZE, '\0');
+    } else {
+        return false;
+    }
+    return true;
+}
+
+bool BPlusTree::encodeKey(const std::string& value, bool isInt, std::string& key) {
+    Value cell;
+    return Value::parse(value, isInt ? "INT" : "STRING", cell) && encodeKey(cell, key);
+}
+
+bool BPlusTree::readMeta(Meta& meta) {
+    PageGuard page(path, 0);
+    if (!page.valid()) return false;
+    uint32_t magic;
+    std::memcpy(&magic, page.data(), sizeof(magic));
+    if (magic != INDEX_MAGIC) return false;
+    std::memcpy(&meta.root, page.data() + 4, sizeof(meta.root));
+    std::memcpy(&meta.keySize, page.data() + 8, sizeof(meta.keySize));
+    return true;
+}
+
+void BPlusTree::writeMeta(const Meta& meta) {
+    PageGuard page(path, 0);
+    if (!page.valid()) return;
+    std::memcpy(page.data(), &INDEX_MAGIC, sizeof(INDEX_MAGIC));
+    std::memcpy(page.data() + 4, &meta.root, sizeof(meta.root));
+    std::memcpy(page.data() + 8, &meta.keySize, sizeof(meta.keySize));
+    page.markDirty();
+}
+
+uint32_t BPlusTree::newNode(bool leaf) {
+    uint32_t pageNo;
+    char* page = BufferPool::instance().newPage(path, pageNo);
+    header(page)->leaf = leaf ? 1 : 0;
+    header(page)->count = 0;
+    header(page)->link = 0;
+    BufferPool::instance().unpinPage(path, pageNo, true);
+    return pageNo;
+}
+
+bool BPlusTree::create(bool isInt) {
+    BufferPool& pool = BufferPool::instance();
+    pool.discardFile(path);
+    {
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) return false;
+    }
+    uint32_t metaPage;
+    pool.newPage(path, metaPage);
+    pool.unpinPage(path, metaPage, true);
+
+    Meta meta;
+    meta.keySize = static_cast<uint16_t>(isInt ? INT_KEY_SIZE : STRING_KEY_SIZE);
+    meta.root = newNode(true);
+    writeMeta(meta);
+    return true;
+}
+
+bool BPlusTree::insertInto(uint32_t node, size_t keySize, const char* entry,
+                           bool& split, std::string& sepEntry, uint32_t& sepChild) {
+    split = false;
+    PageGuard page(path, node);
+    if (!page.valid()) return false;
+    char* data = page.data();
+    bool leaf = header(data)->leaf != 0;
+    uint16_t count = header(data)->count;
+
+    std::string toInsert; // entry to add to this node
+    if (leaf) {
+        toInsert.assign(entry, leafEntrySize(keySize));
+    } else {
+        uint32_t child = header(data)->link;
+        for (uint16_t i = 0; i < count; ++i) {
+            char* e = entryAt(data, i, false, keySize);
+            if (compareEntry(entry, e, keySize) < 0) break;
+            child = childOf(e, keySize);
+        }
+        bool childSplit;
+        std::string childSep;
+        uint32_t childRight;
+        if (!insertInto(child, keySize, entry, childSplit, childSep, childRight)) return false;
+        if (!childSplit) return true;
+        toInsert = childSep;
+        toInsert.resize(innerEntrySize(keySize));
+        setChild(&toInsert[0], keySize, childRight);
+    }
+
+    size_t width = entrySize(leaf, keySize);
+    uint16_t pos = 0;
+    while (pos < count && compareEntry(entryAt(data, pos, leaf, keySize), toInsert.data(), keySize) < 0) {
+        pos++;
+    }
+
+    if (count < capacity(leaf, keySize)) {
+        char* at = entryAt(data, pos, leaf, keySize);
+        std::memmove(at + width, at, (count - pos) * width);
+        std::memcpy(at, toInsert.data(), width);
+        header(data)->count++;
+        page.markDirty();
+        return true;
+    }
+
+    // Node is full: merge the new entry in and split the run in two.
+    std::string all(entryAt(data, 0, leaf, keySize), count * width);
+    all.insert(pos * width, toInsert);
+    size_t total = count + 1;
+    size_t leftCount = total / 2;
+
+    uint32_t rightNo = newNode(leaf);
+    PageGuard right(path, rightNo);
+    if (!right.valid()) return false;
+    char* rdata = right.data();
+
+    if (leaf) {
+        std::memcpy(entryAt(data, 0, true, keySize), all.data(), leftCount * width);
+        std::memcpy(entryAt(rdata, 0, true, keySize), all.data() + leftCount * width, (total - leftCount) * width);
+        header(data)->count = static_cast<uint16_t>(leftCount);
+        header(rdata)->count = static_cast<uint16_t>(total - leftCount);
+        header(rdata)->link = header(data)->link;
+        header(data)->link = rightNo;
+        sepEntry.assign(all.data() + leftCount * width, leafEntrySize(keySize));
+    } else {
+        // The middle entry moves up; its child becomes the right node's leftmost child.
+        const char* middle = all.data() + leftCount * width;
+        size_t rightCount = total - leftCount - 1;
+        std::memcpy(entryAt(data, 0, false, keySize), all.data(), leftCount * width);
+        std::memcpy(entryAt(rdata, 0, false, keySize), middle + width, rightCount * width);
+        header(data)->count = static_cast<uint16_t>(leftCount);
+        header(rdata)->count = static_cast<uint16_t>(rightCount);
+        header(rdata)->link = childOf(middle, keySize);
+        sepEntry.assign(middle, leafEntrySize(keySize));
+    }
+    page.markDirty();
+    right.markDirty();
+    split = true;
+    sepChild = rightNo;
+    return true;
+}
+
+bool BPlusTree::insert(const std::string& key, uint64_t rid) {
+    Meta meta;
+    if (!readMeta(meta) || key.size() != meta.keySize) return false;
+
+    std::string entry = key;
+    entry.append(reinterpret_cast<const char*>(&rid), sizeof(rid));
+
+    bool split;
+    std::string sep;
+    uint32_t right;
+    if (!insertInto(meta.root, meta.keySize, entry.data(), split, sep, right)) return false;
+    if (!split) return true;
+
+    // Root split: grow the tree by one level.
+    uint32_t rootNo = newNode(false);
+    PageGuard root(path, rootNo);
+    if (!root.valid()) return false;
+    header(root.data())->link = meta.root;
+    header(root.data())->count = 1;
+    char* e = entryAt(root.data(), 0, false, meta.keySize);
+    std::memcpy(e, sep.data(), leafEntrySize(meta.keySize));
+    setChild(e, meta.keySize, right);
+    root.markDirty();
+
+    meta.root = rootNo;
+    writeMeta(meta);
+    return true;
+}
+
+uint32_t BPlusTree::findLeaf(size_t keySize, const char* key, uint64_t rid, bool useRid) {
+    Meta meta;
+    if (!readMeta(meta)) return 0;
+
+    std::string probe(key, keySize);
+    probe.append(reinterpret_cast<const char*>(&rid), sizeof(rid));
+
+    uint32_t node = meta.root;
+    while (true) {
+        PageGuard page(path, node);
+        if (!page.valid()) return 0;
+        char* data = page.data();
+        if (header(data)->leaf) return node;
+
+        uint32_t child = header(data)->link;
+        for (uint16_t i = 0; i < header(data)->count; ++i) {
+            char* e = entryAt(data, i, false, keySize);
+            // Without a rid, stay left of equal keys: duplicates may start there.
+            int c = useRid ? compareEntry(probe.data(), e, keySize) : std::memcmp(key, e, keySize);
+            if (useRid ? c < 0 : c <= 0) break;
+            child = childOf(e, keySize);
+        }
+        node = child;
+    }
+}
+
+bool BPlusTree::remove(const std::string& key, uint64_t rid) {
+    Meta meta;
+    if (!readMeta(meta) || key.size() != meta.keySize) return false;
+    size_t keySize = meta.keySize;
+
+    std::string target = key;
+    target.append(reinterpret_cast<const char*>(&rid), sizeof(rid));
+
+    uint32_t node = findLeaf(keySize, key.data(), rid, true);
+    // Leaves are never merged, so the entry may sit in an emptied-out neighbour.
+    while (node != 0) {
+        PageGuard page(path, node);
+        if (!page.valid()) return false;
+        char* data = page.data();
+        uint16_t count = header(data)->count;
+        size_t width = leafEntrySize(keySize);
+        for (uint16_t i = 0; i < count; ++i) {
+            char* e = entryAt(data, i, true, keySize);
+            int c = compareEntry(e, target.data(), keySize);
+            if (c == 0) {
+                std::memmove(e, e + width, (count - i - 1) * width);
+                header(data)->count--;
+                page.markDirty();
+                return true;
+            }
+            if (c > 0) return false;
+        }
+        node = header(data)->link;
+    }
+    return false;
+}
+
+bool BPlusTree::build(bool isInt, const std::vector<std::pair<std::string, uint64_t>>& entries) {
+    if (!create(isInt)) return false;
+    Meta meta;
+    if (!readMeta(meta)) return false;
+    size_t keySize = meta.keySize;
+    if (entries.empty()) return true;
+
+    // Fill leaves left to right, starting with the empty root leaf.
+    std::vector<std::pair<std::string, uint32_t>> level; // (first entry, page)
+    size_t leafCap = capacity(true, keySize);
+    size_t width = leafEntrySize(keySize);
+    uint32_t leafNo = meta.root;
+    for (size_t start = 0; start < entries.size(); start += leafCap) {
+        if (start > 0) {
+            uint32_t next = newNode(true);
+            PageGuard prev(path, leafNo);
+            header(prev.data())->link = next;
+            prev.markDirty();
+            leafNo = next;
+        }
+        PageGuard leaf(path, leafNo);
+        if (!leaf.valid()) return false;
+        size_t n = std::min(leafCap, entries.size() - start);
+        for (size_t i = 0; i < n; ++i) {
+            const auto& entry = entries[start + i];
+            if (entry.first.size() != keySize) return false;
+            char* e = entryAt(leaf.data(), i, true, keySize);
+            std::memcpy(e, entry.first.data(), keySize);
+            std::memcpy(e + keySize, &entry.second, sizeof(uint64_t));
+        }
+        header(leaf.data())->count = static_cast<uint16_t>(n);
+        leaf.markDirty();
+        level.push_back({std::string(entryAt(leaf.data(), 0, true, keySize), width), leafNo});
+    }
+
+    // Build internal levels until a single root remains.
+    size_t innerCap = capacity(false, keySize);
+    while (level.size() > 1) {
+        std::vector<std::pair<std::string, uint32_t>> parents;
+        for (size_t start = 0; start < level.size(); start += innerCap + 1) {
+            size_t n = std::min(innerCap + 1, level.size() - start);
+            uint32_t nodeNo = newNode(false);
+            PageGuard node(path, nodeNo);
+            if (!node.valid()) return false;
+            header(node.data())->link = level[start].second;
+            for (size_t i = 1; i < n; ++i) {
+                char* e = entryAt(node.data(), i - 1, false, keySize);
+                std::memcpy(e, level[start + i].first.data(), width);
+                setChild(e, keySize, level[start + i].second);
+            }
+            header(node.data())->count = static_cast<uint16_t>(n - 1);
+            node.markDirty();
+            parents.push_back({level[start].first, nodeNo});
+        }
+        level.swap(parents);
+    }
+
+    meta.root = level[0].second;
+    writeMeta(meta);
+    return true;
+}
+
+bool BPlusTree::flush() {
+    return BufferPool::instance().flushFile(path);
+}
+
+bool BPlusTree::drop() {
+    BufferPool::instance().discardFile(path);
+    return fs::remove(path);
+}
+
+BPlusTree::Cursor BPlusTree::scan(const std::string* low, const std::string* high) {
+    Cursor cursor;
+    cursor.path = path;
+    Meta meta;
+    if (!readMeta(meta)) return cursor;
+    cursor.keySize = meta.keySize;
+    if (high && high->size() == meta.keySize) {
+        cursor.hasHigh = true;
+        cursor.high = *high;
+    }
+
+    if (low && low->size() == meta.keySize) {
+        cursor.page = findLeaf(meta.keySize, low->data(), 0, false);
+        PageGuard page(path, cursor.page);
+        if (!page.valid()) {
+            cursor.page = 0;
+            return cursor;
+        }
+        uint16_t count = header(page.data())->count;
+        while (cursor.pos < count &&
+               std::memcmp(entryAt(page.data(), cursor.pos, true, meta.keySize), low->data(), meta.keySize) < 0) {
+            cursor.pos++;
+        }
+    } else {
+        uint32_t node = meta.root;
+        while (true) {
+            PageGuard page(path, node);
+            if (!page.valid()) return cursor;
+            if (header(page.data())->leaf) break;
+            node = header(page.data())->link;
+        }
+        cursor.page = node;
+    }
+    return cursor;
+}
+
+bool BPlusTree::Cursor::next(uint64_t& rid) {
+    while (page != 0) {
+        PageGuard guard(path, page);
+        if (!guard.valid()) {
+            page = 0;
+            return false;
+        }
+        char* data = guard.data();
+        if (pos >= header(data)->count) {
+            page = header(data)->link;
+            pos = 0;
+            continue;
+        }
+        const char* e = entryAt(data, pos, true, keySize);
+        if (hasHigh && std::memcmp(e, high.data(), keySize) > 0) {
+            page = 0;
+            return false;
+        }
+        rid = ridOf(e, keySize);
+        pos++;
+        return true;
+    }
+    return false;
+}
+
+} // namespace spl
@@ -0,0 +1,77 @@
+#ifndef SPL_BPLUSTREE_H
+#define SPL_BPLUSTREE_H
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+#include "Page.h"
+#include "StorageStructs.h"
+
+namespace spl {
+
+// Disk-resident B+tree mapping column values to row ids, stored in
+// db/<table>.<index>.idx and accessed through the BufferPool.
+//
+// Keys are fixed width and compared with memcmp:
+//   INT    -> 8 bytes, big endian with the sign bit flipped
+//   STRING -> first 32 bytes, zero padded
+// Long strings therefore share keys; callers re-check the predicate on the
+// fetched rows. Duplicates are allowed: entries are ordered by (key, rid).
+class BPlusTree {
+public:
+    static constexpr size_t INT_KEY_SIZE = 8;
+    static constexpr size_t STRING_KEY_SIZE = 32;
+
+    explicit BPlusTree(const std::string& path) : path(path) {}
+
+    // Turns a cell into its key bytes. Fails for NULL.
+    static bool encodeKey(const Value& value, std::string& key);
+    // Same for a value written in a query. Fails for non-numeric INT values.
+    static bool encodeKey(const std::string& value, bool isInt, std::string& key);
+
+    bool create(bool isInt);
+    bool insert(const std::string& key, uint64_t rid);
+    bool remove(const std::string& key, uint64_t rid);
+    // Replaces the tree with the given (key, rid) entries, which must be sorted.
+    bool build(bool isInt, const std::vector<std::pair<std::string, uint64_t>>& entries);
+    bool flush();
+    bool drop();
+
+    // Walks leaf entries in key order between two optional, inclusive bounds.
+    class Cursor {
+    public:
+        bool next(uint64_t& rid);
+
+    private:
+        friend class BPlusTree;
+        std::string path;
+        size_t keySize = 0;
+        uint32_t page = 0;
+        uint16_t pos = 0;
+        bool hasHigh = false;
+        std::string high;
+    };
+    Cursor scan(const std::string* low, const std::string* high);
+
+private:
+    std::string path;
+
+    struct Meta {
+        uint32_t root;
+        uint16_t keySize;
+    };
+    bool readMeta(Meta& meta);
+    void writeMeta(const Meta& meta);
+
+    uint32_t newNode(bool leaf);
+    // Inserts below `node`. If the node had to split, `split` is set and the
+    // separator entry and new right sibling are returned for the parent.
+    bool insertInto(uint32_t node, size_t keySize, const char* entry,
+                    bool& split, std::string& sepEntry, uint32_t& sepChild);
+    uint32_t findLeaf(size_t keySize, const char* key, uint64_t rid, bool useRid);
+};
+
+} // namespace spl
+
+#endif // SPL_BPLUSTREE_H
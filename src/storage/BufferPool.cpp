@@ -0,0 +1,368 @@
+#include "BufferPool.h"
+#include <cstring>
+#include <filesystem>
+#include <stdexcept>
+
+namespace spl {
+
+namespace fs = std::filesystem;
+
+namespace {
+const size_t DEFAULT_POOL_PAGES = 16384; // 64 MB
+const size_t MIN_POOL_PAGES = 16;
+}
+
+BufferPool& BufferPool::instance() {
+    static BufferPool pool;
+    return pool;
+}
+
+BufferPool::BufferPool() : maxFrames(DEFAULT_POOL_PAGES) {}
+
+BufferPool::FileState& BufferPool::fileState(const std::string& path, uint32_t& fileId) {
+    auto it = fileIds.find(path);
+    if (it == fileIds.end()) {
+        it = fileIds.emplace(path, nextFileId++).first;
+    }
+    fileId = it->second;
+    FileState& state = files[fileId];
+    if (!state.sizeKnown) {
+        state.path = path;
+        std::error_code ec;
+        auto size = fs::file_size(path, ec);
+        state.pageCount = ec ? 0 : static_cast<uint32_t>(size / PAGE_SIZE);
+        state.sizeKnown = true;
+    }
+    return state;
+}
+
+std::fstream& BufferPool::stream(FileState& state) {
+    if (!state.stream.is_open()) {
+        if (!fs::exists(state.path)) {
+            std::ofstream create(state.path, std::ios::binary);
+        }
+        state.stream.open(state.path, std::ios::binary | std::ios::in | std::ios::out);
+        if (!state.stream.is_open()) {
+            throw std::runtime_error("Could not open " + state.path);
+        }
+    }
+    state.stream.clear();
+    return state.stream;
+}
+
+size_t BufferPool::allocateFrame() {
+    if (frames.size() < maxFrames) {
+        Frame frame;
+        frame.data.reset(new char[PAGE_SIZE]);
+        frames.push_back(std::move(frame));
+        return frames.size() - 1;
+    }
+
+    // CLOCK: skip pinned frames, give referenced frames a second chance.
+    // Pages dirtied by the open transaction are never taken: the log holds no
+    // before-images, so an uncommitted page must not reach the data file.
+    bool heldByTransaction = false;
+    for (size_t step = 0; step < 2 * frames.size(); ++step) {
+        size_t idx = clockHand;
+        clockHand = (clockHand + 1) % frames.size();
+        Frame& frame = frames[idx];
+        if (!frame.used) return idx;
+        if (frame.pinCount > 0) continue;
+        if (frame.tracked) {
+            heldByTransaction = true;
+            continue;
+        }
+        if (frame.referenced) {
+            frame.referenced = false;
+            continue;
+        }
+        if (frame.dirty) writeFrame(frame);
+        pageTable.erase(key(frame.fileId, frame.pageNo));
+        frame.used = false;
+        counters.evictions++;
+        return idx;
+    }
+    if (!heldByTransaction) throw std::runtime_error("Buffer pool exhausted: every page is pinned");
+
+    // The transaction has dirtied more pages than the pool holds: grow past
+    // the budget until it commits rather than spill its changes.
+    Frame frame;
+    frame.data.reset(new char[PAGE_SIZE]);
+    frames.push_back(std::move(frame));
+    return frames.size() - 1;
+}
+
+bool BufferPool::writeFrame(Frame& frame) {
+    FileState& state = files[frame.fileId];
+    std::fstream& out = stream(state);
+    out.seekp(static_cast<std::streamoff>(frame.pageNo) * PAGE_SIZE);
+    out.write(frame.data.get(), PAGE_SIZE);
+    frame.dirty = false;
+    state.unsynced = true;
+    counters.writes++;
+    return static_cast<bool>(out);
+}
+
+void BufferPool::markDirty(size_t frameIdx) {
+    Frame& frame = frames[frameIdx];
+    if (tracking) {
+        writtenPages.insert(key(frame.fileId, frame.pageNo));
+        frame.tracked = true;
+    }
+    if (!frame.dirty) {
+        frame.dirty = true;
+        files[frame.fileId].dirtyFrames.push_back(frameIdx);
+    }
+}
+
+char* BufferPool::fetchPage(const std::string& file, uint32_t pageNo) {
+    std::lock_guard<std::mutex> lock(mutex);
+    uint32_t fileId;
+    FileState& state = fileState(file, fileId);
+    if (pageNo >= state.pageCount) return nullptr;
+
+    auto it = pageTable.find(key(fileId, pageNo));
+    if (it != pageTable.end()) {
+        Frame& frame = frames[it->second];
+        frame.pinCount++;
+        frame.referenced = true;
+        counters.hits++;
+        return frame.data.get();
+    }
+
+    counters.misses++;
+    size_t idx = allocateFrame();
+    Frame& frame = frames[idx];
+    std::fstream& in = stream(state);
+    in.seekg(static_cast<std::streamoff>(pageNo) * PAGE_SIZE);
+    in.read(frame.data.get(), PAGE_SIZE);
+    std::streamsize got = in.gcount();
+    if (got < static_cast<std::streamsize>(PAGE_SIZE)) {
+        std::memset(frame.data.get() + got, 0, PAGE_SIZE - got);
+    }
+
+    frame.fileId = fileId;
+    frame.pageNo = pageNo;
+    frame.pinCount = 1;
+    frame.dirty = false;
+    frame.referenced = true;
+    frame.used = true;
+    frame.tracked = false;
+    pageTable[key(fileId, pageNo)] = idx;
+    return frame.data.get();
+}
+
+char* BufferPool::newPage(const std::string& file, uint32_t& pageNo) {
+    std::lock_guard<std::mutex> lock(mutex);
+    uint32_t fileId;
+    FileState& state = fileState(file, fileId);
+
+    size_t idx = allocateFrame();
+    if (tracking) trackedPageCounts.emplace(fileId, state.pageCount);
+    pageNo = state.pageCount++;
+    Frame& frame = frames[idx];
+    std::memset(frame.data.get(), 0, PAGE_SIZE);
+    frame.fileId = fileId;
+    frame.pageNo = pageNo;
+    frame.pinCount = 1;
+    frame.dirty = false;
+    frame.referenced = true;
+    frame.used = true;
+    frame.tracked = false;
+    pageTable[key(fileId, pageNo)] = idx;
+    markDirty(idx);
+    return frame.data.get();
+}
+
+void BufferPool::unpinPage(const std::string& file, uint32_t pageNo, bool dirty) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto id = fileIds.find(file);
+    if (id == fileIds.end()) return;
+    auto it = pageTable.find(key(id->second, pageNo));
+    if (it == pageTable.end()) return;
+
+    Frame& frame = frames[it->second];
+    if (frame.pinCount > 0) frame.pinCount--;
+    if (dirty) markDirty(it->second);
+}
+
+uint32_t BufferPool::pageCount(const std::string& file) {
+    std::lock_guard<std::mutex> lock(mutex);
+    uint32_t fileId;
+    return fileState(file, fileId).pageCount;
+}
+
+bool BufferPool::flushFile(const std::string& file) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto id = fileIds.find(file);
+    if (id == fileIds.end()) return true;
+    FileState& state = files[id->second];
+
+    bool ok = true;
+    for (size_t idx : state.dirtyFrames) {
+        // A trimmed frame was written before it went
+        if (idx >= frames.size()) continue;
+        Frame& frame = frames[idx];
+        if (frame.used && frame.dirty && frame.fileId == id->second) {
+            ok = writeFrame(frame) && ok;
+        }
+    }
+    state.dirtyFrames.clear();
+    if (state.stream.is_open()) state.stream.flush();
+    return ok;
+}
+
+std::vector<std::string> BufferPool::flushAll() {
+    std::vector<std::string> paths;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (const auto& entry : fileIds) paths.push_back(entry.first);
+    }
+    for (const auto& path : paths) flushFile(path);
+
+    std::vector<std::string> written;
+    std::lock_guard<std::mutex> lock(mutex);
+    for (auto& entry : files) {
+        if (entry.second.unsynced) {
+            written.push_back(entry.second.path);
+            entry.second.unsynced = false;
+        }
+    }
+    return written;
+}
+
+void BufferPool::discardFile(const std::string& file) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto id = fileIds.find(file);
+    if (id == fileIds.end()) return;
+
+    for (auto& frame : frames) {
+        if (frame.used && frame.fileId == id->second) {
+            pageTable.erase(key(frame.fileId, frame.pageNo));
+            frame.used = false;
+            frame.dirty = false;
+            frame.tracked = false;
+            frame.pinCount = 0;
+        }
+    }
+    files.erase(id->second);
+    fileIds.erase(id);
+}
+
+bool BufferPool::setCapacity(size_t pages) {
+    if (pages < MIN_POOL_PAGES) pages = MIN_POOL_PAGES;
+    std::lock_guard<std::mutex> lock(mutex);
+    if (pages >= frames.size()) {
+        maxFrames = pages;
+        return true;
+    }
+
+    for (const auto& frame : frames) {
+        if (frame.used && frame.pinCount > 0) return false;
+    }
+    for (auto& frame : frames) {
+        if (frame.used && frame.dirty) writeFrame(frame);
+    }
+    for (auto& entry : files) {
+        entry.second.dirtyFrames.clear();
+        if (entry.second.stream.is_open()) entry.second.stream.flush();
+    }
+    frames.clear();
+    pageTable.clear();
+    clockHand = 0;
+    maxFrames = pages;
+    return true;
+}
+
+size_t BufferPool::capacity() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return maxFrames;
+}
+
+size_t BufferPool::residentPages() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return pageTable.size();
+}
+
+BufferPool::Stats BufferPool::stats() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return counters;
+}
+
+void BufferPool::trackWrites() {
+    std::lock_guard<std::mutex> lock(mutex);
+    tracking = true;
+    writtenPages.clear();
+    trackedPageCounts.clear();
+}
+
+std::vector<std::pair<std::string, uint32_t>> BufferPool::takeWrittenPages() {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::unordered_map<uint32_t, std::string> paths;
+    for (const auto& entry : fileIds) paths[entry.second] = entry.first;
+
+    std::vector<std::pair<std::string, uint32_t>> pages;
+    for (uint64_t k : writtenPages) {
+        auto it = paths.find(static_cast<uint32_t>(k >> 32));
+        if (it != paths.end()) pages.push_back({it->second, static_cast<uint32_t>(k)});
+        auto frame = pageTable.find(k);
+        if (frame != pageTable.end()) frames[frame->second].tracked = false;
+    }
+    writtenPages.clear();
+    trackedPageCounts.clear();
+    tracking = false;
+    return pages;
+}
+
+std::vector<std::pair<std::string, uint32_t>> BufferPool::discardWrittenPages() {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::unordered_map<uint32_t, std::string> paths;
+    for (const auto& entry : fileIds) paths[entry.second] = entry.first;
+
+    std::vector<std::pair<std::string, uint32_t>> pages;
+    for (uint64_t k : writtenPages) {
+        auto it = paths.find(static_cast<uint32_t>(k >> 32));
+        if (it != paths.end()) pages.push_back({it->second, static_cast<uint32_t>(k)});
+        auto frame = pageTable.find(k);
+        if (frame == pageTable.end()) continue;
+        Frame& f = frames[frame->second];
+        f.used = false;
+        f.dirty = false;
+        f.tracked = false;
+        f.pinCount = 0;
+        pageTable.erase(frame);
+    }
+    // Tracked frames are never evicted, so the new pages never reached the file
+    for (const auto& entry : trackedPageCounts) {
+        auto state = files.find(entry.first);
+        if (state != files.end()) state->second.pageCount = entry.second;
+    }
+    writtenPages.clear();
+    trackedPageCounts.clear();
+    tracking = false;
+    trimLocked();
+    return pages;
+}
+
+void BufferPool::trimToCapacity() {
+    std::lock_guard<std::mutex> lock(mutex);
+    trimLocked();
+}
+
+void BufferPool::trimLocked() {
+    // Only the last frame can go without moving others, and a pinned frame's
+    // data must stay where its user holds it: stop at the first that can't
+    while (frames.size() > maxFrames) {
+        Frame& frame = frames.back();
+        if (frame.used) {
+            if (frame.pinCount > 0 || frame.tracked) break;
+            if (frame.dirty) writeFrame(frame);
+            pageTable.erase(key(frame.fileId, frame.pageNo));
+            counters.evictions++;
+        }
+        frames.pop_back();
+    }
+    if (clockHand >= frames.size()) clockHand = 0;
+}
+
+} // namespace spl
@@ -0,0 +1,142 @@
+#ifndef SPL_BUFFERPOOL_H
+#define SPL_BUFFERPOOL_H
+
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "Page.h"
+
+namespace spl {
+
+// Process-wide cache of file pages. Every page read or written by the storage
+// layer goes through here. Pages are pinned while in use and evicted with the
+// CLOCK algorithm once the memory budget is reached; dirty pages are written
+// back on eviction or when their file is flushed.
+class BufferPool {
+public:
+    struct Stats {
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        uint64_t evictions = 0;
+        uint64_t writes = 0;
+    };
+
+    static BufferPool& instance();
+
+    // Pins an existing page. Returns nullptr if the page is past the end of the file.
+    char* fetchPage(const std::string& file, uint32_t pageNo);
+    // Extends the file by one zeroed page and pins it.
+    char* newPage(const std::string& file, uint32_t& pageNo);
+    void unpinPage(const std::string& file, uint32_t pageNo, bool dirty);
+
+    // Number of pages in the file, including new pages not yet written out.
+    uint32_t pageCount(const std::string& file);
+
+    bool flushFile(const std::string& file);
+    // Writes every dirty page. Returns the files written to since the previous
+    // flushAll, so the caller can fsync them.
+    std::vector<std::string> flushAll();
+    // Forgets every cached page of a file without writing it (file removed or replaced).
+    void discardFile(const std::string& file);
+
+    // Memory budget in pages. Fails if the pool is shrunk while pages are pinned.
+    bool setCapacity(size_t pages);
+    size_t capacity() const;
+    size_t residentPages() const;
+    Stats stats() const;
+
+    // Write tracking for the log: between trackWrites() and takeWrittenPages()
+    // the pool records every page that is dirtied. Those pages are never
+    // evicted, so uncommitted changes do not reach the disk; if nothing else can
+    // be evicted the pool grows past its capacity to hold them.
+    void trackWrites();
+    std::vector<std::pair<std::string, uint32_t>> takeWrittenPages();
+    // Ends tracking by forgetting the tracked pages without writing them, and
+    // shrinks files back to their length before trackWrites(). Returns the
+    // forgotten pages; committed content must be restored by the caller.
+    std::vector<std::pair<std::string, uint32_t>> discardWrittenPages();
+    // Gives back the frames the pool grew by past its capacity, as far as
+    // they are neither pinned nor tracked. The log calls it once a commit is
+    // logged; discardWrittenPages does so itself.
+    void trimToCapacity();
+
+private:
+    struct Frame {
+        std::unique_ptr<char[]> data;
+        uint32_t fileId = 0;
+        uint32_t pageNo = 0;
+        int pinCount = 0;
+        bool dirty = false;
+        bool referenced = false;
+        bool used = false;
+        bool tracked = false;
+    };
+
+    struct FileState {
+        std::string path;
+        std::fstream stream;
+        uint32_t pageCount = 0;
+        bool sizeKnown = false;
+        bool unsynced = false;
+        std::vector<size_t> dirtyFrames;
+    };
+
+    BufferPool();
+
+    mutable std::mutex mutex;
+    size_t maxFrames;
+    size_t clockHand = 0;
+    std::vector<Frame> frames;
+    std::unordered_map<uint64_t, size_t> pageTable;
+    std::unordered_map<std::string, uint32_t> fileIds;
+    std::unordered_map<uint32_t, FileState> files;
+    uint32_t nextFileId = 1;
+    Stats counters;
+    bool tracking = false;
+    std::set<uint64_t> writtenPages;
+    // Page count of each file extended while tracking, before its first new page.
+    std::unordered_map<uint32_t, uint32_t> trackedPageCounts;
+
+    static uint64_t key(uint32_t fileId, uint32_t pageNo) {
+        return (static_cast<uint64_t>(fileId) << 32) | pageNo;
+    }
+
+    FileState& fileState(const std::string& path, uint32_t& fileId);
+    std::fstream& stream(FileState& state);
+    size_t allocateFrame();
+    void trimLocked();
+    bool writeFrame(Frame& frame);
+    void markDirty(size_t frameIdx);
+};
+
+// Pins a page for the lifetime of the guard.
+class PageGuard {
+public:
+    PageGuard(const std::string& file, uint32_t pageNo)
+        : file(file), pageNo(pageNo), page(BufferPool::instance().fetchPage(file, pageNo)) {}
+    PageGuard(const PageGuard&) = delete;
+    PageGuard& operator=(const PageGuard&) = delete;
+    ~PageGuard() {
+        if (page) BufferPool::instance().unpinPage(file, pageNo, dirty);
+    }
+
+    char* data() const { return page; }
+    bool valid() const { return page != nullptr; }
+    void markDirty() { dirty = true; }
+
+private:
+    std::string file;
+    uint32_t pageNo;
+    char* page;
+    bool dirty = false;
+};
+
+} // namespace spl
+
+#endif // SPL_BUFFERPOOL_H
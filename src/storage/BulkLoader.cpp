@@ -0,0 +1,203 @@
+#include "BulkLoader.h"
+#include "ColumnStore.h"
+#include "HeapFile.h"
+#include "Page.h"
+#include "../utils/TaskScheduler.h"
+#include "../utils/Validators.h"
+#include <algorithm>
+#include <deque>
+#include <fstream>
+#include <memory>
+
+namespace spl {
+
+namespace {
+
+// Bytes of the file read for each chunk (plus the rest of its last line).
+const size_t CHUNK_BYTES = 4 << 20;
+
+bool splitCsvLine(const char* p, const char* end, std::vector<std::string>& fields) {
+    fields.clear();
+    while (true) {
+        std::string field;
+        if (p < end && *p == '"') {
+            ++p;
+            while (true) {
+                if (p >= end) return false; // unterminated quote
+                if (*p == '"') {
+                    if (p + 1 < end && p[1] == '"') {
+                        field += '"';
+                        p += 2;
+                        continue;
+                    }
+                    ++p;
+                    break;
+                }
+                field += *p++;
+            }
+            if (p < end && *p != ',') return false;
+        } else {
+            const char* comma = std::find(p, end, ',');
+            field.assign(p, comma);
+            p = comma;
+        }
+        fields.push_back(std::move(field));
+        if (p >= end) return true;
+        ++p; // ','
+    }
+}
+
+} // namespace
+
+void BulkLoader::parseChunk(Chunk& chunk) const {
+    const std::string& data = chunk.data;
+    bool columnar = schema.format == TableFormat::COLUMNAR;
+    std::string page(PAGE_SIZE, '\0');
+    SlottedPage slotted(&page[0]);
+    slotted.init();
+    std::vector<std::string> fields;
+    Row row;
+    std::string record;
+
+    size_t pos = 0;
+    while (pos < data.size()) {
+        size_t eol = data.find('\n', pos);
+        if (eol == std::string::npos) eol = data.size();
+        size_t lineEnd = eol;
+        if (lineEnd > pos && data[lineEnd - 1] == '\r') lineEnd--;
+        chunk.lines++;
+        const char* begin = data.data() + pos;
+        const char* end = data.data() + lineEnd;
+        pos = eol + 1;
+        if (begin == end) continue;
+
+        auto fail = [&](const std::string& message) {
+            chunk.errorLine = chunk.lines;
+            chunk.error = message;
+        };
+        if (!splitCsvLine(begin, end, fields)) {
+            fail("malformed quoted value");
+            return;
+        }
+        if (fields.size() != schema.columns.size()) {
+            fail("expected " + std::to_string(schema.columns.size()) + " values, got " +
+                 std::to_string(fields.size()));
+            return;
+        }
+        row.values.resize(fields.size());
+        for (size_t c = 0; c < fields.size(); ++c) {
+            const Column& col = schema.columns[c];
+            if (isIntType(col.type) && !Validators::isInteger(fields[c])) {
+                fail("invalid INT value '" + fields[c] + "' for column '" + col.name + "'");
+                return;
+            }
+            if (!Value::parse(fields[c], col.type, row.values[c])) {
+                fail("INT value '" + fields[c] + "' out of range for column '" + col.name + "'");
+                return;
+            }
+        }
+
+        if (!encodeRow(row, schema.columns, record)) {
+            fail("row too large");
+            return;
+        }
+        chunk.rowCount++;
+        if (columnar) {
+            chunk.rows.push_back(std::move(row));
+            continue;
+        }
+        if (slotted.insert(record) < 0) {
+            chunk.pages.push_back(page);
+            slotted.init();
+            slotted.insert(record);
+        }
+    }
+    if (!columnar && slotted.slotCount() > 0) chunk.pages.push_back(page);
+}
+
+bool BulkLoader::load(const std::string& path, uint64_t& rows, std::string& error) {
+    rows = 0;
+    std::ifstream in(path, std::ios::binary);
+    if (!in.is_open()) {
+        error = "could not open '" + path + "'";
+        return false;
+    }
+
+    bool columnar = schema.format == TableFormat::COLUMNAR;
+    ColumnStore store(schema);
+    HeapFile heap("db/" + schema.name + ".tbl");
+    uint64_t firstRow = columnar ? store.rowCount() : 0;
+    uint32_t firstPage = columnar ? 0 : heap.pageCount();
+
+    size_t maxInFlight = 2 * TaskScheduler::instance().workers();
+    std::deque<std::unique_ptr<Chunk>> inFlight;
+    size_t lineBase = 0;
+
+    // Waits for the oldest chunk and appends what it parsed
+    auto writeOldest = [&]() {
+        std::unique_ptr<Chunk> chunk = std::move(inFlight.front());
+        inFlight.pop_front();
+        chunk->parse.wait();
+        if (chunk->errorLine != 0) {
+            error = "line " + std::to_string(lineBase + chunk->errorLine) + ": " + chunk->error;
+            return false;
+        }
+        lineBase += chunk->lines;
+        bool written = true;
+        if (columnar) {
+            written = store.appendRows(chunk->rows);
+        } else {
+            for (const auto& page : chunk->pages) {
+                if (!(written = heap.appendPage(page.data()))) break;
+            }
+        }
+        if (!written) {
+            error = "could not write to table";
+            return false;
+        }
+        rows += chunk->rowCount;
+        return true;
+    };
+
+    bool ok = true;
+    std::string pending; // read, not yet handed to a chunk
+    while (ok) {
+        size_t had = pending.size();
+        pending.resize(had + CHUNK_BYTES);
+        in.read(&pending[had], CHUNK_BYTES);
+        pending.resize(had + static_cast<size_t>(in.gcount()));
+        bool last = !in;
+
+        // A chunk ends just after a newline; the partial line waits for the next read
+        size_t cut = pending.size();
+        if (!last) {
+            size_t nl = pending.rfind('\n');
+            cut = nl == std::string::npos ? 0 : nl + 1;
+        }
+        if (cut > 0) {
+            auto chunk = std::make_unique<Chunk>();
+            chunk->data.assign(pending, 0, cut);
+            pending.erase(0, cut);
+            Chunk* parsed = chunk.get();
+            parsed->parse.run([this, parsed] { parseChunk(*parsed); });
+            inFlight.push_back(std::move(chunk));
+        }
+        while (ok && !inFlight.empty() && (last || inFlight.size() > maxInFlight)) {
+            ok = writeOldest();
+        }
+        if (last) break;
+    }
+    inFlight.clear(); // waits for chunks still being parsed after a failure
+    if (ok) return true;
+
+    // All or nothing: drop what the chunks before the failing one appended
+    if (columnar) {
+        store.truncate(firstRow);
+    } else {
+        heap.truncate(firstPage);
+    }
+    rows = 0;
+    return false;
+}
+
+} // namespace spl
@@ -0,0 +1,52 @@
+#ifndef SPL_BULKLOADER_H
+#define SPL_BULKLOADER_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "StorageStructs.h"
+#include "../utils/TaskScheduler.h"
+
+namespace spl {
+
+// Loads a CSV file into a table (COPY t FROM 'file').
+//
+// The file is read in fixed-size chunks cut at line boundaries, and each chunk
+// is parsed, validated and encoded by a TaskScheduler task. Heap rows are
+// packed into finished pages by the tasks, so writing is a matter of
+// appending those pages. Chunks are written in file order as soon as they are
+// parsed, with at most two per worker in flight, so memory does not grow with
+// the file. If any line is invalid, the table is truncated back to where the
+// load started.
+//
+// Format: one row per line, values separated by ','. A value may be wrapped
+// in double quotes to hold commas ("" inside quotes is a literal quote), but
+// not line breaks.
+class BulkLoader {
+public:
+    explicit BulkLoader(const Table& schema) : schema(schema) {}
+
+    // `rows` receives the number of rows loaded, `error` the reason on failure.
+    // Expects the table's pages to be on disk (COPY checkpoints first).
+    bool load(const std::string& path, uint64_t& rows, std::string& error);
+
+private:
+    struct Chunk {
+        std::string data; // whole lines, the last one maybe without its newline
+        TaskGroup parse;
+        size_t lines = 0;
+        uint64_t rowCount = 0;
+        std::vector<std::string> pages; // heap tables
+        std::vector<Row> rows;          // columnar tables
+        size_t errorLine = 0;           // 1-based within the chunk, 0 if none
+        std::string error;
+    };
+
+    Table schema;
+
+    void parseChunk(Chunk& chunk) const;
+};
+
+} // namespace spl
+
+#endif // SPL_BULKLOADER_H
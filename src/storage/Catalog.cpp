@@ -0,0 +1,303 @@
+#include "Catalog.h"
+#include "LogManager.h"
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <sstream>
+
+namespace spl {
+
+namespace fs = std::filesystem;
+
+namespace {
+
+const char* MANIFEST_PATH = "db/catalog.manifest";
+
+// Format of the db/<table>.schema files written before the manifest existed.
+Table readSchemaFile(const fs::path& path) {
+    Table table;
+    table.name = path.stem().string();
+    std::ifstream schemaFile(path);
+    std::string line;
+    while (std::getline(schemaFile, line)) {
+        std::stringstream ss(line);
+        std::string name, type;
+        ss >> name >> type;
+        if (name == "@format") {
+            if (type == "COLUMNAR") table.format = TableFormat::COLUMNAR;
+        } else if (name == "@index") {
+            std::string column;
+            ss >> column;
+            table.indexes.push_back({type, column});
+        } else if (!name.empty()) {
+            table.columns.push_back({name, type});
+        }
+    }
+    return table;
+}
+
+// The rest of a manifest line after the separating space, which may hold spaces itself.
+bool readValue(std::stringstream& ss, const Table& table, const std::string& column, Value& value) {
+    int idx = -1;
+    for (size_t i = 0; i < table.columns.size(); ++i) {
+        if (table.columns[i].name == column) idx = static_cast<int>(i);
+    }
+    if (idx == -1) return false;
+    ss.get();
+    std::string text;
+    std::getline(ss, text);
+    return Value::parse(text, table.columns[idx].type, value);
+}
+
+} // namespace
+
+Catalog& Catalog::instance() {
+    static Catalog catalog;
+    return catalog;
+}
+
+bool Catalog::load() {
+    std::lock_guard<std::mutex> lock(mutex);
+    tables.clear();
+    catalogVersion = 0;
+
+    std::ifstream in(MANIFEST_PATH);
+    if (!in.is_open()) {
+        return migrateSchemaFiles() >= 0;
+    }
+
+    std::string line;
+    Table* current = nullptr;
+    std::vector<std::pair<Table, uint64_t>> loaded;
+    std::map<std::string, std::shared_ptr<TableStats>> loadedStats;
+    auto columnStats = [&](const std::string& column) -> ColumnStats* {
+        auto it = loadedStats.find(current->name);
+        if (it == loadedStats.end()) return nullptr;
+        for (size_t i = 0; i < current->columns.size() && i < it->second->columns.size(); ++i) {
+            if (current->columns[i].name == column) return &it->second->columns[i];
+        }
+        return nullptr;
+    };
+    while (std::getline(in, line)) {
+        std::stringstream ss(line);
+        std::string kind;
+        ss >> kind;
+        if (kind == "catalog") {
+            int format;
+            ss >> format >> catalogVersion;
+            if (format != FORMAT) return false;
+        } else if (kind == "table") {
+            Table table;
+            std::string format;
+            uint64_t version = 0;
+            ss >> table.name >> format >> version;
+            if (format == "COLUMNAR") table.format = TableFormat::COLUMNAR;
+            loaded.push_back({table, version});
+            current = &loaded.back().first;
+        } else if (kind == "column" && current) {
+            Column col;
+            ss >> col.name >> col.type;
+            current->columns.push_back(col);
+        } else if (kind == "index" && current) {
+            IndexInfo index;
+            ss >> index.name >> index.column;
+            current->indexes.push_back(index);
+        } else if (kind == "stats" && current) {
+            auto stats = std::make_shared<TableStats>();
+            ss >> stats->rows;
+            stats->columns.resize(current->columns.size());
+            loadedStats[current->name] = stats;
+        } else if (kind == "column_stats" && current) {
+            std::string column;
+            ss >> column;
+            if (ColumnStats* stats = columnStats(column)) ss >> stats->nullFraction >> stats->distinct;
+        } else if (kind == "common" && current) {
+            std::string column;
+            double fraction = 0;
+            Value value;
+            ss >> column >> fraction;
+            ColumnStats* stats = columnStats(column);
+            if (stats && readValue(ss, *current, column, value)) stats->common.push_back({value, fraction});
+        } else if (kind == "bound" && current) {
+            std::string column;
+            Value value;
+            ss >> column;
+            ColumnStats* stats = columnStats(column);
+            if (stats && readValue(ss, *current, column, value)) stats->bounds.push_back(value);
+        }
+    }
+    for (const auto& entry : loaded) {
+        put(entry.first, entry.second);
+        auto stats = loadedStats.find(entry.first.name);
+        if (stats != loadedStats.end()) tables[entry.first.name].stats = stats->second;
+    }
+    return true;
+}
+
+bool Catalog::exists(const std::string& table) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return tables.count(table) > 0;
+}
+
+Table Catalog::schema(const std::string& table) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = tables.find(table);
+    if (it != tables.end()) return it->second.schema;
+    Table missing;
+    missing.name = table;
+    return missing;
+}
+
+std::vector<std::string> Catalog::tableNames() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::vector<std::string> names;
+    for (const auto& entry : tables) names.push_back(entry.first);
+    return names;
+}
+
+int Catalog::columnIndex(const std::string& table, const std::string& column) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = tables.find(table);
+    if (it == tables.end()) return -1;
+    auto col = it->second.columns.find(column);
+    return col == it->second.columns.end() ? -1 : col->second;
+}
+
+uint64_t Catalog::version(const std::string& table) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = tables.find(table);
+    return it == tables.end() ? 0 : it->second.version;
+}
+
+uint64_t Catalog::version() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return catalogVersion;
+}
+
+std::shared_ptr<const TableStats> Catalog::stats(const std::string& table) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = tables.find(table);
+    return it == tables.end() ? nullptr : it->second.stats;
+}
+
+bool Catalog::setStats(const std::string& table, TableStats stats) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = tables.find(table);
+    if (it == tables.end()) return false;
+    std::shared_ptr<const TableStats> previous = it->second.stats;
+    it->second.stats = std::make_shared<const TableStats>(std::move(stats));
+    if (save()) return true;
+    it->second.stats = previous;
+    return false;
+}
+
+bool Catalog::addTable(const Table& schema) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (tables.count(schema.name)) return false;
+    Table stored = schema;
+    stored.rows.clear();
+    put(stored, ++catalogVersion);
+    if (save()) return true;
+    tables.erase(schema.name);
+    return false;
+}
+
+bool Catalog::addIndex(const std::string& table, const IndexInfo& index) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = tables.find(table);
+    if (it == tables.end()) return false;
+    Entry previous = it->second;
+    it->second.schema.indexes.push_back(index);
+    it->second.version = ++catalogVersion;
+    if (save()) return true;
+    it->second = previous;
+    return false;
+}
+
+bool Catalog::dropTable(const std::string& table) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = tables.find(table);
+    if (it == tables.end()) return false;
+    Entry previous = it->second;
+    tables.erase(it);
+    catalogVersion++;
+    if (save()) return true;
+    tables[table] = previous;
+    return false;
+}
+
+void Catalog::put(const Table& schema, uint64_t version) {
+    Entry& entry = tables[schema.name];
+    entry.schema = schema;
+    entry.version = version;
+    entry.columns.clear();
+    for (size_t i = 0; i < schema.columns.size(); ++i) {
+        entry.columns.emplace(schema.columns[i].name, static_cast<int>(i));
+    }
+}
+
+bool Catalog::save() {
+    if (!fs::exists("db")) {
+        fs::create_directory("db");
+    }
+    std::string tmpPath = std::string(MANIFEST_PATH) + ".tmp";
+    {
+        std::ofstream out(tmpPath, std::ios::trunc);
+        if (!out.is_open()) return false;
+        out << "catalog " << FORMAT << " " << catalogVersion << "\n";
+        for (const auto& entry : tables) {
+            const Table& table = entry.second.schema;
+            out << "table " << table.name << " "
+                << (table.format == TableFormat::COLUMNAR ? "COLUMNAR" : "ROW") << " "
+                << entry.second.version << "\n";
+            for (const auto& col : table.columns) {
+                out << "column " << col.name << " " << col.type << "\n";
+            }
+            for (const auto& index : table.indexes) {
+                out << "index " << index.name << " " << index.column << "\n";
+            }
+            const TableStats* stats = entry.second.stats.get();
+            if (!stats) continue;
+            out << "stats " << stats->rows << "\n";
+            for (size_t i = 0; i < table.columns.size() && i < stats->columns.size(); ++i) {
+                const std::string& name = table.columns[i].name;
+                const ColumnStats& column = stats->columns[i];
+                out << "column_stats " << name << " " << column.nullFraction << " " << column.distinct << "\n";
+                for (const auto& common : column.common) {
+                    out << "common " << name << " " << common.second << " " << common.first << "\n";
+                }
+                for (const auto& bound : column.bounds) {
+                    out << "bound " << name << " " << bound << "\n";
+                }
+            }
+        }
+        if (!out.flush()) return false;
+    }
+    if (!LogManager::syncFile(tmpPath)) return false;
+    std::error_code ec;
+    fs::rename(tmpPath, MANIFEST_PATH, ec);
+    return !ec;
+}
+
+int Catalog::migrateSchemaFiles() {
+    if (!fs::exists("db")) return 0;
+
+    std::vector<fs::path> schemaFiles;
+    for (const auto& entry : fs::directory_iterator("db")) {
+        if (entry.path().extension() == ".schema") schemaFiles.push_back(entry.path());
+    }
+    if (schemaFiles.empty()) return 0;
+
+    for (const auto& path : schemaFiles) {
+        Table table = readSchemaFile(path);
+        if (!table.columns.empty()) put(table, ++catalogVersion);
+    }
+    if (!save()) return -1;
+    // The manifest is durable now, so the old files can go
+    for (const auto& path : schemaFiles) {
+        fs::remove(path);
+    }
+    return static_cast<int>(schemaFiles.size());
+}
+
+} // namespace spl
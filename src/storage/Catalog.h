@@ -0,0 +1,80 @@
+#ifndef SPL_CATALOG_H
+#define SPL_CATALOG_H
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "StorageStructs.h"
+#include "TableStats.h"
+
+namespace spl {
+
+// Every table's schema, held in memory and persisted in one manifest file,
+// db/catalog.manifest:
+//   catalog <format> <version>
+//   table <name> ROW|COLUMNAR <version>
+//   column <name> <type>
+//   index <name> <column>
+//   stats <rows>
+//   column_stats <column> <null fraction> <distinct>
+//   common <column> <fraction> <value>
+//   bound <column> <value>
+// The lines below a `table` line belong to it. The last four hold what
+// ANALYZE found (see TableStats); values run to the end of the line.
+//
+// Each DDL statement bumps the catalog version and stamps it on the table it
+// changed, so anything cached per table can tell when it went stale. The
+// manifest is rewritten whole (temp file, fsync, rename) on every change.
+class Catalog {
+public:
+    static Catalog& instance();
+
+    // Reads the manifest. Without one, the per-table .schema files of older
+    // versions are folded into a new manifest and removed.
+    bool load();
+
+    bool exists(const std::string& table) const;
+    // The table's schema; no columns if it does not exist.
+    Table schema(const std::string& table) const;
+    std::vector<std::string> tableNames() const;
+    int columnIndex(const std::string& table, const std::string& column) const;
+    // Version of the table's last DDL change, 0 if it does not exist.
+    uint64_t version(const std::string& table) const;
+    uint64_t version() const;
+    // The table's statistics, null until it is analyzed.
+    std::shared_ptr<const TableStats> stats(const std::string& table) const;
+
+    bool addTable(const Table& schema);
+    bool addIndex(const std::string& table, const IndexInfo& index);
+    bool dropTable(const std::string& table);
+    bool setStats(const std::string& table, TableStats stats);
+
+private:
+    Catalog() = default;
+
+    struct Entry {
+        Table schema;
+        std::unordered_map<std::string, int> columns;
+        uint64_t version = 0;
+        std::shared_ptr<const TableStats> stats;
+    };
+
+    static const int FORMAT = 1;
+
+    mutable std::mutex mutex;
+    std::map<std::string, Entry> tables;
+    uint64_t catalogVersion = 0;
+
+    // Caller holds mutex.
+    void put(const Table& schema, uint64_t version);
+    bool save();
+    int migrateSchemaFiles();
+};
+
+} // namespace spl
+
+#endif // SPL_CATALOG_H
@@ -0,0 +1,496 @@
+#include "ColumnStore.h"
+#include "BufferPool.h"
+#include "LogManager.h"
+#include <algorithm>
+#include <bitset>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <unordered_map>
+
+namespace spl {
+
+namespace fs = std::filesystem;
+
+namespace {
+
+struct Dictionary {
+    std::vector<std::string> values;
+    std::unordered_map<std::string, uint32_t> codes;
+};
+
+std::mutex dictMutex;
+std::unordered_map<std::string, Dictionary> dictionaries;
+
+// Caller holds dictMutex.
+Dictionary& loadDictionary(const std::string& path) {
+    auto it = dictionaries.find(path);
+    if (it != dictionaries.end()) return it->second;
+
+    Dictionary& dict = dictionaries[path];
+    std::ifstream in(path, std::ios::binary);
+    uint16_t len;
+    while (in.read(reinterpret_cast<char*>(&len), sizeof(len))) {
+        std::string value(len, '\0');
+        if (len > 0 && !in.read(&value[0], len)) break;
+        dict.codes.emplace(value, static_cast<uint32_t>(dict.values.size()));
+        dict.values.push_back(std::move(value));
+    }
+    return dict;
+}
+
+bool encodeString(const std::string& path, const std::string& value, uint32_t& code) {
+    std::lock_guard<std::mutex> lock(dictMutex);
+    Dictionary& dict = loadDictionary(path);
+    auto it = dict.codes.find(value);
+    if (it != dict.codes.end()) {
+        code = it->second;
+        return true;
+    }
+
+    std::error_code ec;
+    uint64_t offset = fs::file_size(path, ec);
+    if (ec) offset = 0;
+    std::string entry;
+    uint16_t len = static_cast<uint16_t>(value.size());
+    entry.append(reinterpret_cast<const char*>(&len), sizeof(len));
+    entry.append(value);
+
+    std::ofstream out(path, std::ios::binary | std::ios::app);
+    if (!out.is_open()) return false;
+    out.write(entry.data(), entry.size());
+    if (!out) return false;
+    LogManager::instance().logFileWrite(path, offset, entry.data(), entry.size());
+
+    code = static_cast<uint32_t>(dict.values.size());
+    dict.codes.emplace(value, code);
+    dict.values.push_back(value);
+    return true;
+}
+
+void forgetDictionary(const std::string& path) {
+    std::lock_guard<std::mutex> lock(dictMutex);
+    dictionaries.erase(path);
+}
+
+} // namespace
+
+std::string ColumnStore::columnPath(size_t col) const {
+    return "db/" + schema.name + "." + schema.columns[col].name + ".col";
+}
+
+std::string ColumnStore::dictPath(size_t col) const {
+    return "db/" + schema.name + "." + schema.columns[col].name + ".dict";
+}
+
+std::string ColumnStore::deletePath() const {
+    return "db/" + schema.name + ".del";
+}
+
+bool ColumnStore::create() {
+    BufferPool& pool = BufferPool::instance();
+    pool.discardFile(deletePath());
+    fs::remove(deletePath());
+    for (size_t c = 0; c < schema.columns.size(); ++c) {
+        std::string path = columnPath(c);
+        pool.discardFile(path);
+        {
+            std::ofstream file(path, std::ios::binary | std::ios::trunc);
+            if (!file.is_open()) return false;
+        }
+        uint32_t header;
+        pool.newPage(path, header); // zeroed: row count 0
+        pool.unpinPage(path, header, true);
+        if (!pool.flushFile(path)) return false;
+
+        if (!isIntType(schema.columns[c].type)) {
+            forgetDictionary(dictPath(c));
+            std::ofstream dict(dictPath(c), std::ios::binary | std::ios::trunc);
+            if (!dict.is_open()) return false;
+        }
+    }
+    return true;
+}
+
+uint64_t ColumnStore::rowCount() const {
+    if (schema.columns.empty()) return 0;
+    PageGuard header(columnPath(0), 0);
+    if (!header.valid()) return 0;
+    uint64_t count;
+    std::memcpy(&count, header.data(), sizeof(count));
+    return count;
+}
+
+bool ColumnStore::setRowCount(uint64_t count) {
+    for (size_t c = 0; c < schema.columns.size(); ++c) {
+        PageGuard header(columnPath(c), 0);
+        if (!header.valid()) return false;
+        std::memcpy(header.data(), &count, sizeof(count));
+        header.markDirty();
+    }
+    return true;
+}
+
+bool ColumnStore::writeValue(size_t col, uint64_t rowIdx, const Value& value) {
+    BufferPool& pool = BufferPool::instance();
+    std::string path = columnPath(col);
+    bool isInt = isIntType(schema.columns[col].type);
+
+    char bytes[sizeof(int64_t)];
+    size_t width;
+    if (isInt) {
+        if (!value.isInt()) return false;
+        int64_t v = value.asInt();
+        width = sizeof(v);
+        std::memcpy(bytes, &v, width);
+    } else {
+        uint32_t code;
+        if (!value.isString() || !encodeString(dictPath(col), value.asString(), code)) return false;
+        width = sizeof(code);
+        std::memcpy(bytes, &code, width);
+    }
+
+    size_t perPage = PAGE_SIZE / width;
+    uint32_t pageNo = static_cast<uint32_t>(1 + rowIdx / perPage);
+    char* data;
+    if (pageNo < pool.pageCount(path)) {
+        data = pool.fetchPage(path, pageNo);
+    } else {
+        uint32_t created;
+        data = pool.newPage(path, created);
+        if (created != pageNo) {
+            pool.unpinPage(path, created, true);
+            return false;
+        }
+    }
+    if (!data) return false;
+    std::memcpy(data + (rowIdx % perPage) * width, bytes, width);
+    pool.unpinPage(path, pageNo, true);
+    return true;
+}
+
+bool ColumnStore::accepts(const Row& row) const {
+    if (row.values.size() != schema.columns.size()) return false;
+    for (size_t c = 0; c < schema.columns.size(); ++c) {
+        const Value& cell = row.values[c];
+        if (isIntType(schema.columns[c].type) ? !cell.isInt()
+                                              : !cell.isString() || cell.asString().size() > UINT16_MAX) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool ColumnStore::append(const Row& row, uint64_t* rid) {
+    // Validate up front so a bad cell never leaves a half-written row behind
+    if (!accepts(row)) return false;
+
+    uint64_t rowIdx = rowCount();
+    for (size_t c = 0; c < schema.columns.size(); ++c) {
+        if (!writeValue(c, rowIdx, row.values[c])) return false;
+    }
+    if (rid) *rid = rowIdx;
+    return setRowCount(rowIdx + 1);
+}
+
+bool ColumnStore::appendRows(const std::vector<Row>& rows) {
+    uint64_t first = rowCount();
+    for (size_t c = 0; c < schema.columns.size(); ++c) {
+        for (size_t i = 0; i < rows.size(); ++i) {
+            if (!writeValue(c, first + i, rows[i].values[c])) return false;
+        }
+    }
+    return setRowCount(first + rows.size());
+}
+
+bool ColumnStore::truncate(uint64_t count) {
+    if (count > rowCount()) return false;
+    return setRowCount(count);
+}
+
+bool ColumnStore::readRow(uint64_t rowIdx, Row& row) const {
+    if (rowIdx >= rowCount() || isDeleted(rowIdx)) return false;
+    row.values.assign(schema.columns.size(), Value());
+    for (size_t c = 0; c < schema.columns.size(); ++c) {
+        bool isInt = isIntType(schema.columns[c].type);
+        size_t width = isInt ? sizeof(int64_t) : sizeof(uint32_t);
+        size_t perPage = PAGE_SIZE / width;
+        PageGuard page(columnPath(c), static_cast<uint32_t>(1 + rowIdx / perPage));
+        if (!page.valid()) return false;
+        const char* at = page.data() + (rowIdx % perPage) * width;
+        if (isInt) {
+            int64_t v;
+            std::memcpy(&v, at, sizeof(v));
+            row.values[c] = Value(v);
+        } else {
+            uint32_t code;
+            std::memcpy(&code, at, sizeof(code));
+            std::lock_guard<std::mutex> lock(dictMutex);
+            Dictionary& dict = loadDictionary(dictPath(c));
+            if (code < dict.values.size()) row.values[c] = Value(dict.values[code]);
+        }
+    }
+    return true;
+}
+
+bool ColumnStore::updateRow(uint64_t rowIdx, const Row& oldRow, const Row& newRow) {
+    if (rowIdx >= rowCount() || newRow.values.size() != schema.columns.size()) return false;
+    for (size_t c = 0; c < schema.columns.size(); ++c) {
+        if (c < oldRow.values.size() && oldRow.values[c] == newRow.values[c]) continue;
+        if (!writeValue(c, rowIdx, newRow.values[c])) return false;
+    }
+    return true;
+}
+
+bool ColumnStore::erase(uint64_t rowIdx) {
+    if (rowIdx >= rowCount()) return false;
+    BufferPool& pool = BufferPool::instance();
+    std::string path = deletePath();
+    uint32_t pageNo = static_cast<uint32_t>(rowIdx / BITS_PER_PAGE);
+    while (pool.pageCount(path) <= pageNo) {
+        uint32_t created;
+        pool.newPage(path, created);
+        pool.unpinPage(path, created, true);
+    }
+
+    PageGuard page(path, pageNo);
+    if (!page.valid()) return false;
+    size_t bit = rowIdx % BITS_PER_PAGE;
+    unsigned char& byte = reinterpret_cast<unsigned char*>(page.data())[bit / 8];
+    unsigned char mask = static_cast<unsigned char>(1u << (bit % 8));
+    if (byte & mask) return false;
+    byte |= mask;
+    page.markDirty();
+    return true;
+}
+
+bool ColumnStore::isDeleted(uint64_t rowIdx) const {
+    std::vector<bool> flag;
+    deletedRange(rowIdx, 1, flag);
+    return flag[0];
+}
+
+void ColumnStore::deletedRange(uint64_t first, size_t n, std::vector<bool>& out) const {
+    out.assign(n, false);
+    std::string path = deletePath();
+    uint32_t pages = BufferPool::instance().pageCount(path);
+    size_t i = 0;
+    while (i < n) {
+        uint64_t r = first + i;
+        uint32_t pageNo = static_cast<uint32_t>(r / BITS_PER_PAGE);
+        size_t bit = r % BITS_PER_PAGE;
+        size_t take = std::min(BITS_PER_PAGE - bit, n - i);
+        if (pageNo >= pages) break; // nothing deleted this far out
+        PageGuard page(path, pageNo);
+        if (!page.valid()) break;
+        const unsigned char* bits = reinterpret_cast<const unsigned char*>(page.data());
+        for (size_t k = 0; k < take; ++k) {
+            size_t b = bit + k;
+            out[i + k] = (bits[b / 8] >> (b % 8)) & 1;
+        }
+        i += take;
+    }
+}
+
+uint64_t ColumnStore::deletedCount() const {
+    std::string path = deletePath();
+    uint32_t pages = BufferPool::instance().pageCount(path);
+    uint64_t count = 0;
+    for (uint32_t p = 0; p < pages; ++p) {
+        PageGuard page(path, p);
+        if (!page.valid()) break;
+        const unsigned char* bits = reinterpret_cast<const unsigned char*>(page.data());
+        for (size_t b = 0; b < PAGE_SIZE; ++b) {
+            count += std::bitset<8>(bits[b]).count();
+        }
+    }
+    return count;
+}
+
+bool ColumnStore::rewrite(const std::vector<Row>& rows) {
+    // Build the new files under a temporary table name, then move them into place.
+    Table tmpSchema = schema;
+    tmpSchema.name = schema.name + ".rewrite";
+    ColumnStore tmp(tmpSchema);
+    if (!tmp.create()) return false;
+
+    bool ok = true;
+    for (const auto& row : rows) {
+        if (!tmp.append(row)) {
+            ok = false;
+            break;
+        }
+    }
+    ok = tmp.flush() && ok;
+
+    BufferPool& pool = BufferPool::instance();
+    for (size_t c = 0; c < schema.columns.size(); ++c) {
+        pool.discardFile(tmp.columnPath(c));
+        forgetDictionary(tmp.dictPath(c));
+        ok = ok && LogManager::syncFile(tmp.columnPath(c));
+        if (!isIntType(schema.columns[c].type)) ok = ok && LogManager::syncFile(tmp.dictPath(c));
+    }
+    if (!ok) {
+        tmp.remove();
+        return false;
+    }
+
+    std::error_code ec;
+    for (size_t c = 0; c < schema.columns.size(); ++c) {
+        pool.discardFile(columnPath(c));
+        fs::rename(tmp.columnPath(c), columnPath(c), ec);
+        if (!isIntType(schema.columns[c].type)) {
+            forgetDictionary(dictPath(c));
+            fs::rename(tmp.dictPath(c), dictPath(c), ec);
+        }
+    }
+    // The new files hold live rows only
+    pool.discardFile(deletePath());
+    fs::remove(deletePath());
+    return !ec;
+}
+
+bool ColumnStore::flush() {
+    bool ok = true;
+    for (size_t c = 0; c < schema.columns.size(); ++c) {
+        ok = BufferPool::instance().flushFile(columnPath(c)) && ok;
+    }
+    return ok;
+}
+
+bool ColumnStore::remove() {
+    bool ok = true;
+    BufferPool::instance().discardFile(deletePath());
+    fs::remove(deletePath());
+    for (size_t c = 0; c < schema.columns.size(); ++c) {
+        BufferPool::instance().discardFile(columnPath(c));
+        ok = fs::remove(columnPath(c)) && ok;
+        if (!isIntType(schema.columns[c].type)) {
+            forgetDictionary(dictPath(c));
+            fs::remove(dictPath(c));
+        }
+    }
+    return ok;
+}
+
+ColumnCursor::ColumnCursor(const Table& schema, const std::vector<bool>& needed)
+    : store(schema), columns(schema.columns), needed(needed), totalRows(store.rowCount()), endRow(totalRows) {
+    if (this->needed.size() != columns.size()) {
+        this->needed.assign(columns.size(), true);
+    }
+}
+
+bool ColumnCursor::loadNextBatch() {
+    batch.clear();
+    batchRids.clear();
+    batchPos = 0;
+    while (batch.empty()) {
+        if (nextRow >= endRow) return false;
+        if (!loadRows()) return false;
+    }
+    return true;
+}
+
+bool ColumnCursor::readInts(size_t col, size_t n) {
+    std::vector<int64_t>& out = ints[col];
+    out.resize(n);
+    // Blocks are page aligned: INTS_PER_PAGE == ROWS_PER_BLOCK
+    PageGuard guard(store.columnPath(col), static_cast<uint32_t>(1 + nextRow / ColumnStore::INTS_PER_PAGE));
+    if (!guard.valid()) return false;
+    std::memcpy(out.data(), guard.data(), n * sizeof(int64_t));
+    return true;
+}
+
+bool ColumnCursor::readCodes(size_t col, size_t n) {
+    codes.resize(n);
+    std::string path = store.columnPath(col);
+    uint64_t r = nextRow;
+    size_t i = 0;
+    while (i < n) {
+        size_t slot = r % ColumnStore::CODES_PER_PAGE;
+        size_t take = std::min(ColumnStore::CODES_PER_PAGE - slot, n - i);
+        PageGuard guard(path, static_cast<uint32_t>(1 + r / ColumnStore::CODES_PER_PAGE));
+        if (!guard.valid()) return false;
+        std::memcpy(codes.data() + i, guard.data() + slot * sizeof(uint32_t), take * sizeof(uint32_t));
+        i += take;
+        r += take;
+    }
+    return true;
+}
+
+bool ColumnCursor::loadRows() {
+    size_t n = static_cast<size_t>(std::min<uint64_t>(ColumnStore::ROWS_PER_BLOCK, endRow - nextRow));
+    if (blockFilter && !blockFilter(nextRow / ColumnStore::ROWS_PER_BLOCK)) {
+        nextRow += n;
+        return true;
+    }
+
+    // Live rows, then narrowed by each pushed down comparison
+    std::vector<bool> deleted;
+    store.deletedRange(nextRow, n, deleted);
+    selected.assign(SimdFilter::words(n), 0);
+    for (size_t i = 0; i < n; ++i) {
+        if (!deleted[i]) selected[i / 64] |= uint64_t(1) << (i % 64);
+    }
+    ints.resize(columns.size());
+    std::vector<bool> loaded(columns.size(), false);
+    for (const auto& cmp : intFilter) {
+        size_t c = static_cast<size_t>(cmp.column);
+        if (!loaded[c]) {
+            if (!readInts(c, n)) return false;
+            loaded[c] = true;
+        }
+        SimdFilter::narrow(ints[c].data(), n, cmp.op, cmp.value, selected.data());
+    }
+    positions.resize(n);
+    size_t count = SimdFilter::select(selected.data(), n, positions.data());
+    if (count == 0) {
+        nextRow += n;
+        return true;
+    }
+
+    batch.resize(count);
+    for (auto& row : batch) row.values.assign(columns.size(), Value());
+    for (size_t c = 0; c < columns.size(); ++c) {
+        if (!needed[c]) continue;
+        if (isIntType(columns[c].type)) {
+            if (!loaded[c] && !readInts(c, n)) return false;
+            const int64_t* values = ints[c].data();
+            for (size_t k = 0; k < count; ++k) batch[k].values[c] = Value(values[positions[k]]);
+        } else {
+            if (!readCodes(c, n)) return false;
+            std::lock_guard<std::mutex> lock(dictMutex);
+            const Dictionary& dict = loadDictionary(store.dictPath(c));
+            for (size_t k = 0; k < count; ++k) {
+                uint32_t code = codes[positions[k]];
+                if (code < dict.values.size()) batch[k].values[c] = Value(dict.values[code]);
+            }
+        }
+    }
+    for (size_t k = 0; k < count; ++k) batchRids.push_back(nextRow + positions[k]);
+
+    nextRow += n;
+    return true;
+}
+
+uint64_t ColumnCursor::blockCount() const {
+    return (totalRows + ColumnStore::ROWS_PER_BLOCK - 1) / ColumnStore::ROWS_PER_BLOCK;
+}
+
+void ColumnCursor::setBlockRange(uint64_t begin, uint64_t end) {
+    nextRow = std::min(begin * ColumnStore::ROWS_PER_BLOCK, totalRows);
+    endRow = std::min(end * ColumnStore::ROWS_PER_BLOCK, totalRows);
+    batch.clear();
+    batchRids.clear();
+    batchPos = 0;
+}
+
+bool ColumnCursor::next(Row& row) {
+    if (batchPos >= batch.size() && !loadNextBatch()) return false;
+    rid = batchRids[batchPos];
+    row = std::move(batch[batchPos++]);
+    return true;
+}
+
+} // namespace spl
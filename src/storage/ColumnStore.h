@@ -0,0 +1,104 @@
+#ifndef SPL_COLUMNSTORE_H
+#define SPL_COLUMNSTORE_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "Page.h"
+#include "StorageStructs.h"
+#include "TableCursor.h"
+
+namespace spl {
+
+// Column-oriented table storage (CREATE TABLE ... USING COLUMNAR).
+// Each column lives in its own file, db/<table>.<column>.col:
+//   page 0      header, holds the row count
+//   page 1..n   INT columns: packed int64 values
+//               STRING columns: packed uint32 dictionary codes
+// STRING columns also have db/<table>.<column>.dict, the distinct strings in
+// code order, each stored as a 2 byte length followed by the bytes.
+// Deleted rows are marked in db/<table>.del, one bit per row, and skipped by
+// reads until VACUUM rewrites the table.
+class ColumnStore {
+public:
+    explicit ColumnStore(const Table& schema) : schema(schema) {}
+
+    bool create();
+    // Whether every cell has the column's type and fits its encoding.
+    bool accepts(const Row& row) const;
+    // `rid` receives the new row's position.
+    bool append(const Row& row, uint64_t* rid = nullptr);
+    // Appends pre-validated rows column by column; the row count is bumped last.
+    bool appendRows(const std::vector<Row>& rows);
+    bool readRow(uint64_t rowIdx, Row& row) const;
+    // Overwrites the cells of one row in place; unchanged cells are skipped.
+    bool updateRow(uint64_t rowIdx, const Row& oldRow, const Row& newRow);
+    // Sets the row's deletion bit. Fails if it is out of range or already deleted.
+    bool erase(uint64_t rowIdx);
+    bool isDeleted(uint64_t rowIdx) const;
+    // Deletion flags of rows [first, first + n).
+    void deletedRange(uint64_t first, size_t n, std::vector<bool>& out) const;
+    uint64_t deletedCount() const;
+    bool rewrite(const std::vector<Row>& rows);
+    // Drops the rows from `count` on. Their cells stay in the files until
+    // later appends overwrite them.
+    bool truncate(uint64_t count);
+    bool flush();
+    bool remove();
+
+    uint64_t rowCount() const;
+
+    std::string columnPath(size_t col) const;
+    std::string dictPath(size_t col) const;
+    std::string deletePath() const;
+
+    static constexpr size_t INTS_PER_PAGE = PAGE_SIZE / sizeof(int64_t);
+    static constexpr size_t CODES_PER_PAGE = PAGE_SIZE / sizeof(uint32_t);
+    static constexpr size_t BITS_PER_PAGE = PAGE_SIZE * 8;
+    // Rows read together by ColumnCursor, and summarized together by ZoneMap.
+    static constexpr size_t ROWS_PER_BLOCK = INTS_PER_PAGE;
+
+private:
+    Table schema;
+
+    bool writeValue(size_t col, uint64_t rowIdx, const Value& value);
+    bool setRowCount(uint64_t count);
+};
+
+// Reads only the columns marked in `needed`; the other cells are left NULL.
+// Each block is first narrowed to a bitmap of live rows passing the int
+// filter, and only those rows are decoded.
+class ColumnCursor : public TableCursor {
+public:
+    ColumnCursor(const Table& schema, const std::vector<bool>& needed);
+    bool next(Row& row) override;
+    bool appliesIntFilter() const override { return true; }
+    uint64_t blockCount() const override;
+    void setBlockRange(uint64_t begin, uint64_t end) override;
+
+private:
+    ColumnStore store;
+    std::vector<Column> columns;
+    std::vector<bool> needed;
+    uint64_t totalRows;
+    uint64_t nextRow = 0;
+    uint64_t endRow;
+    std::vector<Row> batch;
+    std::vector<uint64_t> batchRids;
+    size_t batchPos = 0;
+    // Scratch space for one block
+    std::vector<std::vector<int64_t>> ints; // per column, filled for INT columns the block read
+    std::vector<uint32_t> codes;
+    std::vector<uint64_t> selected;
+    std::vector<uint32_t> positions;
+
+    bool loadNextBatch();
+    bool readInts(size_t col, size_t n);
+    bool readCodes(size_t col, size_t n);
+    // Reads the next block of rows into `batch`; it may come back empty if all were deleted.
+    bool loadRows();
+};
+
+} // namespace spl
+
+#endif // SPL_COLUMNSTORE_H
@@ -0,0 +1,80 @@
+#include "Compactor.h"
+#include "StorageManager.h"
+
+namespace spl {
+
+namespace {
+// Small tables are not worth rewriting for a handful of deletes.
+const uint64_t MIN_DEAD_ROWS = 100;
+}
+
+Compactor& Compactor::instance() {
+    static Compactor compactor;
+    return compactor;
+}
+
+Compactor::~Compactor() {
+    stop();
+}
+
+void Compactor::start() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (running) return;
+    running = true;
+    worker = std::thread(&Compactor::run, this);
+}
+
+void Compactor::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!running) return;
+        running = false;
+    }
+    wake.notify_all();
+    worker.join();
+}
+
+void Compactor::setThreshold(double value) {
+    std::lock_guard<std::mutex> lock(mutex);
+    fraction = value;
+}
+
+double Compactor::threshold() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return fraction;
+}
+
+bool Compactor::shouldVacuum(uint64_t live, uint64_t dead) const {
+    double limit = threshold();
+    return limit > 0 && dead >= MIN_DEAD_ROWS && dead >= limit * (live + dead);
+}
+
+void Compactor::schedule(const std::string& tableName) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!running) return;
+        pending.insert(tableName);
+    }
+    wake.notify_one();
+}
+
+void Compactor::run() {
+    while (true) {
+        std::string table;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [this] { return !running || !pending.empty(); });
+            if (!running) return;
+            table = *pending.begin();
+            pending.erase(pending.begin());
+        }
+
+        std::lock_guard<std::mutex> statement(StorageManager::statementLock());
+        uint64_t live, dead;
+        if (StorageManager::rowCounts(table, live, dead) && shouldVacuum(live, dead)) {
+            StorageManager::vacuumTable(table);
+        }
+    }
+}
+
+} // namespace spl
@@ -0,0 +1,46 @@
+#ifndef SPL_COMPACTOR_H
+#define SPL_COMPACTOR_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+
+namespace spl {
+
+// Background thread that vacuums tables once deleted rows make up more than
+// `threshold` of them. Deletes only schedule a check; the vacuum itself runs
+// on this thread, between statements (it takes StorageManager::statementLock).
+class Compactor {
+public:
+    static Compactor& instance();
+
+    void start();
+    void stop();
+
+    // Fraction of dead rows that triggers a vacuum; 0 turns automatic vacuuming off.
+    void setThreshold(double fraction);
+    double threshold() const;
+    bool shouldVacuum(uint64_t live, uint64_t dead) const;
+
+    void schedule(const std::string& tableName);
+
+private:
+    Compactor() = default;
+    ~Compactor();
+
+    void run();
+
+    mutable std::mutex mutex;
+    std::condition_variable wake;
+    std::thread worker;
+    bool running = false;
+    double fraction = 0.3;
+    std::set<std::string> pending;
+};
+
+} // namespace spl
+
+#endif // SPL_COMPACTOR_H
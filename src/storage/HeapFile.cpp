@@ -0,0 +1,202 @@
+#include "HeapFile.h"
+#include "Page.h"
+#include "BufferPool.h"
+#include "TableCursor.h"
+#include "LogManager.h"
+#include <fstream>
+#include <filesystem>
+#include <cstring>
+
+namespace spl {
+
+namespace fs = std::filesystem;
+
+bool encodeRow(const Row& row, const std::vector<Column>& columns, std::string& out) {
+    out.clear();
+    if (row.values.size() != columns.size()) return false;
+
+    for (size_t i = 0; i < columns.size(); ++i) {
+        const Value& cell = row.values[i];
+        if (isIntType(columns[i].type)) {
+            if (!cell.isInt()) return false;
+            int64_t v = cell.asInt();
+            out.append(reinterpret_cast<const char*>(&v), sizeof(v));
+        } else {
+            if (!cell.isString()) return false;
+            const std::string& val = cell.asString();
+            if (val.size() > UINT16_MAX) return false;
+            uint16_t len = static_cast<uint16_t>(val.size());
+            out.append(reinterpret_cast<const char*>(&len), sizeof(len));
+            out.append(val);
+        }
+    }
+    return out.size() <= SlottedPage::maxRecordSize();
+}
+
+bool decodeRow(const char* record, size_t length, const std::vector<Column>& columns, Row& row,
+               const std::vector<bool>* needed) {
+    row.values.clear();
+    row.values.resize(columns.size());
+    size_t pos = 0;
+    for (size_t i = 0; i < columns.size(); ++i) {
+        bool wanted = !needed || (*needed)[i];
+        if (isIntType(columns[i].type)) {
+            int64_t v;
+            if (pos + sizeof(v) > length) return false;
+            if (wanted) {
+                std::memcpy(&v, record + pos, sizeof(v));
+                row.values[i] = Value(v);
+            }
+            pos += sizeof(v);
+        } else {
+            uint16_t len;
+            if (pos + sizeof(len) > length) return false;
+            std::memcpy(&len, record + pos, sizeof(len));
+            pos += sizeof(len);
+            if (pos + len > length) return false;
+            if (wanted) row.values[i] = Value(std::string(record + pos, len));
+            pos += len;
+        }
+    }
+    return true;
+}
+
+bool HeapFile::create() {
+    BufferPool::instance().discardFile(path);
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    return file.is_open();
+}
+
+uint32_t HeapFile::pageCount() const {
+    return BufferPool::instance().pageCount(path);
+}
+
+bool HeapFile::append(const std::string& record, uint64_t* rid) {
+    BufferPool& pool = BufferPool::instance();
+
+    uint32_t count = pool.pageCount(path);
+    if (count > 0) {
+        PageGuard last(path, count - 1);
+        SlottedPage page(last.data());
+        int slot = last.valid() ? page.insert(record) : -1;
+        if (slot >= 0) {
+            last.markDirty();
+            if (rid) *rid = makeRid(count - 1, static_cast<uint16_t>(slot));
+            return true;
+        }
+    }
+
+    uint32_t pageNo;
+    char* data = pool.newPage(path, pageNo);
+    if (!data) return false;
+    SlottedPage page(data);
+    page.init();
+    int slot = page.insert(record);
+    pool.unpinPage(path, pageNo, true);
+    if (slot < 0) return false;
+    if (rid) *rid = makeRid(pageNo, static_cast<uint16_t>(slot));
+    return true;
+}
+
+bool HeapFile::appendPage(const char* page) {
+    BufferPool& pool = BufferPool::instance();
+    uint32_t pageNo;
+    char* data = pool.newPage(path, pageNo);
+    if (!data) return false;
+    std::memcpy(data, page, PAGE_SIZE);
+    pool.unpinPage(path, pageNo, true);
+    return true;
+}
+
+bool HeapFile::read(uint64_t rid, const std::vector<Column>& columns, Row& row) const {
+    PageGuard guard(path, ridPage(rid));
+    if (!guard.valid()) return false;
+    SlottedPage page(guard.data());
+    const char* record;
+    uint16_t length;
+    return page.read(ridSlot(rid), record, length) && decodeRow(record, length, columns, row);
+}
+
+bool HeapFile::update(uint64_t rid, const std::string& record, uint64_t* newRid) {
+    {
+        PageGuard guard(path, ridPage(rid));
+        if (!guard.valid()) return false;
+        SlottedPage page(guard.data());
+        if (page.update(ridSlot(rid), record)) {
+            guard.markDirty();
+            if (newRid) *newRid = rid;
+            return true;
+        }
+        if (!page.erase(ridSlot(rid))) return false;
+        guard.markDirty();
+    }
+    return append(record, newRid);
+}
+
+bool HeapFile::erase(uint64_t rid) {
+    PageGuard guard(path, ridPage(rid));
+    if (!guard.valid()) return false;
+    if (!SlottedPage(guard.data()).erase(ridSlot(rid))) return false;
+    guard.markDirty();
+    return true;
+}
+
+bool HeapFile::rewrite(const std::vector<std::string>& records) {
+    BufferPool& pool = BufferPool::instance();
+    std::string tmpPath = path + ".tmp";
+    HeapFile tmp(tmpPath);
+    if (!tmp.create()) return false;
+
+    bool ok = true;
+    uint32_t pageNo = 0;
+    char* data = nullptr;
+    for (const auto& record : records) {
+        if (data) {
+            if (SlottedPage(data).insert(record) >= 0) continue;
+            pool.unpinPage(tmpPath, pageNo, true);
+        }
+        data = pool.newPage(tmpPath, pageNo);
+        if (!data) {
+            ok = false;
+            break;
+        }
+        SlottedPage page(data);
+        page.init();
+        if (page.insert(record) < 0) {
+            ok = false;
+            break;
+        }
+    }
+    if (data) pool.unpinPage(tmpPath, pageNo, true);
+
+    ok = ok && pool.flushFile(tmpPath);
+    pool.discardFile(tmpPath);
+    ok = ok && LogManager::syncFile(tmpPath);
+    if (!ok) {
+        fs::remove(tmpPath);
+        return false;
+    }
+
+    pool.discardFile(path);
+    std::error_code ec;
+    fs::rename(tmpPath, path, ec);
+    return !ec;
+}
+
+bool HeapFile::flush() {
+    return BufferPool::instance().flushFile(path);
+}
+
+bool HeapFile::truncate(uint32_t pages) {
+    BufferPool::instance().discardFile(path);
+    std::error_code ec;
+    fs::resize_file(path, static_cast<uintmax_t>(pages) * PAGE_SIZE, ec);
+    return !ec;
+}
+
+bool HeapFile::remove() {
+    BufferPool::instance().discardFile(path);
+    return fs::remove(path);
+}
+
+} // namespace spl
@@ -0,0 +1,55 @@
+#ifndef SPL_HEAPFILE_H
+#define SPL_HEAPFILE_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include "StorageStructs.h"
+
+namespace spl {
+
+// Binary row encoding used inside heap pages:
+//   INT    -> 8 byte signed integer
+//   STRING -> 2 byte length followed by the raw bytes
+bool encodeRow(const Row& row, const std::vector<Column>& columns, std::string& out);
+// Columns whose `needed` flag is false are skipped and left NULL.
+bool decodeRow(const char* record, size_t length, const std::vector<Column>& columns, Row& row,
+               const std::vector<bool>* needed = nullptr);
+
+// A table's data file (db/<table>.tbl): an unordered heap of slotted pages.
+// Pages are read and modified through the BufferPool.
+class HeapFile {
+public:
+    explicit HeapFile(const std::string& path) : path(path) {}
+
+    bool create();
+    uint32_t pageCount() const;
+    const std::string& filePath() const { return path; }
+
+    // Adds a record to the last page, starting a new page when it is full.
+    // `rid` receives the record's row id (see makeRid).
+    bool append(const std::string& record, uint64_t* rid = nullptr);
+    // Adds an already built slotted page at the end of the file (bulk loading).
+    bool appendPage(const char* page);
+    bool read(uint64_t rid, const std::vector<Column>& columns, Row& row) const;
+    // Overwrites a record in its page when it fits; otherwise the record moves
+    // to the end of the file. `newRid` receives its id either way.
+    bool update(uint64_t rid, const std::string& record, uint64_t* newRid = nullptr);
+    bool erase(uint64_t rid);
+    // Replaces the whole file with the given records (written to a temp file first).
+    bool rewrite(const std::vector<std::string>& records);
+    // Writes the file's dirty pages to disk.
+    bool flush();
+    // Drops every page from `pages` on. Cached pages are forgotten unwritten,
+    // so the pages kept must already be on disk (e.g. after a checkpoint).
+    bool truncate(uint32_t pages);
+    // Drops cached pages and deletes the file.
+    bool remove();
+
+private:
+    std::string path;
+};
+
+} // namespace spl
+
+#endif // SPL_HEAPFILE_H
@@ -0,0 +1,364 @@
+#include "LogManager.h"
+#include "BufferPool.h"
+#include "Page.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace spl {
+
+namespace fs = std::filesystem;
+
+namespace {
+
+const char* LOG_PATH = "db/wal.log";
+const uint32_t MAX_RECORD_SIZE = 1 << 20;
+
+void syncDescriptor(int fd) {
+#ifdef _WIN32
+    _commit(fd);
+#else
+    ::fsync(fd);
+#endif
+}
+
+uint32_t crc32(const char* data, size_t size) {
+    static uint32_t table[256];
+    static bool ready = false;
+    if (!ready) {
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; ++k) c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            table[i] = c;
+        }
+        ready = true;
+    }
+    uint32_t crc = 0xFFFFFFFFu;
+    for (size_t i = 0; i < size; ++i) {
+        crc = table[(crc ^ static_cast<unsigned char>(data[i])) & 0xFF] ^ (crc >> 8);
+    }
+    return crc ^ 0xFFFFFFFFu;
+}
+
+template <typename T>
+void put(std::string& out, T value) {
+    out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+template <typename T>
+bool get(const std::string& in, size_t& pos, T& value) {
+    if (pos + sizeof(value) > in.size()) return false;
+    std::memcpy(&value, in.data() + pos, sizeof(value));
+    pos += sizeof(value);
+    return true;
+}
+
+// Only table data is logged. Index files are rebuilt after recovery instead.
+bool isLoggedFile(const std::string& path) {
+    std::string ext = fs::path(path).extension().string();
+    return ext == ".tbl" || ext == ".col" || ext == ".del";
+}
+
+// db/<table>.tbl, db/<table>.<column>.col, ... -> <table>
+std::string tableOf(const std::string& path) {
+    std::string file = fs::path(path).filename().string();
+    return file.substr(0, file.find('.'));
+}
+
+} // namespace
+
+LogManager& LogManager::instance() {
+    static LogManager manager;
+    return manager;
+}
+
+bool LogManager::syncFile(const std::string& path) {
+#ifdef _WIN32
+    int fd = _open(path.c_str(), _O_RDWR | _O_BINARY);
+    if (fd < 0) return false;
+    bool ok = _commit(fd) == 0;
+    _close(fd);
+#else
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    bool ok = ::fsync(fd) == 0;
+    ::close(fd);
+#endif
+    return ok;
+}
+
+int LogManager::readLog(const std::function<void(const WriteRecord&)>& apply, uint64_t& lastLsn,
+                        uint64_t& lastTxn) {
+    std::ifstream in(LOG_PATH, std::ios::binary);
+    if (!in.is_open()) return 0;
+
+    int committed = 0;
+    std::map<uint64_t, std::vector<WriteRecord>> pending;
+    uint32_t length, crc;
+    while (in.read(reinterpret_cast<char*>(&length), sizeof(length)) &&
+           in.read(reinterpret_cast<char*>(&crc), sizeof(crc))) {
+        if (length > MAX_RECORD_SIZE) break;
+        std::string body(length, '\0');
+        if (!in.read(&body[0], length) || crc32(body.data(), body.size()) != crc) break; // torn tail
+
+        size_t pos = 0;
+        uint64_t lsn, txn, offset;
+        uint8_t type;
+        uint16_t pathLen;
+        uint32_t size;
+        if (!get(body, pos, lsn) || !get(body, pos, txn) || !get(body, pos, type) ||
+            !get(body, pos, pathLen) || pos + pathLen > body.size()) {
+            break;
+        }
+        std::string path = body.substr(pos, pathLen);
+        pos += pathLen;
+        if (!get(body, pos, offset) || !get(body, pos, size) || pos + size > body.size()) break;
+
+        lastLsn = std::max(lastLsn, lsn);
+        lastTxn = std::max(lastTxn, txn);
+        if (type == WRITE) {
+            pending[txn].push_back({path, offset, body.substr(pos, size)});
+        } else if (type == COMMIT) {
+            for (const auto& rec : pending[txn]) apply(rec);
+            pending.erase(txn);
+            committed++;
+        }
+    }
+    return committed;
+}
+
+void LogManager::openLog(bool truncate) {
+    if (log) std::fclose(log);
+    std::error_code ec;
+    fs::create_directories("db", ec);
+    log = std::fopen(LOG_PATH, truncate ? "wb" : "ab");
+    logBytes = truncate ? 0 : fs::file_size(LOG_PATH, ec);
+}
+
+void LogManager::appendRecord(uint64_t txn, RecordType type, const std::string& path,
+                              uint64_t offset, const char* data, size_t size) {
+    if (!log) openLog(false);
+    if (!log) return;
+
+    std::string body;
+    body.reserve(32 + path.size() + size);
+    put<uint64_t>(body, nextLsn++);
+    put<uint64_t>(body, txn);
+    put<uint8_t>(body, type);
+    put<uint16_t>(body, static_cast<uint16_t>(path.size()));
+    body.append(path);
+    put<uint64_t>(body, offset);
+    put<uint32_t>(body, static_cast<uint32_t>(size));
+    if (size > 0) body.append(data, size);
+
+    uint32_t length = static_cast<uint32_t>(body.size());
+    uint32_t crc = crc32(body.data(), body.size());
+    std::fwrite(&length, sizeof(length), 1, log);
+    std::fwrite(&crc, sizeof(crc), 1, log);
+    std::fwrite(body.data(), 1, body.size(), log);
+    logBytes += sizeof(length) + sizeof(crc) + body.size();
+    if (!path.empty()) touchedFiles.insert(path);
+}
+
+void LogManager::flushLog(bool sync) {
+    if (!log) return;
+    std::fflush(log);
+    if (!sync) return;
+    syncDescriptor(fileno(log));
+    syncs++;
+}
+
+int LogManager::recover(std::set<std::string>& tables) {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::set<std::string> applied;
+    uint64_t lastLsn = 0, lastTxn = 0;
+    int committed = readLog([&applied](const WriteRecord& rec) {
+        // Files are only dropped after a checkpoint, so a missing one was
+        // created by this transaction and never written out
+        if (!fs::exists(rec.path)) std::ofstream(rec.path, std::ios::binary);
+        std::fstream file(rec.path, std::ios::binary | std::ios::in | std::ios::out);
+        if (!file.is_open()) return;
+        file.seekp(static_cast<std::streamoff>(rec.offset));
+        file.write(rec.bytes.data(), rec.bytes.size());
+        applied.insert(rec.path);
+    }, lastLsn, lastTxn);
+    nextLsn = std::max(nextLsn, lastLsn + 1);
+    nextTxn = std::max(nextTxn, lastTxn + 1);
+
+    for (const auto& path : applied) {
+        syncFile(path);
+        tables.insert(tableOf(path));
+    }
+
+    openLog(true);
+    touchedFiles.clear();
+    return committed;
+}
+
+void LogManager::begin() {
+    std::lock_guard<std::mutex> lock(mutex);
+    currentTxn = nextTxn++;
+    BufferPool::instance().trackWrites();
+}
+
+void LogManager::commit() {
+    syncTo(appendCommit());
+}
+
+uint64_t LogManager::appendCommit() {
+    std::unique_lock<std::mutex> lock(mutex);
+    if (currentTxn == 0) return 0;
+
+    BufferPool& pool = BufferPool::instance();
+    for (const auto& page : pool.takeWrittenPages()) {
+        if (!isLoggedFile(page.first)) continue;
+        char* data = pool.fetchPage(page.first, page.second);
+        if (!data) continue;
+        appendRecord(currentTxn, WRITE, page.first, static_cast<uint64_t>(page.second) * PAGE_SIZE,
+                     data, PAGE_SIZE);
+        pool.unpinPage(page.first, page.second, false);
+    }
+    appendRecord(currentTxn, COMMIT, "", 0, nullptr, 0);
+    uint64_t commitLsn = nextLsn - 1;
+    flushLog(policy == FsyncPolicy::ALWAYS);
+    if (policy == FsyncPolicy::ALWAYS) syncedLsn = commitLsn;
+    currentTxn = 0;
+
+    if (logBytes >= checkpointBytes) checkpointLocked(lock);
+    return commitLsn;
+}
+
+void LogManager::syncTo(uint64_t lsn) {
+    std::unique_lock<std::mutex> lock(mutex);
+    syncWaiters++;
+    while (policy == FsyncPolicy::GROUP && syncedLsn < lsn) {
+        if (syncing) {
+            // The running fsync, or the next leader's, covers this record
+            syncDone.wait(lock);
+            continue;
+        }
+        syncing = true;
+        if (syncWaiters > 1 && groupWindowMs > 0) {
+            // Others are queued already, so more commits are likely on the way
+            lock.unlock();
+            std::this_thread::sleep_for(std::chrono::milliseconds(groupWindowMs));
+            lock.lock();
+        }
+        // Appends go on while the mutex is released; the fsync covers those up to here
+        uint64_t target = nextLsn - 1;
+        int fd = -1;
+        if (log) {
+            std::fflush(log);
+            fd = fileno(log);
+        }
+        lock.unlock();
+        if (fd != -1) syncDescriptor(fd);
+        lock.lock();
+        syncs++;
+        syncing = false;
+        syncedLsn = std::max(syncedLsn, target);
+        syncDone.notify_all();
+    }
+    syncWaiters--;
+    // The transaction's pages may reach the data files now
+    BufferPool::instance().trimToCapacity();
+}
+
+void LogManager::abort(std::set<std::string>& tables) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (currentTxn == 0) return;
+    currentTxn = 0;
+
+    BufferPool& pool = BufferPool::instance();
+    std::set<std::pair<std::string, uint64_t>> dropped;
+    for (const auto& page : pool.discardWrittenPages()) {
+        tables.insert(tableOf(page.first));
+        if (isLoggedFile(page.first)) {
+            dropped.insert({page.first, static_cast<uint64_t>(page.second) * PAGE_SIZE});
+        }
+    }
+
+    // A dropped page may have held committed changes not yet written out.
+    // Its last committed image is in the log; otherwise the file has it.
+    flushLog(false);
+    uint64_t lastLsn = 0, lastTxn = 0;
+    readLog([&pool, &dropped](const WriteRecord& rec) {
+        if (rec.bytes.size() != PAGE_SIZE || !dropped.count({rec.path, rec.offset})) return;
+        uint32_t pageNo = static_cast<uint32_t>(rec.offset / PAGE_SIZE);
+        char* data = pool.fetchPage(rec.path, pageNo);
+        if (!data) return;
+        std::memcpy(data, rec.bytes.data(), PAGE_SIZE);
+        pool.unpinPage(rec.path, pageNo, true);
+    }, lastLsn, lastTxn);
+}
+
+void LogManager::close() {
+    std::unique_lock<std::mutex> lock(mutex);
+    syncDone.wait(lock, [this] { return !syncing; });
+    flushLog(true);
+    syncedLsn = nextLsn - 1;
+    syncDone.notify_all();
+}
+
+void LogManager::logFileWrite(const std::string& path, uint64_t offset, const char* data, size_t size) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (currentTxn == 0) return;
+    appendRecord(currentTxn, WRITE, path, offset, data, size);
+}
+
+void LogManager::checkpoint() {
+    std::unique_lock<std::mutex> lock(mutex);
+    checkpointLocked(lock);
+}
+
+void LogManager::checkpointLocked(std::unique_lock<std::mutex>& lock) {
+    // A leader may be syncing the log file that openLog is about to close
+    syncDone.wait(lock, [this] { return !syncing; });
+    for (const auto& path : BufferPool::instance().flushAll()) touchedFiles.insert(path);
+    for (const auto& path : touchedFiles) syncFile(path);
+    touchedFiles.clear();
+    openLog(true);
+    // Every logged change is in the synced data files now
+    syncedLsn = nextLsn - 1;
+    syncDone.notify_all();
+}
+
+void LogManager::setFsyncPolicy(FsyncPolicy newPolicy) {
+    std::lock_guard<std::mutex> lock(mutex);
+    policy = newPolicy;
+}
+
+FsyncPolicy LogManager::fsyncPolicy() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return policy;
+}
+
+void LogManager::setCheckpointBytes(uint64_t bytes) {
+    std::lock_guard<std::mutex> lock(mutex);
+    checkpointBytes = bytes;
+}
+
+void LogManager::setGroupCommitWindow(unsigned ms) {
+    std::lock_guard<std::mutex> lock(mutex);
+    groupWindowMs = ms;
+}
+
+uint64_t LogManager::syncCount() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return syncs;
+}
+
+} // namespace spl
@@ -0,0 +1,126 @@
+#ifndef SPL_LOGMANAGER_H
+#define SPL_LOGMANAGER_H
+
+#include <cstdint>
+#include <condition_variable>
+#include <cstdio>
+#include <functional>
+#include <mutex>
+#include <set>
+#include <string>
+
+namespace spl {
+
+enum class FsyncPolicy {
+    ALWAYS, // fsync the log on every commit
+    GROUP,  // a commit syncs at once unless an fsync is running; those queued behind it share the next
+    OFF     // leave it to the OS; a crash can lose the last few commits
+};
+
+// Write-ahead redo log, db/wal.log.
+//
+// Each write statement runs as a transaction. The buffer pool remembers which
+// table pages it dirtied; on commit the after-image of each of those pages is
+// appended to the log, followed by a commit record, and the log is fsynced
+// (per commit, or once per group of commits that queued up behind an fsync).
+// Data pages themselves are written lazily by the pool or at checkpoint time.
+//
+// Record: [u32 body length][u32 crc32(body)][body]
+// Body:   [u64 lsn][u64 txn][u8 type][u16 path length][path][u64 file offset][u32 size][bytes]
+//
+// Replay applies the writes of committed transactions in log order and stops
+// at the first torn or corrupt record. Writes are plain byte images, so
+// replaying twice is harmless.
+class LogManager {
+public:
+    static LogManager& instance();
+
+    // Replays db/wal.log and empties it. Returns the number of committed
+    // transactions applied; `tables` receives the tables they touched.
+    int recover(std::set<std::string>& tables);
+
+    void begin();
+    // appendCommit() followed by syncTo() on its LSN.
+    void commit();
+    // The two halves of commit(), for a caller that releases its own locks in
+    // between so that other transactions can commit while it waits. Returns
+    // the LSN of the commit record, 0 without an open transaction.
+    uint64_t appendCommit();
+    // Returns once the log is on disk up to `lsn`. Under GROUP the first
+    // waiter (the leader) fsyncs for every commit appended so far; commits
+    // that arrive during its fsync wait and share the next one.
+    void syncTo(uint64_t lsn);
+    // Drops the open transaction: the pages it dirtied are forgotten and
+    // reloaded from the last committed image. `tables` receives the tables it
+    // touched, whose indexes and zone maps the caller must rebuild.
+    void abort(std::set<std::string>& tables);
+
+    // Logs a write made outside the buffer pool (e.g. dictionary appends).
+    void logFileWrite(const std::string& path, uint64_t offset, const char* data, size_t size);
+
+    // Flushes every dirty page, syncs the data files and empties the log.
+    // Must run before any file is rewritten, renamed or removed outside the log.
+    void checkpoint();
+
+    void setFsyncPolicy(FsyncPolicy policy);
+    FsyncPolicy fsyncPolicy() const;
+    // A checkpoint is taken after any commit that grows the log past this size.
+    void setCheckpointBytes(uint64_t bytes);
+    // How long a GROUP leader that finds other commits already queued waits
+    // for more before its fsync. A lone commit never waits.
+    void setGroupCommitWindow(unsigned ms);
+    // fsyncs of the log so far; fewer than commits when GROUP batches them.
+    uint64_t syncCount() const;
+
+    // Syncs the log.
+    void close();
+
+    // fsync an arbitrary file by path.
+    static bool syncFile(const std::string& path);
+
+private:
+    LogManager() = default;
+
+    enum RecordType : uint8_t { WRITE = 1, COMMIT = 2 };
+
+    struct WriteRecord {
+        std::string path;
+        uint64_t offset;
+        std::string bytes;
+    };
+
+    mutable std::mutex mutex;
+    std::FILE* log = nullptr;
+    uint64_t nextLsn = 1;
+    uint64_t nextTxn = 1;
+    uint64_t currentTxn = 0;
+    uint64_t logBytes = 0;
+    uint64_t checkpointBytes = 16 * 1024 * 1024;
+    FsyncPolicy policy = FsyncPolicy::ALWAYS;
+    // Files written since the last checkpoint; synced at the next one.
+    std::set<std::string> touchedFiles;
+
+    // Reads db/wal.log and calls `apply` for each write of a committed
+    // transaction, in log order, stopping at the first torn or corrupt record.
+    // Returns the number of committed transactions; `lastLsn` and `lastTxn`
+    // receive the highest ids seen.
+    static int readLog(const std::function<void(const WriteRecord&)>& apply, uint64_t& lastLsn,
+                       uint64_t& lastTxn);
+    void openLog(bool truncate);
+    void appendRecord(uint64_t txn, RecordType type, const std::string& path,
+                      uint64_t offset, const char* data, size_t size);
+    void flushLog(bool sync);
+    void checkpointLocked(std::unique_lock<std::mutex>& lock);
+
+    // Signalled after each leader's fsync; committers wait until syncedLsn covers their record.
+    std::condition_variable syncDone;
+    bool syncing = false; // a leader is in its fsync, with the mutex released
+    unsigned syncWaiters = 0;
+    uint64_t syncedLsn = 0;
+    uint64_t syncs = 0;
+    unsigned groupWindowMs = 10;
+};
+
+} // namespace spl
+
+#endif // SPL_LOGMANAGER_H
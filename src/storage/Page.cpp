@@ -0,0 +1,70 @@
+#include "Page.h"
+#include <cstring>
+
+namespace spl {
+
+void SlottedPage::init() {
+    std::memset(data, 0, PAGE_SIZE);
+    header()->slotCount = 0;
+    header()->freeEnd = static_cast<uint16_t>(PAGE_SIZE);
+}
+
+uint16_t SlottedPage::slotCount() const {
+    return header()->slotCount;
+}
+
+size_t SlottedPage::freeSpace() const {
+    size_t used = sizeof(Header) + header()->slotCount * sizeof(Slot);
+    if (header()->freeEnd < used) return 0;
+    return header()->freeEnd - used;
+}
+
+size_t SlottedPage::maxRecordSize() {
+    return PAGE_SIZE - sizeof(Header) - sizeof(Slot);
+}
+
+int SlottedPage::insert(const std::string& record) {
+    if (record.size() + sizeof(Slot) > freeSpace()) return -1;
+
+    uint16_t offset = static_cast<uint16_t>(header()->freeEnd - record.size());
+    std::memcpy(data + offset, record.data(), record.size());
+
+    uint16_t id = header()->slotCount;
+    slot(id)->offset = offset;
+    slot(id)->length = static_cast<uint16_t>(record.size());
+    header()->slotCount++;
+    header()->freeEnd = offset;
+    return id;
+}
+
+bool SlottedPage::read(uint16_t i, const char*& record, uint16_t& length) const {
+    if (i >= header()->slotCount || slot(i)->offset == 0) return false;
+    record = data + slot(i)->offset;
+    length = slot(i)->length;
+    return true;
+}
+
+bool SlottedPage::update(uint16_t i, const std::string& record) {
+    if (i >= header()->slotCount || slot(i)->offset == 0) return false;
+
+    if (record.size() <= slot(i)->length) {
+        std::memcpy(data + slot(i)->offset, record.data(), record.size());
+    } else {
+        if (record.size() > freeSpace()) return false;
+        uint16_t offset = static_cast<uint16_t>(header()->freeEnd - record.size());
+        std::memcpy(data + offset, record.data(), record.size());
+        slot(i)->offset = offset;
+        header()->freeEnd = offset;
+    }
+    slot(i)->length = static_cast<uint16_t>(record.size());
+    return true;
+}
+
+bool SlottedPage::erase(uint16_t i) {
+    if (i >= header()->slotCount || slot(i)->offset == 0) return false;
+    slot(i)->offset = 0;
+    slot(i)->length = 0;
+    return true;
+}
+
+} // namespace spl
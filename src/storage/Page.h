@@ -0,0 +1,59 @@
+#ifndef SPL_PAGE_H
+#define SPL_PAGE_H
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+
+namespace spl {
+
+// Every table file is a sequence of fixed-size pages.
+constexpr size_t PAGE_SIZE = 4096;
+
+// Slotted page layout:
+//   [header][slot 0][slot 1]...  free space  ...[record 1][record 0]
+// The slot directory grows forward from the header, records grow backwards
+// from the end of the page. A slot is {offset, length}; a deleted record keeps
+// its slot (so row ids stay stable) with offset 0.
+class SlottedPage {
+public:
+    explicit SlottedPage(char* data) : data(data) {}
+
+    void init();
+
+    uint16_t slotCount() const;
+    size_t freeSpace() const;
+
+    // Returns the slot number, or -1 if the record does not fit.
+    int insert(const std::string& record);
+    // Fails for deleted or out of range slots.
+    bool read(uint16_t slot, const char*& record, uint16_t& length) const;
+    // Replaces a record, in place if it is not larger, otherwise in this page's
+    // free space. Returns false if it does not fit; the slot is then unchanged.
+    bool update(uint16_t slot, const std::string& record);
+    bool erase(uint16_t slot);
+
+    // Largest record that can ever be stored in an empty page.
+    static size_t maxRecordSize();
+
+private:
+    struct Header {
+        uint16_t slotCount;
+        uint16_t freeEnd; // records occupy [freeEnd, PAGE_SIZE)
+    };
+    struct Slot {
+        uint16_t offset;
+        uint16_t length;
+    };
+
+    char* data;
+
+    Header* header() const { return reinterpret_cast<Header*>(data); }
+    Slot* slot(uint16_t i) const {
+        return reinterpret_cast<Slot*>(data + sizeof(Header)) + i;
+    }
+};
+
+} // namespace spl
+
+#endif // SPL_PAGE_H
@@ -1,160 +1,544 @@
 #include "StorageManager.h"
+#include "HeapFile.h"
+#include "ColumnStore.h"
+#include "BPlusTree.h"
+#include "Page.h"
+#include "BufferPool.h"
+#include "LogManager.h"
+#include "Compactor.h"
+#include "TableWriter.h"
+#include "BulkLoader.h"
+#include "ZoneMap.h"
+#include "Catalog.h"
+#include <algorithm>
 #include <fstream>
+#include <sstream>
 #include <filesystem>
+#include <map>
+#include <set>
+#include <unordered_map>
 
 namespace spl {
 
 namespace fs = std::filesystem;
 
-bool StorageManager::createTable(const std::string& tableName, const std::vector<Column>& columns) {
+namespace {
+
+struct RowCounts {
+    uint64_t live = 0;
+    uint64_t dead = 0;
+};
+
+// Filled lazily from disk, then kept current by the write paths.
+std::mutex countsMutex;
+std::map<std::string, RowCounts> rowCountCache;
+
+// One writer per table, dropped when the catalog version of its schema moves on.
+struct CachedWriter {
+    uint64_t version = 0;
+    std::unique_ptr<TableWriter> writer;
+};
+std::mutex writersMutex;
+std::map<std::string, CachedWriter> writers;
+
+std::mutex versionsMutex;
+std::unordered_map<std::string, uint64_t> tableVersions;
+uint64_t lastVersion = 0;
+
+} // namespace
+
+bool StorageManager::createTable(const std::string& tableName, const std::vector<Column>& columns, TableFormat format) {
     if (!fs::exists("db")) {
         fs::create_directory("db");
     }
-    std::string pathPrefix = "db/" + tableName;
-
-    if (fs::exists(pathPrefix + ".schema")) {
+    Catalog& catalog = Catalog::instance();
+    if (catalog.exists(tableName)) {
         return false; // Already exists
     }
+    forgetRowCounts(tableName);
 
-    std::ofstream schemaFile(pathPrefix + ".schema");
-    if (!schemaFile.is_open()) return false;
+    Table schema;
+    schema.name = tableName;
+    schema.columns = columns;
+    schema.format = format;
+    // Files first: the catalog entry is what makes the table exist
+    bool ok = ZoneMap(schema).create();
+    if (format == TableFormat::COLUMNAR) {
+        ok = ok && ColumnStore(schema).create();
+    } else {
+        ok = ok && HeapFile("db/" + tableName + ".tbl").create(); // Empty data file
+    }
+    touch(tableName);
+    return ok && catalog.addTable(schema);
+}
 
-    for (const auto& col : columns) {
-        schemaFile << col.name << " " << col.type << "\n";
+Table StorageManager::loadTable(const std::string& tableName) {
+    Table table = getTableSchema(tableName);
+    if (table.columns.empty()) {
+        return table;
     }
-    schemaFile.close();
 
-    std::ofstream dataFile(pathPrefix + ".csv"); // Empty data file
-    if (!dataFile.is_open()) return false;
-    dataFile.close();
+    // Load Data
+    auto cursor = openCursor(table);
+    Row row;
+    while (cursor->next(row)) {
+        table.rows.push_back(std::move(row));
+    }
 
-    return true;
+    return table;
 }
 
-Table StorageManager::loadTable(const std::string& tableName) {
-    Table table;
-    table.name = tableName;
-    std::string pathPrefix = "db/" + tableName;
+std::unique_ptr<TableCursor> StorageManager::openCursor(const Table& schema, const std::vector<bool>& needed,
+                                                        const std::vector<ZonePredicate>& where,
+                                                        const std::vector<IntComparison>& intFilter) {
+    std::unique_ptr<TableCursor> cursor;
+    if (schema.format == TableFormat::COLUMNAR) {
+        cursor = std::make_unique<ColumnCursor>(schema, needed);
+    } else {
+        cursor = std::make_unique<HeapCursor>("db/" + schema.name + ".tbl", schema.columns, needed);
+    }
+    if (!where.empty()) {
+        auto zones = std::make_shared<ZoneMap>(schema);
+        cursor->setBlockFilter([zones, where](uint64_t block) {
+            for (const auto& pred : where) {
+                if (!zones->mayMatch(block, pred)) return false;
+            }
+            return true;
+        });
+    }
+    cursor->setIntFilter(intFilter);
+    return cursor;
+}
 
-    // Load Schema
-    std::ifstream schemaFile(pathPrefix + ".schema");
-    if (!schemaFile.is_open()) {
-        return table;
+bool StorageManager::saveTable(const Table& table) {
+    if (!fs::exists("db")) {
+        fs::create_directory("db");
+    }
+    Table schema = getTableSchema(table.name);
+    // The rewrite replaces files behind the log's back, so nothing may be left to replay
+    LogManager::instance().checkpoint();
+    bool ok;
+    if (schema.format == TableFormat::COLUMNAR) {
+        ok = ColumnStore(schema).rewrite(table.rows);
+    } else {
+        std::vector<std::string> records;
+        records.reserve(table.rows.size());
+        for (const auto& row : table.rows) {
+            std::string record;
+            if (!encodeRow(row, table.columns, record)) return false;
+            records.push_back(std::move(record));
+        }
+        ok = HeapFile("db/" + table.name + ".tbl").rewrite(records);
+    }
+
+    forgetRowCounts(table.name);
+    touch(table.name);
+
+    ok = ZoneMap(schema).rebuild() && ok;
+    // Row ids changed, so every index is rebuilt
+    for (const auto& index : schema.indexes) {
+        ok = buildIndex(schema, index) && ok;
     }
+    return ok;
+}
+
+bool StorageManager::appendRow(const std::string& tableName, const Row& row) {
+    return appendRows(tableName, {row});
+}
 
-    std::string line;
-    while (std::getline(schemaFile, line)) {
-        std::stringstream ss(line);
-        std::string name, type;
-        ss >> name >> type;
-        if (!name.empty()) {
-            table.columns.push_back({name, type});
+bool StorageManager::rowFits(const Table& schema, const Row& row) {
+    if (schema.format == TableFormat::COLUMNAR) {
+        return ColumnStore(schema).accepts(row);
+    }
+    std::string record;
+    return row.values.size() == schema.columns.size() && encodeRow(row, schema.columns, record);
+}
+
+bool StorageManager::appendRows(const std::string& tableName, const std::vector<Row>& rows) {
+    uint64_t version = Catalog::instance().version(tableName);
+    if (version == 0) return false;
+    TableWriter* writer;
+    {
+        std::lock_guard<std::mutex> lock(writersMutex);
+        CachedWriter& cached = writers[tableName];
+        if (!cached.writer || cached.version != version) {
+            cached.writer = std::make_unique<TableWriter>(getTableSchema(tableName));
+            cached.version = version;
         }
+        writer = cached.writer.get();
     }
-    schemaFile.close();
 
-    // Load Data
-    std::ifstream dataFile(pathPrefix + ".csv");
-    if (dataFile.is_open()) {
-        while (std::getline(dataFile, line)) {
-            // Simple CSV split
-            Row row;
-            std::stringstream ss(line);
-            std::string cell;
-            while (std::getline(ss, cell, ',')) {
-                 row.values.push_back(cell);
-            }
-            if (!row.values.empty()) {
-                 table.rows.push_back(row);
-            }
+    size_t written = writer->append(rows);
+    touch(tableName);
+    countRows(tableName, static_cast<int64_t>(written), 0);
+    return written == rows.size();
+}
+
+bool StorageManager::copyFrom(const std::string& tableName, const std::string& path, uint64_t& rows,
+                              std::string& error) {
+    Table schema = getTableSchema(tableName);
+    if (schema.columns.empty()) {
+        error = "table '" + tableName + "' not found";
+        return false;
+    }
+
+    // The load bypasses the log, so the log is emptied before it and the
+    // checkpoint afterwards is what makes the new pages durable.
+    LogManager::instance().checkpoint();
+    ZoneMap zones(schema);
+    uint64_t firstBlock = zones.tableBlocks();
+    if (firstBlock > 0) firstBlock--; // a columnar load can continue the last block
+    bool ok = BulkLoader(schema).load(path, rows, error);
+    if (rows > 0) {
+        ok = zones.rebuild(firstBlock) && ok;
+        for (const auto& index : schema.indexes) {
+            ok = buildIndex(schema, index) && ok;
         }
-        dataFile.close();
+        forgetRowCounts(tableName);
+        touch(tableName);
     }
+    LogManager::instance().checkpoint();
+    return ok;
+}
 
-    return table;
+bool StorageManager::updateRow(const Table& schema, uint64_t rid, const Row& oldRow, const Row& newRow,
+                               uint64_t* newRid) {
+    touch(schema.name);
+    uint64_t movedTo = rid;
+    if (schema.format == TableFormat::COLUMNAR) {
+        if (!ColumnStore(schema).updateRow(rid, oldRow, newRow)) return false;
+    } else {
+        std::string record;
+        if (!encodeRow(newRow, schema.columns, record)) return false;
+        if (!HeapFile("db/" + schema.name + ".tbl").update(rid, record, &movedTo)) return false;
+        if (movedTo != rid) countRows(schema.name, 0, 1); // old slot left behind
+    }
+    if (newRid) *newRid = movedTo;
+    if (!ZoneMap(schema).add(ZoneMap::blockOf(schema, movedTo), newRow)) return false;
+
+    for (const auto& index : schema.indexes) {
+        int col = columnIndex(schema, index.column);
+        if (col == -1) return false;
+        if (movedTo == rid && oldRow.values[col] == newRow.values[col]) continue;
+        std::string oldKey, newKey;
+        BPlusTree tree(indexPath(schema.name, index.name));
+        if (!BPlusTree::encodeKey(oldRow.values[col], oldKey) ||
+            !BPlusTree::encodeKey(newRow.values[col], newKey)) {
+            return false;
+        }
+        tree.remove(oldKey, rid);
+        if (!tree.insert(newKey, movedTo)) return false;
+    }
+    return true;
 }
 
-bool StorageManager::saveTable(const Table& table) {
-    if (!fs::exists("db")) {
-        fs::create_directory("db");
+bool StorageManager::deleteRow(const Table& schema, uint64_t rid, const Row& row) {
+    touch(schema.name);
+    if (schema.format == TableFormat::COLUMNAR) {
+        if (!ColumnStore(schema).erase(rid)) return false;
+    } else if (!HeapFile("db/" + schema.name + ".tbl").erase(rid)) {
+        return false;
     }
-    std::string pathPrefix = "db/" + table.name;
-    std::ofstream dataFile(pathPrefix + ".csv");
-    if (!dataFile.is_open()) return false;
 
-    for (const auto& row : table.rows) {
-        for (size_t i = 0; i < row.values.size(); ++i) {
-            dataFile << row.values[i];
-            if (i < row.values.size() - 1) {
-                dataFile << ",";
-            }
+    for (const auto& index : schema.indexes) {
+        int col = columnIndex(schema, index.column);
+        std::string key;
+        if (col != -1 && BPlusTree::encodeKey(row.values[col], key)) {
+            BPlusTree(indexPath(schema.name, index.name)).remove(key, rid);
         }
-        dataFile << "\n";
     }
-    dataFile.close();
+    countRows(schema.name, -1, 1);
     return true;
 }
 
-bool StorageManager::appendRow(const std::string& tableName, const Row& row) {
-    if (!fs::exists("db")) {
-        fs::create_directory("db");
+bool StorageManager::rowCounts(const std::string& tableName, uint64_t& live, uint64_t& dead) {
+    {
+        std::lock_guard<std::mutex> lock(countsMutex);
+        auto it = rowCountCache.find(tableName);
+        if (it != rowCountCache.end()) {
+            live = it->second.live;
+            dead = it->second.dead;
+            return true;
+        }
     }
-    std::string pathPrefix = "db/" + tableName;
-    std::ofstream dataFile(pathPrefix + ".csv", std::ios::app);
-    if (!dataFile.is_open()) return false;
 
-    for (size_t i = 0; i < row.values.size(); ++i) {
-        dataFile << row.values[i];
-        if (i < row.values.size() - 1) {
-            dataFile << ",";
+    Table schema = getTableSchema(tableName);
+    if (schema.columns.empty()) return false;
+    RowCounts counts;
+    if (schema.format == TableFormat::COLUMNAR) {
+        ColumnStore store(schema);
+        counts.dead = store.deletedCount();
+        counts.live = store.rowCount() - counts.dead;
+    } else {
+        std::string path = "db/" + tableName + ".tbl";
+        uint32_t pages = BufferPool::instance().pageCount(path);
+        for (uint32_t p = 0; p < pages; ++p) {
+            PageGuard guard(path, p);
+            if (!guard.valid()) break;
+            SlottedPage page(guard.data());
+            for (uint16_t slot = 0; slot < page.slotCount(); ++slot) {
+                const char* record;
+                uint16_t length;
+                if (page.read(slot, record, length)) counts.live++;
+                else counts.dead++;
+            }
         }
     }
-    dataFile << "\n";
-    dataFile.close();
+
+    std::lock_guard<std::mutex> lock(countsMutex);
+    rowCountCache[tableName] = counts;
+    live = counts.live;
+    dead = counts.dead;
     return true;
 }
 
+void StorageManager::countRows(const std::string& tableName, int64_t live, int64_t dead) {
+    uint64_t liveNow, deadNow;
+    {
+        std::lock_guard<std::mutex> lock(countsMutex);
+        auto it = rowCountCache.find(tableName);
+        if (it != rowCountCache.end()) {
+            it->second.live += live;
+            it->second.dead += dead;
+        }
+    }
+    // A first look reads the counts from disk, where this change already is
+    if (dead > 0 && rowCounts(tableName, liveNow, deadNow) &&
+        Compactor::instance().shouldVacuum(liveNow, deadNow)) {
+        Compactor::instance().schedule(tableName);
+    }
+}
+
+void StorageManager::forgetRowCounts(const std::string& tableName) {
+    std::lock_guard<std::mutex> lock(countsMutex);
+    rowCountCache.erase(tableName);
+}
+
+uint64_t StorageManager::tableVersion(const std::string& tableName) {
+    std::lock_guard<std::mutex> lock(versionsMutex);
+    auto it = tableVersions.find(tableName);
+    return it == tableVersions.end() ? 0 : it->second;
+}
+
+void StorageManager::touch(const std::string& tableName) {
+    std::lock_guard<std::mutex> lock(versionsMutex);
+    tableVersions[tableName] = ++lastVersion;
+}
+
+int64_t StorageManager::vacuumTable(const std::string& tableName) {
+    uint64_t live, dead;
+    if (!rowCounts(tableName, live, dead)) return -1;
+    if (dead == 0) return 0;
+
+    // Cursors skip tombstones, so this is exactly the live rows
+    Table table = loadTable(tableName);
+    if (!saveTable(table)) return -1;
+    return static_cast<int64_t>(dead);
+}
+
+bool StorageManager::analyzeTable(const std::string& tableName) {
+    Table schema = getTableSchema(tableName);
+    if (schema.columns.empty()) return false;
+    StatsCollector collector(schema);
+    auto cursor = openCursor(schema);
+    Row row;
+    while (cursor->next(row)) {
+        collector.add(row);
+    }
+    return Catalog::instance().setStats(tableName, collector.finish());
+}
+
+std::shared_ptr<const TableStats> StorageManager::tableStats(const std::string& tableName) {
+    return Catalog::instance().stats(tableName);
+}
+
+std::mutex& StorageManager::statementLock() {
+    static std::mutex lock;
+    return lock;
+}
+
+void StorageManager::beginTransaction() {
+    LogManager::instance().begin();
+}
+
+void StorageManager::commitTransaction() {
+    LogManager::instance().commit();
+}
+
+void StorageManager::abortTransaction() {
+    std::set<std::string> tables;
+    LogManager::instance().abort(tables);
+    for (const auto& name : tables) {
+        resyncTable(name);
+    }
+}
+
+int StorageManager::recover() {
+    std::set<std::string> tables;
+    int recovered = LogManager::instance().recover(tables);
+    for (const auto& name : tables) {
+        resyncTable(name);
+    }
+    return recovered;
+}
+
+void StorageManager::resyncTable(const std::string& tableName) {
+    Table schema = getTableSchema(tableName);
+    if (schema.columns.empty()) return;
+    {
+        std::lock_guard<std::mutex> lock(writersMutex);
+        writers.erase(tableName);
+    }
+    forgetRowCounts(tableName);
+    touch(tableName);
+    ZoneMap(schema).rebuild();
+    for (const auto& index : schema.indexes) {
+        buildIndex(schema, index);
+    }
+}
+
+void StorageManager::checkpoint() {
+    LogManager::instance().checkpoint();
+}
+
+void StorageManager::shutdown() {
+    Compactor::instance().stop();
+    LogManager::instance().checkpoint();
+    LogManager::instance().close();
+}
+
+bool StorageManager::fetchRow(const Table& schema, uint64_t rid, Row& row) {
+    if (schema.format == TableFormat::COLUMNAR) {
+        return ColumnStore(schema).readRow(rid, row);
+    }
+    return HeapFile("db/" + schema.name + ".tbl").read(rid, schema.columns, row);
+}
+
+std::string StorageManager::indexPath(const std::string& tableName, const std::string& indexName) {
+    return "db/" + tableName + "." + indexName + ".idx";
+}
+
+bool StorageManager::createIndex(const std::string& tableName, const std::string& indexName, const std::string& column) {
+    Table schema = getTableSchema(tableName);
+    if (schema.columns.empty() || columnIndex(schema, column) == -1) return false;
+    for (const auto& index : schema.indexes) {
+        if (index.name == indexName) return false;
+    }
+
+    IndexInfo index{indexName, column};
+    if (!buildIndex(schema, index)) {
+        BPlusTree(indexPath(tableName, indexName)).drop();
+        return false;
+    }
+
+    touch(tableName);
+    return Catalog::instance().addIndex(tableName, index);
+}
+
+bool StorageManager::buildIndex(const Table& schema, const IndexInfo& index) {
+    int col = columnIndex(schema, index.column);
+    if (col == -1) return false;
+    bool isInt = isIntType(schema.columns[col].type);
+
+    std::vector<bool> needed(schema.columns.size(), false);
+    needed[col] = true;
+    std::vector<std::pair<std::string, uint64_t>> entries;
+    auto cursor = openCursor(schema, needed);
+    Row row;
+    while (cursor->next(row)) {
+        std::string key;
+        if (!BPlusTree::encodeKey(row.values[col], key)) return false;
+        entries.push_back({std::move(key), cursor->currentRid()});
+    }
+    std::sort(entries.begin(), entries.end());
+
+    BPlusTree tree(indexPath(schema.name, index.name));
+    return tree.build(isInt, entries) && tree.flush();
+}
+
+int StorageManager::columnIndex(const Table& schema, const std::string& column) {
+    return Catalog::instance().columnIndex(schema.name, column);
+}
+
 bool StorageManager::dropTable(const std::string& tableName) {
-    std::string pathPrefix = "db/" + tableName;
-    bool s = fs::remove(pathPrefix + ".schema");
-    bool d = fs::remove(pathPrefix + ".csv");
-    return s && d;
+    Table schema = getTableSchema(tableName);
+    LogManager::instance().checkpoint();
+    // Once the catalog entry is gone the table no longer exists, whatever happens to its files
+    if (!Catalog::instance().dropTable(tableName)) return false;
+    forgetRowCounts(tableName);
+    touch(tableName);
+    for (const auto& index : schema.indexes) {
+        BPlusTree(indexPath(tableName, index.name)).drop();
+    }
+    ZoneMap(schema).remove();
+    if (schema.format == TableFormat::COLUMNAR) {
+        return ColumnStore(schema).remove();
+    }
+    return HeapFile("db/" + tableName + ".tbl").remove();
 }
 
 std::vector<std::string> StorageManager::listTables() {
-    std::vector<std::string> tables;
-    if (!fs::exists("db")) return tables;
-    
-    for (const auto& entry : fs::directory_iterator("db")) {
-        if (entry.path().extension() == ".schema") {
-            tables.push_back(entry.path().stem().string());
-        }
-    }
-    return tables;
+    return Catalog::instance().tableNames();
 }
 
 Table StorageManager::getTableSchema(const std::string& tableName) {
-     Table table;
-    table.name = tableName;
-    std::string pathPrefix = "db/" + tableName;
+    return Catalog::instance().schema(tableName);
+}
 
-    // Load Schema Only
-    std::ifstream schemaFile(pathPrefix + ".schema");
-    if (!schemaFile.is_open()) {
-        return table;
+int StorageManager::convertLegacyTables() {
+    int converted = 0;
+    if (!fs::exists("db")) return converted;
+
+    std::vector<fs::path> csvFiles;
+    for (const auto& entry : fs::directory_iterator("db")) {
+        if (entry.path().extension() == ".csv") csvFiles.push_back(entry.path());
     }
 
-    std::string line;
-    while (std::getline(schemaFile, line)) {
-        std::stringstream ss(line);
-        std::string name, type;
-        ss >> name >> type;
-        if (!name.empty()) {
-            table.columns.push_back({name, type});
+    for (const auto& csvPath : csvFiles) {
+        std::string tableName = csvPath.stem().string();
+        std::string pathPrefix = "db/" + tableName;
+        if (!Catalog::instance().exists(tableName) || fs::exists(pathPrefix + ".tbl")) continue;
+
+        // Old format: one row per line, cells split on ','
+        Table table = getTableSchema(tableName);
+        std::ifstream csv(csvPath);
+        std::string line;
+        while (std::getline(csv, line)) {
+            Row row;
+            std::stringstream ss(line);
+            std::string cell;
+            while (std::getline(ss, cell, ',')) {
+                // A malformed cell stays NULL, which saveTable refuses
+                Value value;
+                size_t col = row.values.size();
+                if (col < table.columns.size()) Value::parse(cell, table.columns[col].type, value);
+                row.values.push_back(std::move(value));
+            }
+            if (!row.values.empty()) {
+                table.rows.push_back(row);
+            }
+        }
+        csv.close();
+
+        if (saveTable(table)) {
+            fs::remove(csvPath);
+            converted++;
+        } else {
+            std::cout << "Warning: could not convert " << csvPath.string() << ", left as is.\n";
         }
     }
-    schemaFile.close();
-    return table;
+    return converted;
+}
+
+int StorageManager::buildMissingZoneMaps() {
+    int built = 0;
+    for (const auto& name : listTables()) {
+        Table schema = getTableSchema(name);
+        ZoneMap zones(schema);
+        if (schema.columns.empty() || fs::exists(zones.filePath())) continue;
+        if (zones.rebuild()) built++;
+    }
+    return built;
 }
 
 } // namespace spl
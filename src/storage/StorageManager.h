@@ -3,19 +3,109 @@
 
 #include <string>
 #include <vector>
+#include <memory>
+#include <mutex>
+#include <cstdint>
 #include "StorageStructs.h"
+#include "TableCursor.h"
+#include "ZoneMap.h"
+#include "TableStats.h"
 
 namespace spl {
 
 class StorageManager {
 public:
-    static bool createTable(const std::string& tableName, const std::vector<Column>& columns);
+    static bool createTable(const std::string& tableName, const std::vector<Column>& columns,
+                            TableFormat format = TableFormat::ROW);
     static Table loadTable(const std::string& tableName);
+    // Streams the rows of a table whose schema was fetched with getTableSchema.
+    // Only columns flagged in `needed` are read (all of them if it is empty).
+    // Blocks whose zone map rules out any of the `where` predicates are
+    // skipped, and `intFilter` is handed to the cursor (see
+    // TableCursor::setIntFilter); the caller still filters the rows it gets
+    // unless the cursor appliesIntFilter and that covers the whole WHERE.
+    static std::unique_ptr<TableCursor> openCursor(const Table& schema, const std::vector<bool>& needed = {},
+                                                   const std::vector<ZonePredicate>& where = {},
+                                                   const std::vector<IntComparison>& intFilter = {});
     static bool saveTable(const Table& table);
     static bool appendRow(const std::string& tableName, const Row& row);
+    // Whether the row can be stored in the table: cells of the column types,
+    // and for a heap table an encoded record that fits in a page.
+    static bool rowFits(const Table& schema, const Row& row);
+    // Appends through the table's cached TableWriter; all rows or an error.
+    static bool appendRows(const std::string& tableName, const std::vector<Row>& rows);
+    // COPY: bulk loads a CSV file with BulkLoader, bypassing the log, then
+    // rebuilds the table's indexes and zone map and checkpoints.
+    static bool copyFrom(const std::string& tableName, const std::string& path, uint64_t& rows, std::string& error);
     static bool dropTable(const std::string& tableName);
+    // Both served from the Catalog, no file access.
     static std::vector<std::string> listTables();
     static Table getTableSchema(const std::string& tableName);
+
+    // Reads a single row by the id reported by TableCursor::currentRid.
+    static bool fetchRow(const Table& schema, uint64_t rid, Row& row);
+
+    // In-place row changes; `oldRow` is the row's current content, needed to
+    // maintain indexes. Updated heap rows can move, `newRid` gets the new id.
+    static bool updateRow(const Table& schema, uint64_t rid, const Row& oldRow, const Row& newRow,
+                          uint64_t* newRid = nullptr);
+    // Leaves a tombstone (a free slot, or a bit in the columnar deletion bitmap)
+    // that scans skip until the table is vacuumed.
+    static bool deleteRow(const Table& schema, uint64_t rid, const Row& row);
+
+    // Changes whenever the table's rows or schema do (writes, DDL, DROP), and
+    // never returns to an earlier value, so anything computed from a table
+    // can tell when it went stale. 0 for a table not changed since startup.
+    static uint64_t tableVersion(const std::string& tableName);
+
+    // Live rows and dead (deleted but not yet vacuumed) rows of a table.
+    static bool rowCounts(const std::string& tableName, uint64_t& live, uint64_t& dead);
+    // ANALYZE: reads the whole table into fresh statistics, kept in the catalog.
+    static bool analyzeTable(const std::string& tableName);
+    // Null until the table is analyzed. Not updated by writes: the planner
+    // scales them by the current row counts.
+    static std::shared_ptr<const TableStats> tableStats(const std::string& tableName);
+    // Rewrites the table without its dead rows. Returns how many were removed, -1 on error.
+    static int64_t vacuumTable(const std::string& tableName);
+    // Held while a statement runs, so background work never sees one half done.
+    static std::mutex& statementLock();
+
+    // Write statements run between these two; commit makes them durable
+    // through the write-ahead log (see LogManager).
+    static void beginTransaction();
+    static void commitTransaction();
+    // Undoes the open transaction instead of committing it, e.g. after a
+    // write failed part way through a statement.
+    static void abortTransaction();
+    // Replays the log after a crash and rebuilds indexes and zone maps of the tables it touched.
+    // Returns the number of transactions recovered.
+    static int recover();
+    // Writes all cached pages back and empties the log.
+    static void checkpoint();
+    // Stops background threads and checkpoints; call before exiting.
+    static void shutdown();
+
+    // B+tree indexes, kept up to date by appendRow and saveTable.
+    static bool createIndex(const std::string& tableName, const std::string& indexName, const std::string& column);
+    static std::string indexPath(const std::string& tableName, const std::string& indexName);
+
+    // One-shot migration of db/<table>.csv files written by older versions.
+    static int convertLegacyTables();
+    // Builds db/<table>.zone for tables created before zone maps existed.
+    static int buildMissingZoneMaps();
+
+private:
+    static bool buildIndex(const Table& schema, const IndexInfo& index);
+    // Adjusts the cached row counts after a write and wakes the compactor if needed.
+    static void countRows(const std::string& tableName, int64_t live, int64_t dead);
+    static void forgetRowCounts(const std::string& tableName);
+    // Moves tableVersion on; every write path and DDL calls it.
+    static void touch(const std::string& tableName);
+    static int columnIndex(const Table& schema, const std::string& column);
+    // After the log replaced a table's pages underneath (recovery, rollback):
+    // rebuilds its indexes and zone map, which are not logged, and drops its
+    // cached writer and row counts.
+    static void resyncTable(const std::string& tableName);
 };
 
 } // namespace spl
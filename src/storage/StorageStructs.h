@@ -3,8 +3,12 @@
 
 #include <string>
 #include <vector>
+#include <cstdint>
+#include <cstdlib>
+#include <cerrno>
 #include <iostream>
 #include <iomanip>
+#include <utility>
 
 namespace spl {
 
@@ -13,8 +17,116 @@ struct Column {
     std::string type; // "INT", "STRING"
 };
 
+// Index of the column called `name`, -1 if there is none. Columns of a join
+// are qualified ("table.column"); a bare name then matches the column it
+// ends, unless several do, which sets `ambiguous`.
+inline int findColumn(const std::vector<Column>& columns, const std::string& name, bool* ambiguous = nullptr) {
+    if (ambiguous) *ambiguous = false;
+    for (size_t i = 0; i < columns.size(); ++i) {
+        if (columns[i].name == name) return static_cast<int>(i);
+    }
+    if (name.find('.') != std::string::npos) return -1;
+    int found = -1;
+    for (size_t i = 0; i < columns.size(); ++i) {
+        const std::string& col = columns[i].name;
+        if (col.size() > name.size() && col[col.size() - name.size() - 1] == '.' &&
+            col.compare(col.size() - name.size(), name.size(), name) == 0) {
+            if (found != -1) {
+                if (ambiguous) *ambiguous = true;
+                return -1;
+            }
+            found = static_cast<int>(i);
+        }
+    }
+    return found;
+}
+
+inline bool isIntType(const std::string& type) {
+    return type == "INT" || type == "int";
+}
+
+// Strict base-10 parse of a stored INT cell.
+inline bool parseInt64(const std::string& s, int64_t& out) {
+    if (s.empty()) return false;
+    char* end = nullptr;
+    errno = 0;
+    long long v = std::strtoll(s.c_str(), &end, 10);
+    if (*end != '\0' || errno == ERANGE) return false;
+    out = v;
+    return true;
+}
+
+struct IndexInfo {
+    std::string name;
+    std::string column;
+};
+
+enum class TableFormat {
+    ROW,      // slotted heap pages, db/<table>.tbl
+    COLUMNAR  // one file per column, see ColumnStore
+};
+
+// One cell. INT cells are parsed once, when a row is decoded or inserted, so
+// filtering and sorting compare numbers instead of text. NULL is what a scan
+// leaves in the columns it was told to skip.
+class Value {
+public:
+    enum class Type : uint8_t { NUL, INT, STRING };
+
+    Value() = default;
+    explicit Value(int64_t v) : kind(Type::INT), number(v) {}
+    explicit Value(std::string s) : kind(Type::STRING), text(std::move(s)) {}
+
+    // Reads the text form of a cell of a column of type `columnType`. Fails for a malformed INT.
+    static bool parse(const std::string& cell, const std::string& columnType, Value& out) {
+        if (!isIntType(columnType)) {
+            out = Value(cell);
+            return true;
+        }
+        int64_t v;
+        if (!parseInt64(cell, v)) return false;
+        out = Value(v);
+        return true;
+    }
+
+    Type type() const { return kind; }
+    bool isNull() const { return kind == Type::NUL; }
+    bool isInt() const { return kind == Type::INT; }
+    bool isString() const { return kind == Type::STRING; }
+    int64_t asInt() const { return number; }
+    const std::string& asString() const { return text; }
+
+    std::string toString() const {
+        if (kind == Type::INT) return std::to_string(number);
+        if (kind == Type::STRING) return text;
+        return "NULL";
+    }
+
+    bool operator==(const Value& other) const {
+        if (kind != other.kind) return false;
+        if (kind == Type::INT) return number == other.number;
+        return kind == Type::NUL || text == other.text;
+    }
+    bool operator!=(const Value& other) const { return !(*this == other); }
+    // NULL sorts first, then INTs, then STRINGs.
+    bool operator<(const Value& other) const {
+        if (kind != other.kind) return kind < other.kind;
+        if (kind == Type::INT) return number < other.number;
+        return kind == Type::STRING && text < other.text;
+    }
+
+private:
+    Type kind = Type::NUL;
+    int64_t number = 0;
+    std::string text;
+};
+
+inline std::ostream& operator<<(std::ostream& out, const Value& value) {
+    return out << value.toString();
+}
+
 struct Row {
-    std::vector<std::string> values;
+    std::vector<Value> values;
 };
 
 class Table {
@@ -22,23 +134,33 @@ public:
     std::string name;
     std::vector<Column> columns;
     std::vector<Row> rows;
+    TableFormat format = TableFormat::ROW;
+    std::vector<IndexInfo> indexes;
 
     void print() const {
-        // Simple pretty print
+        printHeader(columns);
+        for (const auto& row : rows) {
+            printRow(row);
+        }
+    }
+
+    // Simple pretty print, also used to stream query results row by row
+    static void printHeader(const std::vector<Column>& columns) {
         for (const auto& col : columns) {
             std::cout << std::left << std::setw(15) << col.name;
         }
         std::cout << "\n";
-        for (const auto& col : columns) {
+        for (size_t i = 0; i < columns.size(); ++i) {
             std::cout << "---------------";
         }
         std::cout << "\n";
-        for (const auto& row : rows) {
-            for (const auto& val : row.values) {
-                std::cout << std::left << std::setw(15) << val;
-            }
-            std::cout << "\n";
+    }
+
+    static void printRow(const Row& row) {
+        for (const auto& val : row.values) {
+            std::cout << std::left << std::setw(15) << val;
         }
+        std::cout << "\n";
     }
 };
 
@@ -0,0 +1,57 @@
+#include "TableCursor.h"
+#include <algorithm>
+#include "BufferPool.h"
+#include "HeapFile.h"
+#include "Page.h"
+
+namespace spl {
+
+HeapCursor::HeapCursor(const std::string& path, const std::vector<Column>& columns,
+                       const std::vector<bool>& needed)
+    : path(path), columns(columns), needed(needed), pageCount(BufferPool::instance().pageCount(path)),
+      endPage(pageCount) {
+    if (this->needed.size() != columns.size()) {
+        this->needed.assign(columns.size(), true);
+    }
+}
+
+bool HeapCursor::loadNextPage() {
+    batch.clear();
+    batchRids.clear();
+    batchPos = 0;
+    while (batch.empty() && nextPage < endPage) {
+        uint32_t pageNo = nextPage++;
+        if (blockFilter && !blockFilter(pageNo)) continue;
+        PageGuard guard(path, pageNo);
+        if (!guard.valid()) return false;
+        SlottedPage page(guard.data());
+        batch.reserve(page.slotCount());
+        for (uint16_t slot = 0; slot < page.slotCount(); ++slot) {
+            const char* record;
+            uint16_t length;
+            Row row;
+            if (page.read(slot, record, length) && decodeRow(record, length, columns, row, &needed)) {
+                batch.push_back(std::move(row));
+                batchRids.push_back(makeRid(pageNo, slot));
+            }
+        }
+    }
+    return !batch.empty();
+}
+
+void HeapCursor::setBlockRange(uint64_t begin, uint64_t end) {
+    nextPage = static_cast<uint32_t>(std::min<uint64_t>(begin, pageCount));
+    endPage = static_cast<uint32_t>(std::min<uint64_t>(end, pageCount));
+    batch.clear();
+    batchRids.clear();
+    batchPos = 0;
+}
+
+bool HeapCursor::next(Row& row) {
+    if (batchPos >= batch.size() && !loadNextPage()) return false;
+    rid = batchRids[batchPos];
+    row = std::move(batch[batchPos++]);
+    return true;
+}
+
+} // namespace spl
@@ -0,0 +1,83 @@
+#ifndef SPL_TABLECURSOR_H
+#define SPL_TABLECURSOR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+#include "StorageStructs.h"
+#include "../utils/SimdFilter.h"
+
+namespace spl {
+
+// "column op value" on an INT column, pushed down into a scan.
+struct IntComparison {
+    int column;
+    CompareOp op;
+    int64_t value;
+};
+
+// Streams the rows of a stored table one at a time. Implementations keep at
+// most one page worth of decoded rows in memory.
+class TableCursor {
+public:
+    virtual ~TableCursor() = default;
+    virtual bool next(Row& row) = 0;
+
+    // Row id of the row last returned by next(), usable with StorageManager::fetchRow.
+    uint64_t currentRid() const { return rid; }
+
+    // Blocks (heap pages, column blocks) of the table. A scan can be split
+    // into block ranges read one after the other with setBlockRange.
+    virtual uint64_t blockCount() const = 0;
+    // Restarts the cursor on blocks [begin, end).
+    virtual void setBlockRange(uint64_t begin, uint64_t end) = 0;
+
+    // Blocks (see ZoneMap) the filter returns false for are skipped without being read.
+    using BlockFilter = std::function<bool(uint64_t block)>;
+    void setBlockFilter(BlockFilter filter) { blockFilter = std::move(filter); }
+
+    // Rows failing any of these are dropped. Only cursors over typed column
+    // data (ColumnCursor) apply them, with SimdFilter kernels, before decoding
+    // a row; check appliesIntFilter before relying on it.
+    void setIntFilter(std::vector<IntComparison> filter) { intFilter = std::move(filter); }
+    virtual bool appliesIntFilter() const { return false; }
+
+protected:
+    uint64_t rid = 0;
+    BlockFilter blockFilter;
+    std::vector<IntComparison> intFilter;
+};
+
+// Heap row ids pack the page number and the slot within the page.
+inline uint64_t makeRid(uint32_t pageNo, uint16_t slot) {
+    return (static_cast<uint64_t>(pageNo) << 16) | slot;
+}
+inline uint32_t ridPage(uint64_t rid) { return static_cast<uint32_t>(rid >> 16); }
+inline uint16_t ridSlot(uint64_t rid) { return static_cast<uint16_t>(rid & 0xFFFF); }
+
+class HeapCursor : public TableCursor {
+public:
+    HeapCursor(const std::string& path, const std::vector<Column>& columns,
+               const std::vector<bool>& needed = {});
+    bool next(Row& row) override;
+    uint64_t blockCount() const override { return pageCount; }
+    void setBlockRange(uint64_t begin, uint64_t end) override;
+
+private:
+    std::string path;
+    std::vector<Column> columns;
+    std::vector<bool> needed;
+    uint32_t pageCount;
+    uint32_t nextPage = 0;
+    uint32_t endPage;
+    std::vector<Row> batch;
+    std::vector<uint64_t> batchRids;
+    size_t batchPos = 0;
+
+    bool loadNextPage();
+};
+
+} // namespace spl
+
+#endif // SPL_TABLECURSOR_H
@@ -0,0 +1,134 @@
+#include "TableStats.h"
+#include <algorithm>
+#include <map>
+#include <set>
+
+namespace spl {
+
+double ColumnStats::selectivity(CompareOp op, const Value& literal) const {
+    double nonNull = 1.0 - nullFraction;
+    double commonTotal = 0;
+    double commonMatch = 0;
+    for (const auto& entry : common) {
+        commonTotal += entry.second;
+        const Value& v = entry.first;
+        bool match = false;
+        switch (op) {
+            case CompareOp::EQ: match = v == literal; break;
+            case CompareOp::NE: match = v != literal; break;
+            case CompareOp::LT: match = v < literal; break;
+            case CompareOp::LE: match = !(literal < v); break;
+            case CompareOp::GT: match = literal < v; break;
+            case CompareOp::GE: match = !(v < literal); break;
+        }
+        if (match) commonMatch += entry.second;
+    }
+    double rest = std::max(0.0, nonNull - commonTotal);
+
+    double result = commonMatch;
+    if (op == CompareOp::EQ || op == CompareOp::NE) {
+        // Values outside the list are taken to be equally common
+        double others = std::max(1.0, distinct - static_cast<double>(common.size()));
+        bool listed = false;
+        for (const auto& entry : common) listed = listed || entry.first == literal;
+        double equal = listed || bounds.empty() ? 0 : rest / others;
+        result += op == CompareOp::EQ ? equal : rest - equal;
+    } else if (!bounds.empty()) {
+        double below = histogramBelow(literal);
+        result += rest * (op == CompareOp::LT || op == CompareOp::LE ? below : 1.0 - below);
+    }
+    return std::min(1.0, std::max(0.0, result));
+}
+
+double ColumnStats::histogramBelow(const Value& literal) const {
+    if (literal < bounds.front()) return 0;
+    if (!(literal < bounds.back())) return 1;
+    size_t buckets = bounds.size() - 1;
+    size_t i = std::upper_bound(bounds.begin(), bounds.end(), literal) - bounds.begin() - 1;
+    // Within a bucket INTs are taken to be spread evenly, strings to sit in the middle
+    double within = 0.5;
+    const Value& from = bounds[i];
+    const Value& to = bounds[i + 1];
+    if (literal.isInt() && from.isInt() && to.isInt() && to.asInt() > from.asInt()) {
+        within = (static_cast<double>(literal.asInt()) - from.asInt()) / (static_cast<double>(to.asInt()) - from.asInt());
+    }
+    return (i + within) / buckets;
+}
+
+StatsCollector::StatsCollector(const Table& schema)
+    : width(schema.columns.size()), nulls(width, 0), sketches(width), random(0x5eed) {}
+
+void StatsCollector::add(const Row& row) {
+    rows++;
+    for (size_t c = 0; c < width && c < row.values.size(); ++c) {
+        const Value& v = row.values[c];
+        if (v.isNull()) {
+            nulls[c]++;
+        } else if (v.isInt()) {
+            sketches[c].add(v.asInt());
+        } else {
+            sketches[c].add(v.asString());
+        }
+    }
+    if (sample.size() < SAMPLE_ROWS) {
+        sample.push_back(row);
+    } else {
+        uint64_t slot = std::uniform_int_distribution<uint64_t>(0, rows - 1)(random);
+        if (slot < SAMPLE_ROWS) sample[slot] = row;
+    }
+}
+
+TableStats StatsCollector::finish() {
+    TableStats stats;
+    stats.rows = rows;
+    stats.columns.resize(width);
+    if (rows == 0) return stats;
+    double sampled = static_cast<double>(sample.size());
+
+    for (size_t c = 0; c < width; ++c) {
+        ColumnStats& column = stats.columns[c];
+        column.nullFraction = static_cast<double>(nulls[c]) / rows;
+
+        std::map<Value, size_t> counts;
+        size_t nonNull = 0;
+        for (const auto& row : sample) {
+            if (c >= row.values.size() || row.values[c].isNull()) continue;
+            counts[row.values[c]]++;
+            nonNull++;
+        }
+        // The sketch can undercount a handful of values slightly
+        column.distinct = std::max(sketches[c].estimate(), static_cast<double>(counts.size()));
+        if (nonNull == 0) continue;
+
+        // Values seen clearly more often than the average one are common;
+        // when the sample holds few values, all of them are
+        std::vector<std::pair<size_t, Value>> byCount;
+        for (const auto& entry : counts) byCount.push_back({entry.second, entry.first});
+        std::stable_sort(byCount.begin(), byCount.end(),
+                         [](const auto& a, const auto& b) { return a.first > b.first; });
+        bool all = counts.size() <= COMMON_VALUES && column.distinct <= COMMON_VALUES;
+        double average = static_cast<double>(nonNull) / counts.size();
+        std::set<Value> listed;
+        for (const auto& entry : byCount) {
+            if (column.common.size() == COMMON_VALUES) break;
+            if (!all && (entry.first < 2 || entry.first <= 1.25 * average)) break;
+            column.common.push_back({entry.second, entry.first / sampled});
+            listed.insert(entry.second);
+        }
+
+        std::vector<Value> rest;
+        for (const auto& entry : counts) {
+            if (listed.count(entry.first)) continue;
+            rest.insert(rest.end(), entry.second, entry.first);
+        }
+        if (rest.empty()) continue;
+        size_t buckets = std::min(BUCKETS, rest.size());
+        for (size_t b = 0; b <= buckets; ++b) {
+            column.bounds.push_back(rest[b * (rest.size() - 1) / buckets]);
+        }
+    }
+    sample.clear();
+    return stats;
+}
+
+} // namespace spl
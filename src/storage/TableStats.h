@@ -0,0 +1,64 @@
+#ifndef SPL_TABLESTATS_H
+#define SPL_TABLESTATS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <utility>
+#include <vector>
+#include "StorageStructs.h"
+#include "../utils/HyperLogLog.h"
+#include "../utils/SimdFilter.h"
+
+namespace spl {
+
+// What ANALYZE learned about one column. Fractions are of all the table's rows.
+struct ColumnStats {
+    double nullFraction = 0;
+    double distinct = 0; // non-NULL values
+    // The most common values, most frequent first, each with its fraction
+    std::vector<std::pair<Value, double>> common;
+    // Equi-depth histogram of the other non-NULL values: each of the
+    // bounds.size() - 1 buckets between neighbouring bounds holds as many.
+    std::vector<Value> bounds;
+
+    // Estimated fraction of the rows where `cell op literal` holds.
+    double selectivity(CompareOp op, const Value& literal) const;
+
+private:
+    // Share of the histogram's values below `literal`.
+    double histogramBelow(const Value& literal) const;
+};
+
+// Statistics of a table as of its last ANALYZE, kept in the catalog.
+struct TableStats {
+    uint64_t rows = 0;
+    std::vector<ColumnStats> columns; // in schema order
+};
+
+// Builds TableStats in one pass over a table. Row and NULL counts are exact
+// and distinct counts come from a HyperLogLog per column; the most common
+// values and histograms come from a uniform sample of SAMPLE_ROWS rows
+// (reservoir sampling, with a fixed seed so plans are repeatable).
+class StatsCollector {
+public:
+    static constexpr size_t SAMPLE_ROWS = 30000;
+    static constexpr size_t COMMON_VALUES = 10;
+    static constexpr size_t BUCKETS = 50;
+
+    explicit StatsCollector(const Table& schema);
+    void add(const Row& row);
+    TableStats finish();
+
+private:
+    size_t width;
+    uint64_t rows = 0;
+    std::vector<uint64_t> nulls;
+    std::vector<HyperLogLog> sketches;
+    std::vector<Row> sample;
+    std::mt19937_64 random;
+};
+
+} // namespace spl
+
+#endif // SPL_TABLESTATS_H
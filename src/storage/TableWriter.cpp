@@ -0,0 +1,47 @@
+#include "TableWriter.h"
+#include "StorageManager.h"
+
+namespace spl {
+
+TableWriter::TableWriter(const Table& schema) : table(schema), zones(schema) {
+    if (table.format == TableFormat::COLUMNAR) {
+        columns = std::make_unique<ColumnStore>(table);
+    } else {
+        heap = std::make_unique<HeapFile>("db/" + table.name + ".tbl");
+    }
+
+    for (const auto& index : table.indexes) {
+        for (size_t c = 0; c < table.columns.size(); ++c) {
+            if (table.columns[c].name != index.column) continue;
+            indexes.push_back({BPlusTree(StorageManager::indexPath(table.name, index.name)), static_cast<int>(c)});
+            break;
+        }
+    }
+}
+
+size_t TableWriter::append(const std::vector<Row>& rows) {
+    size_t written = 0;
+    for (const auto& row : rows) {
+        uint64_t rid;
+        if (columns) {
+            if (!columns->append(row, &rid)) break;
+        } else {
+            if (!encodeRow(row, table.columns, record) || !heap->append(record, &rid)) break;
+        }
+        if (!zones.add(ZoneMap::blockOf(table, rid), row)) break;
+
+        bool ok = true;
+        for (auto& index : indexes) {
+            if (!BPlusTree::encodeKey(row.values[index.column], key) ||
+                !index.tree.insert(key, rid)) {
+                ok = false;
+                break;
+            }
+        }
+        if (!ok) break;
+        written++;
+    }
+    return written;
+}
+
+} // namespace spl
@@ -0,0 +1,46 @@
+#ifndef SPL_TABLEWRITER_H
+#define SPL_TABLEWRITER_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "BPlusTree.h"
+#include "ColumnStore.h"
+#include "HeapFile.h"
+#include "StorageStructs.h"
+#include "ZoneMap.h"
+
+namespace spl {
+
+// Append path for one table: its data file, zone map and index trees, resolved once.
+// StorageManager keeps a writer per table across INSERTs, so a stream of
+// inserts does not re-read the schema or re-resolve files for every row.
+class TableWriter {
+public:
+    explicit TableWriter(const Table& schema);
+
+    const Table& schema() const { return table; }
+
+    // Appends rows in order; stops at the first row that cannot be written.
+    // Returns how many rows were written.
+    size_t append(const std::vector<Row>& rows);
+
+private:
+    struct IndexTarget {
+        BPlusTree tree;
+        int column;
+    };
+
+    Table table;
+    std::unique_ptr<HeapFile> heap;
+    std::unique_ptr<ColumnStore> columns;
+    ZoneMap zones;
+    std::vector<IndexTarget> indexes;
+    std::string record;
+    std::string key;
+};
+
+} // namespace spl
+
+#endif // SPL_TABLEWRITER_H
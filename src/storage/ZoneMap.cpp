@@ -0,0 +1,194 @@
+#include "ZoneMap.h"
+#include "BufferPool.h"
+#include "ColumnStore.h"
+#include "HeapFile.h"
+#include "Page.h"
+#include "StorageManager.h"
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string_view>
+
+namespace spl {
+
+namespace fs = std::filesystem;
+
+// Entry layout:
+//   u32 rows
+//   INT column:    i64 min, i64 max
+//   STRING column: u8 minLen, u8 maxLen, u8 maxCut, min[PREFIX_BYTES], max[PREFIX_BYTES]
+namespace {
+
+const size_t INT_BOUNDS = 2 * sizeof(int64_t);
+const size_t STRING_BOUNDS = 3 + 2 * ZoneMap::PREFIX_BYTES;
+
+struct StringBounds {
+    std::string_view min, max;
+    bool maxCut;
+};
+
+StringBounds readStringBounds(const char* at) {
+    const char* prefixes = at + 3;
+    return {std::string_view(prefixes, static_cast<uint8_t>(at[0])),
+            std::string_view(prefixes + ZoneMap::PREFIX_BYTES, static_cast<uint8_t>(at[1])), at[2] != 0};
+}
+
+} // namespace
+
+ZoneMap::ZoneMap(const Table& schema) : schema(schema), path("db/" + schema.name + ".zone") {
+    entrySize = sizeof(uint32_t);
+    for (const auto& col : schema.columns) {
+        offsets.push_back(entrySize);
+        entrySize += isIntType(col.type) ? INT_BOUNDS : STRING_BOUNDS;
+    }
+    // Tables too wide for one entry per page simply go without a map
+    entriesPerPage = PAGE_SIZE / entrySize;
+}
+
+bool ZoneMap::create() {
+    BufferPool::instance().discardFile(path);
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    return file.is_open();
+}
+
+bool ZoneMap::remove() {
+    BufferPool::instance().discardFile(path);
+    return fs::remove(path);
+}
+
+uint64_t ZoneMap::blockOf(const Table& schema, uint64_t rid) {
+    if (schema.format == TableFormat::COLUMNAR) return rid / ColumnStore::ROWS_PER_BLOCK;
+    return ridPage(rid);
+}
+
+uint64_t ZoneMap::tableBlocks() const {
+    if (schema.format == TableFormat::COLUMNAR) {
+        uint64_t rows = ColumnStore(schema).rowCount();
+        return (rows + ColumnStore::ROWS_PER_BLOCK - 1) / ColumnStore::ROWS_PER_BLOCK;
+    }
+    return HeapFile("db/" + schema.name + ".tbl").pageCount();
+}
+
+bool ZoneMap::add(uint64_t block, const Row& row) {
+    if (entriesPerPage == 0) return true;
+    if (row.values.size() != schema.columns.size()) return false;
+
+    BufferPool& pool = BufferPool::instance();
+    uint32_t pageNo = static_cast<uint32_t>(block / entriesPerPage);
+    while (pool.pageCount(path) <= pageNo) {
+        uint32_t created;
+        if (!pool.newPage(path, created)) return false; // zeroed: empty entries
+        pool.unpinPage(path, created, true);
+    }
+    PageGuard guard(path, pageNo);
+    if (!guard.valid()) return false;
+    char* entry = guard.data() + (block % entriesPerPage) * entrySize;
+
+    uint32_t rows;
+    std::memcpy(&rows, entry, sizeof(rows));
+    bool first = rows == 0;
+    for (size_t c = 0; c < schema.columns.size(); ++c) {
+        char* at = entry + offsets[c];
+        if (isIntType(schema.columns[c].type)) {
+            if (!row.values[c].isInt()) return false;
+            int64_t v = row.values[c].asInt(), min, max;
+            std::memcpy(&min, at, sizeof(min));
+            std::memcpy(&max, at + sizeof(min), sizeof(max));
+            if (first || v < min) std::memcpy(at, &v, sizeof(v));
+            if (first || v > max) std::memcpy(at + sizeof(min), &v, sizeof(v));
+            continue;
+        }
+
+        // Cutting is monotonic, so the bounds of the prefixes are the prefixes of the bounds
+        if (!row.values[c].isString()) return false;
+        std::string_view value(row.values[c].asString());
+        std::string_view prefix = value.substr(0, PREFIX_BYTES);
+        bool cut = value.size() > PREFIX_BYTES;
+        StringBounds bounds = readStringBounds(at);
+        if (first || prefix < bounds.min) {
+            at[0] = static_cast<char>(prefix.size());
+            std::memcpy(at + 3, prefix.data(), prefix.size());
+        }
+        if (first || prefix > bounds.max) {
+            at[1] = static_cast<char>(prefix.size());
+            at[2] = cut;
+            std::memcpy(at + 3 + PREFIX_BYTES, prefix.data(), prefix.size());
+        } else if (cut && prefix == bounds.max) {
+            at[2] = 1;
+        }
+    }
+    rows++;
+    std::memcpy(entry, &rows, sizeof(rows));
+    guard.markDirty();
+    return true;
+}
+
+bool ZoneMap::rebuild(uint64_t first) {
+    if (entriesPerPage == 0) return first > 0 || create();
+    if (first == 0) {
+        if (!create()) return false;
+    } else {
+        // Clear the entries being recomputed, including any past the table's end
+        BufferPool& pool = BufferPool::instance();
+        uint32_t pages = pool.pageCount(path);
+        for (uint32_t p = static_cast<uint32_t>(first / entriesPerPage); p < pages; ++p) {
+            PageGuard guard(path, p);
+            if (!guard.valid()) return false;
+            size_t from = p == first / entriesPerPage ? first % entriesPerPage : 0;
+            std::memset(guard.data() + from * entrySize, 0, PAGE_SIZE - from * entrySize);
+            guard.markDirty();
+        }
+    }
+
+    auto cursor = StorageManager::openCursor(schema);
+    cursor->setBlockFilter([first](uint64_t block) { return block >= first; });
+    Row row;
+    while (cursor->next(row)) {
+        if (!add(blockOf(schema, cursor->currentRid()), row)) return false;
+    }
+    return BufferPool::instance().flushFile(path);
+}
+
+bool ZoneMap::mayMatch(uint64_t block, const ZonePredicate& pred) const {
+    if (entriesPerPage == 0 || pred.column < 0 || pred.column >= static_cast<int>(schema.columns.size())) {
+        return true;
+    }
+    uint32_t pageNo = static_cast<uint32_t>(block / entriesPerPage);
+    if (pageNo >= BufferPool::instance().pageCount(path)) return true;
+    PageGuard guard(path, pageNo);
+    if (!guard.valid()) return true;
+    const char* entry = guard.data() + (block % entriesPerPage) * entrySize;
+
+    uint32_t rows;
+    std::memcpy(&rows, entry, sizeof(rows));
+    if (rows == 0) return false;
+    const char* at = entry + offsets[pred.column];
+    const std::string& op = pred.op;
+
+    if (isIntType(schema.columns[pred.column].type)) {
+        int64_t v, min, max;
+        if (!parseInt64(pred.value, v)) return true;
+        std::memcpy(&min, at, sizeof(min));
+        std::memcpy(&max, at + sizeof(min), sizeof(max));
+        if (op == "=") return min <= v && v <= max;
+        if (op == "<") return min < v;
+        if (op == "<=") return min <= v;
+        if (op == ">") return max > v;
+        if (op == ">=") return max >= v;
+        return true;
+    }
+
+    // A cut max only says the largest value starts with that prefix
+    std::string_view v(pred.value);
+    StringBounds bounds = readStringBounds(at);
+    bool allBelow = bounds.maxCut ? v > bounds.max && v.substr(0, bounds.max.size()) != bounds.max
+                                  : bounds.max < v;
+    if (op == "=") return v >= bounds.min && !allBelow;
+    if (op == "<") return bounds.min < v;
+    if (op == "<=") return bounds.min <= v;
+    if (op == ">") return bounds.maxCut ? !allBelow : bounds.max > v;
+    if (op == ">=") return !allBelow;
+    return true;
+}
+
+} // namespace spl
@@ -0,0 +1,64 @@
+#ifndef SPL_ZONEMAP_H
+#define SPL_ZONEMAP_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "StorageStructs.h"
+
+namespace spl {
+
+// A "column op value" comparison that blocks can be tested against. For INT
+// columns `value` is a plain decimal integer.
+struct ZonePredicate {
+    int column = -1;
+    std::string op; // =, <, >, <=, >=
+    std::string value;
+};
+
+// Per-block summaries of a table (db/<table>.zone), so scans can skip blocks
+// that cannot hold a row matching the WHERE. A block is one heap page, or
+// ColumnStore::ROWS_PER_BLOCK rows of a columnar table.
+//
+// Each entry holds the number of rows added to the block and, per column, its
+// smallest and largest value. STRING bounds keep the first PREFIX_BYTES bytes
+// plus a flag telling whether the largest value was cut.
+//
+// Entries only ever widen: updates and deletes leave old bounds in place until
+// a rewrite (VACUUM) rebuilds the map. The file is not logged; like indexes,
+// maps are rebuilt for the tables that recovery replayed.
+class ZoneMap {
+public:
+    explicit ZoneMap(const Table& schema);
+
+    bool create();
+    bool remove();
+    const std::string& filePath() const { return path; }
+
+    // Block holding the row with id `rid` (see TableCursor::currentRid).
+    static uint64_t blockOf(const Table& schema, uint64_t rid);
+    // Number of blocks the table's data currently spans.
+    uint64_t tableBlocks() const;
+
+    // Widens the entry of `block` to cover `row`.
+    bool add(uint64_t block, const Row& row);
+    // Recomputes the entries of blocks >= first from the stored rows.
+    bool rebuild(uint64_t first = 0);
+    // False only when no row of the block can satisfy `pred`. Blocks the map
+    // does not cover are assumed to match.
+    bool mayMatch(uint64_t block, const ZonePredicate& pred) const;
+
+    static constexpr size_t PREFIX_BYTES = 16;
+
+private:
+    Table schema;
+    std::string path;
+    std::vector<size_t> offsets; // of each column's bounds within an entry
+    size_t entrySize;
+    size_t entriesPerPage;
+};
+
+} // namespace spl
+
+#endif // SPL_ZONEMAP_H
@@ -0,0 +1,39 @@
+#include "HyperLogLog.h"
+#include <cmath>
+#include <functional>
+
+namespace spl {
+
+void HyperLogLog::add(const std::string& value) {
+	addHash(mix(std::hash<std::string>()(value)));
+}
+
+void HyperLogLog::addHash(uint64_t hash) {
+	size_t index = hash >> (64 - PRECISION);
+	uint64_t rest = hash << PRECISION;
+	// Position of the first set bit of the remaining 64 - PRECISION bits
+	uint8_t rank = 1;
+	while (rank <= 64 - PRECISION && !(rest & (uint64_t(1) << 63))) {
+		rest <<= 1;
+		rank++;
+	}
+	if (rank > registers[index]) registers[index] = rank;
+}
+
+double HyperLogLog::estimate() const {
+	double m = static_cast<double>(registers.size());
+	double sum = 0;
+	size_t empty = 0;
+	for (uint8_t r : registers) {
+		sum += std::ldexp(1.0, -r);
+		if (r == 0) empty++;
+	}
+	double alpha = 0.7213 / (1 + 1.079 / m);
+	double raw = alpha * m * m / sum;
+	if (raw <= 2.5 * m && empty > 0) {
+		return m * std::log(m / static_cast<double>(empty));
+	}
+	return raw;
+}
+
+} // namespace spl
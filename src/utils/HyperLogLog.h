@@ -0,0 +1,42 @@
+#ifndef SPL_HYPERLOGLOG_H
+#define SPL_HYPERLOGLOG_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace spl {
+
+// Estimates how many distinct values a stream holds in 2^PRECISION bytes,
+// whatever its length: each value's hash picks a register by its top bits,
+// which keeps the longest run of leading zeros seen in the rest. The error
+// is about 1.04 / sqrt(2^PRECISION), under 1% here. Small counts use linear
+// counting over the empty registers instead.
+class HyperLogLog {
+public:
+	static constexpr int PRECISION = 14;
+
+	HyperLogLog() : registers(size_t(1) << PRECISION, 0) {}
+
+	void add(int64_t value) { addHash(mix(static_cast<uint64_t>(value))); }
+	void add(const std::string& value);
+	void addHash(uint64_t hash);
+	double estimate() const;
+
+	// A 64-bit finalizer (splitmix64), so nearby INTs land on unrelated registers.
+	static uint64_t mix(uint64_t x) {
+		x ^= x >> 30;
+		x *= 0xbf58476d1ce4e5b9ULL;
+		x ^= x >> 27;
+		x *= 0x94d049bb133111ebULL;
+		return x ^ (x >> 31);
+	}
+
+private:
+	std::vector<uint8_t> registers;
+};
+
+} // namespace spl
+
+#endif // SPL_HYPERLOGLOG_H
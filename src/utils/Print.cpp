@@ -9,6 +9,11 @@ void printHelp()
     std::cout << "  .exit            Exit the database\n";
     std::cout << "  .tables          List all tables\n";
     std::cout << "  .schema <table>  Show schema for a table\n";
+    std::cout << "  .set <name> <v>  Change a setting (buffer_pool_mb, fsync, group_commit_ms,\n";
+    std::cout << "                   checkpoint_mb, vacuum_threshold, sort_memory_mb,\n";
+    std::cout << "                   join_memory_mb, agg_memory_mb, result_cache_mb,\n";
+    std::cout << "                   workers, simd)\n";
+    std::cout << "  .bufferpool      Show buffer pool statistics\n";
 }
 
 void printPrompt(){
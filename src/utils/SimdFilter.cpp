@@ -0,0 +1,132 @@
+#include "SimdFilter.h"
+#include <atomic>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define SPL_HAVE_AVX2 1
+#include <immintrin.h>
+#endif
+
+namespace spl {
+
+namespace {
+
+template <CompareOp Op>
+inline bool holds(int64_t v, int64_t literal) {
+	switch (Op) {
+	case CompareOp::EQ: return v == literal;
+	case CompareOp::NE: return v != literal;
+	case CompareOp::LT: return v < literal;
+	case CompareOp::LE: return v <= literal;
+	case CompareOp::GT: return v > literal;
+	case CompareOp::GE: return v >= literal;
+	}
+	return false;
+}
+
+// Branch free: each comparison becomes a bit of the mask
+template <CompareOp Op>
+void narrowScalar(const int64_t* values, size_t n, int64_t literal, uint64_t* bits) {
+	for (size_t w = 0; w * 64 < n; ++w) {
+		size_t count = n - w * 64 < 64 ? n - w * 64 : 64;
+		const int64_t* v = values + w * 64;
+		uint64_t mask = 0;
+		for (size_t j = 0; j < count; ++j) {
+			mask |= static_cast<uint64_t>(holds<Op>(v[j], literal)) << j;
+		}
+		bits[w] &= mask;
+	}
+}
+
+#ifdef SPL_HAVE_AVX2
+// Four values per compare. AVX2 only has == and > on int64, so the other
+// operators swap operands and/or invert the result.
+template <CompareOp Op>
+__attribute__((target("avx2"))) void narrowAvx2(const int64_t* values, size_t n, int64_t literal, uint64_t* bits) {
+	const __m256i lit = _mm256_set1_epi64x(literal);
+	const bool invert = Op == CompareOp::NE || Op == CompareOp::LE || Op == CompareOp::GE;
+	size_t full = n / 64;
+	for (size_t w = 0; w < full; ++w) {
+		const int64_t* v = values + w * 64;
+		uint64_t mask = 0;
+		for (size_t j = 0; j < 64; j += 4) {
+			__m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(v + j));
+			__m256i cmp;
+			if (Op == CompareOp::EQ || Op == CompareOp::NE) cmp = _mm256_cmpeq_epi64(x, lit);
+			else if (Op == CompareOp::GT || Op == CompareOp::LE) cmp = _mm256_cmpgt_epi64(x, lit);
+			else cmp = _mm256_cmpgt_epi64(lit, x);
+			mask |= static_cast<uint64_t>(_mm256_movemask_pd(_mm256_castsi256_pd(cmp))) << j;
+		}
+		bits[w] &= invert ? ~mask : mask;
+	}
+	if (n > full * 64) {
+		narrowScalar<Op>(values + full * 64, n - full * 64, literal, bits + full);
+	}
+}
+
+bool cpuHasAvx2() {
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("avx2");
+}
+#endif
+
+using Kernel = void (*)(const int64_t*, size_t, int64_t, uint64_t*);
+
+struct KernelSet {
+	const char* name;
+	Kernel ops[6]; // indexed by CompareOp
+};
+
+const KernelSet SCALAR = {"scalar",
+						  {narrowScalar<CompareOp::EQ>, narrowScalar<CompareOp::NE>, narrowScalar<CompareOp::LT>,
+						   narrowScalar<CompareOp::LE>, narrowScalar<CompareOp::GT>, narrowScalar<CompareOp::GE>}};
+#ifdef SPL_HAVE_AVX2
+const KernelSet AVX2 = {"avx2",
+						{narrowAvx2<CompareOp::EQ>, narrowAvx2<CompareOp::NE>, narrowAvx2<CompareOp::LT>,
+						 narrowAvx2<CompareOp::LE>, narrowAvx2<CompareOp::GT>, narrowAvx2<CompareOp::GE>}};
+#endif
+
+const KernelSet* bestKernels() {
+#ifdef SPL_HAVE_AVX2
+	static const bool avx2 = cpuHasAvx2();
+	if (avx2) return &AVX2;
+#endif
+	return &SCALAR;
+}
+
+std::atomic<const KernelSet*> active{bestKernels()};
+
+} // namespace
+
+void SimdFilter::narrow(const int64_t* values, size_t n, CompareOp op, int64_t literal, uint64_t* bits) {
+	active.load(std::memory_order_relaxed)->ops[static_cast<int>(op)](values, n, literal, bits);
+}
+
+size_t SimdFilter::select(const uint64_t* bits, size_t n, uint32_t* positions) {
+	size_t count = 0;
+	for (size_t w = 0; w < words(n); ++w) {
+		uint64_t word = bits[w];
+		if (w == n / 64) word &= (uint64_t(1) << (n % 64)) - 1; // partial last word
+		while (word) {
+#if defined(__GNUC__)
+			uint32_t bit = static_cast<uint32_t>(__builtin_ctzll(word));
+#else
+			uint32_t bit = 0;
+			while (!(word >> bit & 1)) bit++;
+#endif
+			positions[count++] = static_cast<uint32_t>(w * 64 + bit);
+			word &= word - 1;
+		}
+	}
+	return count;
+}
+
+const char* SimdFilter::setEnabled(bool enabled) {
+	active = enabled ? bestKernels() : &SCALAR;
+	return kernelName();
+}
+
+const char* SimdFilter::kernelName() {
+	return active.load()->name;
+}
+
+} // namespace spl
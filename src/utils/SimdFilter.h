@@ -0,0 +1,35 @@
+#ifndef SPL_SIMDFILTER_H
+#define SPL_SIMDFILTER_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace spl {
+
+enum class CompareOp { EQ, NE, LT, LE, GT, GE };
+
+// Comparison kernels over packed int64 columns. Results are selection
+// bitmaps: bit i of word i / 64 stands for value i. The AVX2 versions are
+// picked at startup when the CPU has it; otherwise (or with
+// `.set simd off`) portable scalar loops run instead.
+class SimdFilter {
+public:
+	SimdFilter() = default;
+
+	// Clears the bits of the values where `value op literal` does not hold,
+	// so several calls on one bitmap build a conjunction.
+	static void narrow(const int64_t* values, size_t n, CompareOp op, int64_t literal, uint64_t* bits);
+	// Writes the positions of the set bits among the first n, in order, and
+	// returns how many there are.
+	static size_t select(const uint64_t* bits, size_t n, uint32_t* positions);
+
+	static size_t words(size_t n) { return (n + 63) / 64; }
+
+	// Allows or forbids the vector kernels; returns the name of the kernels now in use.
+	static const char* setEnabled(bool enabled);
+	static const char* kernelName();
+};
+
+} // namespace spl
+
+#endif // SPL_SIMDFILTER_H
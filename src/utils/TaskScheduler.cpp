@@ -0,0 +1,238 @@
+#include "TaskScheduler.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+
+namespace spl {
+
+namespace {
+
+thread_local TaskScheduler* currentScheduler = nullptr;
+thread_local size_t currentIndex = TaskScheduler::NOT_A_WORKER;
+
+} // namespace
+
+// Chase-Lev work-stealing deque. Only the owning worker pushes and pops, at
+// the bottom; other workers steal from the top. The two ends only contend
+// for the last task, which a CAS on `top` settles. A full ring is copied into
+// one twice its size; old rings stay alive, as a thief may still read one.
+class TaskScheduler::WorkDeque {
+public:
+	WorkDeque() {
+		rings.push_back(std::make_unique<Ring>(64));
+		ring.store(rings.back().get());
+	}
+
+	void push(Job* job) {
+		int64_t b = bottom.load(std::memory_order_relaxed);
+		int64_t t = top.load(std::memory_order_acquire);
+		Ring* r = ring.load(std::memory_order_relaxed);
+		if (b - t >= static_cast<int64_t>(r->size)) r = grow(r, t, b);
+		r->put(b, job);
+		bottom.store(b + 1, std::memory_order_seq_cst);
+	}
+
+	Job* pop() {
+		int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+		Ring* r = ring.load(std::memory_order_relaxed);
+		bottom.store(b, std::memory_order_seq_cst);
+		int64_t t = top.load(std::memory_order_seq_cst);
+		if (t > b) {
+			bottom.store(b + 1, std::memory_order_relaxed);
+			return nullptr;
+		}
+		Job* job = r->get(b);
+		if (t == b) {
+			// The last task: a thief may be taking it too
+			if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+				job = nullptr;
+			}
+			bottom.store(b + 1, std::memory_order_relaxed);
+		}
+		return job;
+	}
+
+	Job* steal() {
+		int64_t t = top.load(std::memory_order_seq_cst);
+		int64_t b = bottom.load(std::memory_order_seq_cst);
+		if (t >= b) return nullptr;
+		Ring* r = ring.load(std::memory_order_acquire);
+		Job* job = r->get(t);
+		if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+			return nullptr;
+		}
+		return job;
+	}
+
+private:
+	struct Ring {
+		explicit Ring(size_t size) : size(size), cells(new std::atomic<Job*>[size]) {}
+		Job* get(int64_t i) const { return cells[static_cast<size_t>(i) & (size - 1)].load(std::memory_order_relaxed); }
+		void put(int64_t i, Job* job) { cells[static_cast<size_t>(i) & (size - 1)].store(job, std::memory_order_relaxed); }
+
+		size_t size;
+		std::unique_ptr<std::atomic<Job*>[]> cells;
+	};
+
+	Ring* grow(Ring* old, int64_t t, int64_t b) {
+		rings.push_back(std::make_unique<Ring>(old->size * 2));
+		Ring* bigger = rings.back().get();
+		for (int64_t i = t; i < b; ++i) bigger->put(i, old->get(i));
+		ring.store(bigger, std::memory_order_release);
+		return bigger;
+	}
+
+	std::atomic<int64_t> top{0};
+	std::atomic<int64_t> bottom{0};
+	std::atomic<Ring*> ring{nullptr};
+	std::vector<std::unique_ptr<Ring>> rings; // owner only
+};
+
+struct TaskScheduler::Worker {
+	WorkDeque deque;
+	std::thread thread;
+};
+
+TaskScheduler& TaskScheduler::instance() {
+	static TaskScheduler scheduler;
+	return scheduler;
+}
+
+TaskScheduler::TaskScheduler() : count(std::max<size_t>(1, std::thread::hardware_concurrency())) {}
+
+TaskScheduler::~TaskScheduler() {
+	stop();
+}
+
+void TaskScheduler::setWorkers(size_t workers) {
+	stop();
+	count = std::max<size_t>(1, workers);
+}
+
+size_t TaskScheduler::currentWorker() {
+	return currentIndex;
+}
+
+void TaskScheduler::start() {
+	started = true;
+	stopping = false;
+	for (size_t i = 0; i < count; ++i) pool.push_back(std::make_unique<Worker>());
+	for (size_t i = 0; i < count; ++i) pool[i]->thread = std::thread(&TaskScheduler::runWorker, this, i);
+}
+
+void TaskScheduler::stop() {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		if (!started) return;
+		stopping = true;
+	}
+	wake.notify_all();
+	for (auto& worker : pool) worker->thread.join();
+	pool.clear();
+	started = false;
+}
+
+void TaskScheduler::submit(Job* job) {
+	// Counted first, so that whoever takes the job finds it counted
+	queued++;
+	if (currentScheduler == this) {
+		pool[currentIndex]->deque.push(job);
+	} else {
+		std::lock_guard<std::mutex> lock(mutex);
+		if (!started) start();
+		injected.push_back(job);
+		injectedCount++;
+	}
+	// Pairs with runWorker, which counts itself as sleeping before it checks `queued`
+	if (sleeping > 0) {
+		std::lock_guard<std::mutex> lock(mutex);
+		wake.notify_one();
+	}
+}
+
+bool TaskScheduler::runOne() {
+	if (queued == 0) return false;
+	size_t self = currentIndex;
+	Job* job = pool[self]->deque.pop();
+	if (!job && injectedCount > 0) {
+		std::lock_guard<std::mutex> lock(mutex);
+		if (!injected.empty()) {
+			job = injected.front();
+			injected.pop_front();
+			injectedCount--;
+		}
+	}
+	for (size_t i = 1; !job && i < pool.size(); ++i) {
+		job = pool[(self + i) % pool.size()]->deque.steal();
+	}
+	if (!job) return false;
+	queued--;
+
+	std::exception_ptr error;
+	try {
+		job->run();
+	} catch (...) {
+		error = std::current_exception();
+	}
+	TaskGroup* group = job->group;
+	delete job;
+	group->finish(error);
+	return true;
+}
+
+void TaskScheduler::runWorker(size_t index) {
+	currentScheduler = this;
+	currentIndex = index;
+	for (;;) {
+		if (runOne()) continue;
+		std::unique_lock<std::mutex> lock(mutex);
+		sleeping++;
+		wake.wait(lock, [&] { return stopping || queued > 0; });
+		sleeping--;
+		if (stopping && queued == 0) break;
+	}
+	currentScheduler = nullptr;
+	currentIndex = NOT_A_WORKER;
+}
+
+TaskGroup::~TaskGroup() {
+	try {
+		wait();
+	} catch (...) {
+	}
+}
+
+void TaskGroup::run(std::function<void()> task) {
+	unfinished++;
+	scheduler.submit(new TaskScheduler::Job{std::move(task), this});
+}
+
+void TaskGroup::wait(size_t limit) {
+	bool worker = currentScheduler == &scheduler;
+	while (unfinished > limit) {
+		if (worker && scheduler.runOne()) continue;
+		std::unique_lock<std::mutex> lock(mutex);
+		if (worker) {
+			// Others hold the group's tasks; look for new work now and then
+			done.wait_for(lock, std::chrono::milliseconds(1), [&] { return unfinished <= limit; });
+		} else {
+			done.wait(lock, [&] { return unfinished <= limit; });
+		}
+	}
+	std::lock_guard<std::mutex> lock(mutex);
+	if (error) {
+		std::exception_ptr thrown = error;
+		error = nullptr;
+		std::rethrow_exception(thrown);
+	}
+}
+
+void TaskGroup::finish(std::exception_ptr thrown) {
+	std::lock_guard<std::mutex> lock(mutex);
+	if (thrown && !error) error = thrown;
+	unfinished--;
+	done.notify_all();
+}
+
+} // namespace spl
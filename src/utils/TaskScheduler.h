@@ -0,0 +1,99 @@
+#ifndef SPL_TASKSCHEDULER_H
+#define SPL_TASKSCHEDULER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace spl {
+
+class TaskGroup;
+
+// The one worker pool of the process, for operators, the bulk loader and
+// anything else that splits work across cores. Each worker has a lock-free
+// deque (Chase-Lev): tasks a worker submits go to the bottom of its own
+// deque and are popped from there, idle workers steal from the top of the
+// others'. Tasks from other threads go through a shared queue. Threads start
+// on the first submit, one per core unless `.set workers <n>` says otherwise.
+class TaskScheduler {
+public:
+	static constexpr size_t NOT_A_WORKER = static_cast<size_t>(-1);
+
+	static TaskScheduler& instance();
+	~TaskScheduler();
+
+	// Restarts the pool with `count` workers; only call while no tasks run.
+	void setWorkers(size_t count);
+	size_t workers() const { return count; }
+	// Index of the calling worker in [0, workers()), or NOT_A_WORKER for
+	// threads outside the pool. Tasks only ever run on workers, so a task
+	// can use it to pick per-worker state.
+	static size_t currentWorker();
+
+private:
+	struct Job {
+		std::function<void()> run;
+		TaskGroup* group;
+	};
+	class WorkDeque;
+	struct Worker;
+
+	friend class TaskGroup;
+
+	TaskScheduler();
+	void submit(Job* job);
+	// Runs one queued task on the calling worker; false if none was found.
+	bool runOne();
+	void runWorker(size_t index);
+	// Starts the threads; called with `mutex` held.
+	void start();
+	void stop();
+
+	size_t count;
+	std::vector<std::unique_ptr<Worker>> pool;
+	std::mutex mutex;
+	std::condition_variable wake;
+	std::deque<Job*> injected; // from threads outside the pool
+	std::atomic<size_t> injectedCount{0};
+	std::atomic<size_t> queued{0};   // submitted, not yet taken
+	std::atomic<size_t> sleeping{0};
+	bool started = false;
+	bool stopping = false;
+};
+
+// Tasks that are waited for together. The destructor waits for all of them.
+// A task that throws has its exception rethrown by wait().
+class TaskGroup {
+public:
+	explicit TaskGroup(TaskScheduler& scheduler = TaskScheduler::instance()) : scheduler(scheduler) {}
+	~TaskGroup();
+	TaskGroup(const TaskGroup&) = delete;
+	TaskGroup& operator=(const TaskGroup&) = delete;
+
+	void run(std::function<void()> task);
+	// Returns once at most `limit` of the group's tasks are unfinished, so a
+	// producer can bound how far it runs ahead. Called on a worker, runs
+	// queued tasks meanwhile instead of blocking it.
+	void wait(size_t limit = 0);
+	size_t pending() const { return unfinished; }
+
+private:
+	friend class TaskScheduler;
+	void finish(std::exception_ptr error);
+
+	TaskScheduler& scheduler;
+	std::atomic<size_t> unfinished{0};
+	std::mutex mutex;
+	std::condition_variable done;
+	std::exception_ptr error;
+};
+
+} // namespace spl
+
+#endif // SPL_TASKSCHEDULER_H
@@ -1,8 +1,19 @@
 #include "Validators.h"
+#include <cctype>
 
 namespace spl {
 
-// stub 
-
+bool Validators::isInteger(const std::string& s) {
+	if (s.empty()) return false;
+	size_t start = 0;
+	if (s[0] == '-' || s[0] == '+') {
+		if (s.size() == 1) return false;
+		start = 1;
+	}
+	for (size_t i = start; i < s.size(); ++i) {
+		if (!std::isdigit(static_cast<unsigned char>(s[i]))) return false;
+	}
+	return true;
+}
 
 } // namespace spl
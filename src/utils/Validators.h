@@ -9,6 +9,8 @@ class Validators {
 public:
 	Validators() = default;
 
+	// Optional sign followed by digits only.
+	static bool isInteger(const std::string& s);
 };
 
 } // namespace spl
@@ -0,0 +1,202 @@
+// Build and run from the repository root:
+//   g++ -std=c++17 -pthread -I src -I tests tests/StorageEngineTest.cpp <every src/*.cpp but src/main.cpp>
+#include "StorageEngineTest.h"
+#include "parser/SQLParser.h"
+#include "parser/Tokenizer.h"
+#include "query/QueryExecutor.h"
+#include "storage/BufferPool.h"
+#include "storage/Catalog.h"
+#include "storage/LogManager.h"
+#include "storage/Page.h"
+#include "storage/StorageManager.h"
+#include <chrono>
+#include <condition_variable>
+#include <filesystem>
+#include <iostream>
+#include <mutex>
+#include <set>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace spl {
+
+namespace fs = std::filesystem;
+
+namespace {
+
+int failures = 0;
+
+void check(bool ok, const std::string& what) {
+    std::cout << (ok ? "PASS " : "FAIL ") << what << "\n";
+    if (!ok) failures++;
+}
+
+// Runs one statement the way the REPL does and returns what it printed.
+std::string exec(const std::string& sql) {
+    std::ostringstream out;
+    std::streambuf* saved = std::cout.rdbuf(out.rdbuf());
+    try {
+        Tokenizer tokenizer(sql);
+        SQLParser parser(tokenizer);
+        QueryExecutor executor;
+        executor.execute(parser.parse());
+    } catch (const std::exception& e) {
+        out << "Error: " << e.what() << "\n";
+    }
+    std::cout.rdbuf(saved);
+    return out.str();
+}
+
+uint64_t liveRows(const std::string& table) {
+    uint64_t live = 0, dead = 0;
+    StorageManager::rowCounts(table, live, dead);
+    return live;
+}
+
+std::set<int64_t> ids(const std::string& table) {
+    std::set<int64_t> found;
+    auto cursor = StorageManager::openCursor(StorageManager::getTableSchema(table));
+    Row row;
+    while (cursor->next(row)) found.insert(row.values[0].asInt());
+    return found;
+}
+
+void testOversizedInsertWritesNothing() {
+    exec("CREATE TABLE big (id INT, s STRING);");
+    exec("INSERT INTO big (id, s) VALUES (1, 'a'), (2, 'b');");
+    std::string huge(PAGE_SIZE, 'x');
+    std::string out = exec("INSERT INTO big (id, s) VALUES (3, 'c'), (4, 'd'), (5, '" + huge + "');");
+    check(out.find("Error") != std::string::npos, "INSERT with an oversized last tuple fails");
+    check(liveRows("big") == 2, "INSERT with an oversized last tuple leaves the row count unchanged");
+    check(ids("big") == std::set<int64_t>{1, 2}, "INSERT with an oversized last tuple writes no rows");
+}
+
+void testFailedAppendRollsBack() {
+    exec("CREATE TABLE roll (id INT, s STRING);");
+    exec("CREATE INDEX roll_id ON roll (id);");
+    // Committed, but only in the log and the pool when the next write fails
+    exec("INSERT INTO roll (id, s) VALUES (1, 'a'), (2, 'b');");
+
+    Row ok, tooLarge;
+    ok.values = {Value(int64_t(3)), Value(std::string("c"))};
+    tooLarge.values = {Value(int64_t(4)), Value(std::string(PAGE_SIZE, 'x'))};
+    StorageManager::beginTransaction();
+    bool appended = StorageManager::appendRows("roll", {ok, tooLarge});
+    StorageManager::abortTransaction();
+    check(!appended, "append stops at a record larger than a page");
+    check(liveRows("roll") == 2, "rollback restores the row count");
+    check(ids("roll") == std::set<int64_t>{1, 2}, "rollback keeps committed rows and drops the rest");
+    check(exec("SELECT id FROM roll WHERE id = 3;").find("3") == std::string::npos,
+          "rollback removes the index entry of a dropped row");
+
+    exec("INSERT INTO roll (id, s) VALUES (3, 'c');");
+    check(ids("roll") == std::set<int64_t>{1, 2, 3}, "the table takes writes after a rollback");
+}
+
+void testGroupCommitBatches() {
+    LogManager& log = LogManager::instance();
+    log.setFsyncPolicy(FsyncPolicy::GROUP);
+    log.setGroupCommitWindow(50);
+    exec("CREATE TABLE grp (id INT);");
+
+    // Nobody else is committing, so each commit syncs at once
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < 20; ++i) exec("INSERT INTO grp (id) VALUES (" + std::to_string(i) + ");");
+    check(std::chrono::steady_clock::now() - start < std::chrono::milliseconds(500),
+          "a lone GROUP commit does not wait out the window");
+
+    // Commits that are all appended before any of them waits share one fsync
+    const int committers = 8;
+    uint64_t before = log.syncCount();
+    std::mutex mutex;
+    std::condition_variable allAppended;
+    int appended = 0;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < committers; ++t) {
+        threads.emplace_back([&, t] {
+            uint64_t lsn;
+            {
+                std::lock_guard<std::mutex> statement(StorageManager::statementLock());
+                Row row;
+                row.values = {Value(int64_t(100 + t))};
+                StorageManager::beginTransaction();
+                StorageManager::appendRows("grp", {row});
+                lsn = log.appendCommit();
+            }
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                appended++;
+                allAppended.notify_all();
+                allAppended.wait(lock, [&] { return appended == committers; });
+            }
+            log.syncTo(lsn);
+        });
+    }
+    for (auto& thread : threads) thread.join();
+    uint64_t synced = log.syncCount() - before;
+    check(synced >= 1 && synced < committers, "GROUP commits queued together share an fsync");
+    check(ids("grp").size() == 20 + committers, "every commit of a group is applied");
+    log.setFsyncPolicy(FsyncPolicy::ALWAYS);
+}
+
+void testGrownPoolShrinks() {
+    BufferPool& pool = BufferPool::instance();
+    size_t saved = pool.capacity();
+    pool.setCapacity(16);
+    exec("CREATE TABLE wide (id INT, s STRING);");
+
+    // Each transaction dirties about 40 pages, more than the pool holds
+    std::vector<Row> rows;
+    for (int i = 0; i < 120; ++i) {
+        Row row;
+        row.values = {Value(int64_t(i)), Value(std::string(1200, 'w'))};
+        rows.push_back(row);
+    }
+    StorageManager::beginTransaction();
+    bool appended = StorageManager::appendRows("wide", rows);
+    bool grew = pool.residentPages() > pool.capacity();
+    StorageManager::commitTransaction();
+    check(appended && grew, "a transaction larger than the pool grows it");
+    check(pool.residentPages() <= pool.capacity(), "the pool shrinks back to its capacity after commit");
+    check(liveRows("wide") == 120, "pages written back by the shrink keep their rows");
+
+    StorageManager::beginTransaction();
+    StorageManager::appendRows("wide", rows);
+    StorageManager::abortTransaction();
+    check(pool.residentPages() <= pool.capacity(), "the pool shrinks back to its capacity after rollback");
+    check(liveRows("wide") == 120, "the rolled back rows are gone");
+    pool.setCapacity(saved);
+}
+
+} // namespace
+
+int runStorageEngineTests() {
+    failures = 0;
+    fs::path dir = fs::temp_directory_path() / "featherdb_storage_test";
+    fs::remove_all(dir);
+    fs::create_directories(dir);
+    fs::path previous = fs::current_path();
+    fs::current_path(dir);
+
+    Catalog::instance().load();
+    StorageManager::recover();
+    testOversizedInsertWritesNothing();
+    testFailedAppendRollsBack();
+    testGroupCommitBatches();
+    testGrownPoolShrinks();
+    StorageManager::shutdown();
+
+    fs::current_path(previous);
+    fs::remove_all(dir);
+    return failures;
+}
+
+} // namespace spl
+
+int main() {
+    int failed = spl::runStorageEngineTests();
+    std::cout << (failed == 0 ? "All storage engine tests passed.\n" : "Storage engine tests failed.\n");
+    return failed == 0 ? 0 : 1;
+}
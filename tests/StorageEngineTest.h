@@ -0,0 +1,12 @@
+#ifndef SPL_STORAGEENGINETEST_H
+#define SPL_STORAGEENGINETEST_H
+
+namespace spl {
+
+// Storage engine checks, run against a scratch database in the system temp
+// directory. Returns the number of failed checks.
+int runStorageEngineTests();
+
+} // namespace spl
+
+#endif // SPL_STORAGEENGINETEST_H